@@ -0,0 +1,104 @@
+/*
+	Buffer pool benchmark.
+	Runs connection cycles (connect, request, response, disconnect) through loopback
+	transport, every tenth response with header property big enough to grow DataBuffer.
+	Compares heap calls and time per cycle without pool, with pool and with arena pool.
+*/
+#include <HttpBufferPool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+///////////////////////////////////////////////////////////////////////////////
+#define CYCLE_COUNT						200000
+#define LONG_HEADER_INTERVAL			10
+#define ARENA_SIZE						(16 * 1024)
+
+///////////////////////////////////////////////////////////////////////////////
+static const char _request[] = "GET / HTTP/1.1\r\nHost: loopback\r\n\r\n";
+static unsigned long _heapCalls = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+static double _Now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void* _CountingAlloc(size_t size) {
+	_heapCalls++;
+	return malloc(size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void _CountingFree(void* memory) {
+	_heapCalls++;
+	free(memory);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function runs all cycles once.
+// Returns: Non-zero value if any response was not received.
+static int _RunCase(const char* name, HttpBufferPool* pool, const char* shortScript, const char* longScript) {
+	HttpContext ctx;
+	HttpLoopback loopback;
+	char body[64];
+	double start = 0;
+	double elapsed = 0;
+	int failed = 0;
+	int i = 0;
+
+	_heapCalls = 0;
+	memset(&ctx, 0, sizeof(ctx));
+	_HttpSetBufferPool(&ctx, pool);
+	start = _Now();
+	for (i = 0; i < CYCLE_COUNT; i++) {
+		const char* script = ((i % LONG_HEADER_INTERVAL) == 0 ? longScript : shortScript);
+
+		_HttpLoopbackInit(&loopback, script, strlen(script), NULL, 0);
+		_HttpSetTransport(&ctx, _HttpGetLoopbackTransport(), &loopback);
+		if (_HttpConnect("loopback", 80, 0, &ctx) != 0 ||
+			_HttpSend(_request, sizeof(_request) - 1, &ctx) != 0 ||
+			_HttpRecv(body, sizeof(body), &ctx) != 2 ||
+			!_HttpIsResponseConsumed(&ctx))
+			failed = 1;
+		_HttpDisconnect(&ctx, 1);
+	}
+	elapsed = _Now() - start;
+	printf("%-16s %8.1f ns/cycle %10lu heap calls", name, elapsed / CYCLE_COUNT * 1e9, _heapCalls);
+	if (pool)
+		printf(" %8lu hits %4lu misses %4lu carves %4lu dropped %6lu peak in use %6lu peak cached",
+			pool->Stats.Hits, pool->Stats.Misses, pool->Stats.ArenaCarves, pool->Stats.Dropped,
+			pool->Stats.PeakInUse, pool->Stats.PeakCached);
+	printf(" %s\n", (failed ? "FAILED" : "ok"));
+	return failed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	static char arena[ARENA_SIZE];
+	static char longScript[4096];
+	static const char shortScript[] = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+	HttpBufferPool pool;
+	size_t length = 0;
+	int failed = 0;
+
+	length = sprintf(longScript, "HTTP/1.1 200 OK\r\nSet-Cookie: ");
+	memset(longScript + length, 'c', 1500);
+	length += 1500;
+	strcpy(longScript + length, "\r\nContent-Length: 2\r\n\r\nok");
+
+	_HttpSetMemoryInterface(_CountingAlloc, _CountingFree);
+	printf("Cycles: %d\n", CYCLE_COUNT);
+	failed |= _RunCase("no pool", NULL, shortScript, longScript);
+	_HttpBufferPoolInit(&pool, NULL, 0);
+	failed |= _RunCase("pool", &pool, shortScript, longScript);
+	_HttpBufferPoolDestroy(&pool);
+	_HttpBufferPoolInit(&pool, arena, sizeof(arena));
+	failed |= _RunCase("arena pool", &pool, shortScript, longScript);
+	_HttpBufferPoolDestroy(&pool);
+	return failed;
+}
@@ -0,0 +1,224 @@
+/*
+	Response cache benchmark.
+	Polls the same 32 KiB resource from server (forked child process) on 127.0.0.1
+	which answers If-None-Match with 304. Three runs over one keep-alive connection:
+	1) no cache (full body every time),
+	2) cache, resource sent with 'no-cache' (every request revalidated, 304),
+	3) cache, resource sent with max-age (fresh hits, nothing sent).
+	Reports time and bytes received per request.
+	Also checks (loopback transport) that request without room for all validators
+	is sent unconditional and its 200 response replaces stale entry.
+*/
+#include <HttpCache.h>
+#include <HttpStats.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+///////////////////////////////////////////////////////////////////////////////
+#define BODY_SIZE						(32 * 1024)
+#define REQUESTS						2000
+#define STORE_SIZE						(256 * 1024)
+
+///////////////////////////////////////////////////////////////////////////////
+static double _Now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function serves connections one after another until killed.
+// Path '/fresh' is sent with max-age, other paths with no-cache.
+static void _Serve(int listener) {
+	// Header and body go in single send (no Nagle delay between them).
+	static char response[256 + BODY_SIZE];
+	char header[256];
+	char buffer[2048];
+	size_t filled = 0;
+	ssize_t result = 0;
+	int headerLength = 0;
+	int client = -1;
+
+	while ((client = accept(listener, NULL, NULL)) >= 0) {
+		filled = 0;
+		while ((result = recv(client, buffer + filled, sizeof(buffer) - 1 - filled, 0)) > 0) {
+			filled += (size_t)result;
+			buffer[filled] = '\0';
+			// Requests are not pipelined, whole request is in buffer.
+			if (strstr(buffer, "\r\n\r\n") == NULL)
+				continue;
+			filled = 0;
+			if (strstr(buffer, "If-None-Match: \"v1\"") != NULL) {
+				headerLength = sprintf(header, "HTTP/1.1 304 Not Modified\r\nETag: \"v1\"\r\n\r\n");
+				send(client, header, headerLength, 0);
+				continue;
+			}
+			headerLength = sprintf(
+				header,
+				"HTTP/1.1 200 OK\r\nContent-Length: %d\r\nETag: \"v1\"\r\nCache-Control: %s\r\n\r\n",
+				BODY_SIZE, (strncmp(buffer, "GET /fresh ", 11) == 0 ? "max-age=3600" : "no-cache")
+			);
+			memcpy(response, header, headerLength);
+			memset(response + headerLength, 'c', BODY_SIZE);
+			send(client, response, headerLength + BODY_SIZE, 0);
+		}
+		close(client);
+	}
+	_exit(0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function polls resource REQUESTS times.
+// Returns: Non-zero value on error.
+static int _Run(const char* name, HttpContext* ctx, HttpCache* cache, const char* path) {
+	static char buffer[16384];
+	char request[256];
+	HttpRequestBuilder builder;
+	HttpStats stats;
+	size_t received = 0;
+	size_t total = 0;
+	double start = 0;
+	int result = 0;
+	int i = 0;
+
+	_HttpStatsInit(&stats, NULL);
+	_HttpSetStats(ctx, &stats);
+	start = _Now();
+	for (i = 0; i < REQUESTS && result == 0; i++) {
+		_HttpBuilderInit(&builder, request, sizeof(request), GET, path, HTTP_11);
+		_HttpBuilderSetProperty(&builder, "Host", "127.0.0.1");
+		total = 0;
+		if (cache == NULL) {
+			result = _HttpBuilderComplete(&builder);
+			result = (result < 0 ? result : _HttpSend(request, result, ctx));
+			while (result == 0 && !_HttpIsResponseConsumed(ctx)) {
+				result = _HttpRecvLarge(ctx, buffer, sizeof(buffer), &received);
+				total += received;
+			}
+		}
+		else {
+			result = _HttpCacheSend(cache, ctx, &builder);
+			while (result == 0 && !_HttpCacheIsResponseConsumed(cache, ctx)) {
+				result = _HttpCacheRecv(cache, ctx, buffer, sizeof(buffer), &received);
+				total += received;
+			}
+		}
+		if (result == 0 && total != BODY_SIZE)
+			result = -1;
+	}
+	start = (_Now() - start) * 1e6 / REQUESTS;
+	_HttpSetStats(ctx, NULL);
+	printf(
+		"%-24s %10.1f %14.1f %10lu\n",
+		name, start, (double)stats.BytesReceived / REQUESTS, stats.SendCalls
+	);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function requests stale resource three times with request buffer having
+// room for If-None-Match, but not for If-Modified-Since.
+// Returns: Non-zero value on error.
+static int _CheckPartialValidators(void) {
+	static const char script[] =
+		"HTTP/1.1 200 OK\r\nContent-Length: 4\r\nETag: \"v2\"\r\n"
+		"Last-Modified: Wed, 21 Oct 2015 07:28:00 GMT\r\nCache-Control: no-cache\r\n\r\nbody";
+	static char store[16 * 1024];
+	char request[256];
+	char sent[256];
+	char buffer[16];
+	HttpContext ctx;
+	HttpLoopback loopback;
+	HttpCache cache;
+	HttpRequestBuilder builder;
+	unsigned int size = 0;
+	size_t received = 0;
+	int result = 0;
+	int entries = 0;
+	int i = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	_HttpLoopbackInit(&loopback, script, sizeof(script) - 1, NULL, 0);
+	loopback.Flags = HTTP_LOOPBACK_REPEAT;
+	loopback.SentBuffer = sent;
+	loopback.SentBufferSize = sizeof(sent) - 1;
+	_HttpSetTransport(&ctx, _HttpGetLoopbackTransport(), &loopback);
+	_HttpConnect("loopback", 80, 0, &ctx);
+	_HttpCacheInit(&cache, store, sizeof(store));
+	// Room for unconditional request and If-None-Match line only.
+	_HttpBuilderInit(&builder, request, sizeof(request), GET, "/stale", HTTP_11);
+	size = (unsigned int)_HttpBuilderComplete(&builder) + 1 + sizeof("If-None-Match: \"v2\"\r\n");
+	for (i = 0; i < 3 && result == 0; i++) {
+		_HttpBuilderInit(&builder, request, size, GET, "/stale", HTTP_11);
+		loopback.SentSize = 0;
+		result = _HttpCacheSend(&cache, &ctx, &builder);
+		while (result == 0 && !_HttpCacheIsResponseConsumed(&cache, &ctx))
+			result = _HttpCacheRecv(&cache, &ctx, buffer, sizeof(buffer), &received);
+		sent[loopback.SentSize < sizeof(sent) ? loopback.SentSize : sizeof(sent) - 1] = '\0';
+		if (result == 0 && (cache.Result != HTTP_CACHE_MISS || strstr(sent, "If-None-Match") != NULL))
+			result = -1;
+	}
+	for (i = 0; i < HTTP_CACHE_MAX_ENTRIES; i++)
+		entries += (cache.Store->Entries[i].Hash != 0);
+	_HttpDisconnect(&ctx, 1);
+	return (result != 0 || entries != 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	static char store[STORE_SIZE];
+	struct sockaddr_in address;
+	socklen_t addressSize = sizeof(address);
+	HttpContext ctx;
+	HttpCache cache;
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	int failed = 0;
+	pid_t server = 0;
+
+	signal(SIGPIPE, SIG_IGN);
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 4) != 0)
+		return 1;
+	getsockname(listener, (struct sockaddr*)&address, &addressSize);
+	server = fork();
+	if (server == 0)
+		_Serve(listener);
+	close(listener);
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.ConnectTimeout = 5;
+	ctx.RecvTimeout = 5;
+	_HttpCacheInit(&cache, store, sizeof(store));
+	printf("%d requests for %d B resource on 127.0.0.1:\n", REQUESTS, BODY_SIZE);
+	printf("%-24s %10s %14s %10s\n", "", "us/request", "received/req", "sends");
+	if (_HttpConnect("127.0.0.1", ntohs(address.sin_port), 0, &ctx) != 0)
+		failed = 1;
+	failed = failed || _Run("no cache", &ctx, NULL, "/config");
+	failed = failed || _Run("cache, revalidated", &ctx, &cache, "/config");
+	failed = failed || _Run("cache, max-age", &ctx, &cache, "/fresh");
+	if (!failed)
+		printf("hits %lu, revalidated %lu, misses %lu, stored %lu\n", cache.Stats.Hits, cache.Stats.Revalidated, cache.Stats.Misses, cache.Stats.Stored);
+	_HttpDisconnect(&ctx, 1);
+	kill(server, SIGKILL);
+	waitpid(server, NULL, 0);
+	if (failed || cache.Stats.Hits != REQUESTS - 1 || cache.Stats.Revalidated != REQUESTS - 1)
+		failed = 1;
+	if (_CheckPartialValidators() != 0) {
+		fprintf(stderr, "Request with partial validators was not handled.\n");
+		failed = 1;
+	}
+	if (failed)
+		fprintf(stderr, "Benchmark failed.\n");
+	return failed;
+}
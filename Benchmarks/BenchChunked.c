@@ -0,0 +1,116 @@
+/*
+	Chunked decoder benchmark.
+	Replays chunked responses through loopback transport and reports decoded
+	payload bytes per second for chunk sizes from 1 B to 64 KiB, received
+	with _HttpRecv (copied to caller's buffer) and _HttpRecvToSink (in place).
+*/
+#include <HttpLib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+///////////////////////////////////////////////////////////////////////////////
+#define BODY_SIZE						(1024 * 1024)
+#define CALLER_BUFFER_SIZE				4096
+#define MIN_BENCH_TIME					0.5
+
+///////////////////////////////////////////////////////////////////////////////
+static double _Now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function builds chunked response into newly allocated script.
+// Returns: script (size stored under last argument).
+static char* _BuildResponse(size_t chunkSize, size_t* scriptLength) {
+	size_t chunkCount = BODY_SIZE / chunkSize;
+	// Size line (at most 5 hex digits), CRLF behind payload.
+	char* script = malloc(256 + chunkCount * (chunkSize + 9));
+	size_t length = 0;
+	size_t i = 0;
+
+	length += sprintf(script, "HTTP/1.1 200 OK\r\nServer: bench\r\nTransfer-Encoding: chunked\r\n\r\n");
+	for (i = 0; i < chunkCount; i++) {
+		length += sprintf(script + length, "%zx\r\n", chunkSize);
+		memset(script + length, 'a', chunkSize);
+		length += chunkSize;
+		script[length++] = '\r';
+		script[length++] = '\n';
+	}
+	length += sprintf(script + length, "0\r\n\r\n");
+	*scriptLength = length;
+	return script;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This sink only counts body bytes.
+static int _CountingSink(HttpContext* ctx, const char* data, unsigned int size, void* sinkData) {
+	(void)ctx;
+	(void)data;
+	*(size_t*)sinkData += size;
+	return HTTP_SINK_CONTINUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function receives responses for at least MIN_BENCH_TIME.
+// Returns: decoded bytes per second.
+static double _RunCase(const char* script, size_t scriptLength, const size_t* segments, size_t segmentCount, int useSink) {
+	static char buffer[CALLER_BUFFER_SIZE];
+	HttpContext ctx;
+	HttpLoopback loopback;
+	double start = 0;
+	double elapsed = 0;
+	size_t total = 0;
+	int received = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	_HttpLoopbackInit(&loopback, script, scriptLength, segments, segmentCount);
+	_HttpSetTransport(&ctx, _HttpGetLoopbackTransport(), &loopback);
+	_HttpConnect("loopback", 80, 0, &ctx);
+	start = _Now();
+	do {
+		_HttpSend("GET / HTTP/1.1\r\n\r\n", 18, &ctx);
+		// Replay response for every request.
+		_HttpLoopbackRewind(&loopback);
+		if (useSink)
+			_HttpRecvToSink(&ctx, _CountingSink, &total);
+		else {
+			while ((received = _HttpRecv(buffer, sizeof(buffer), &ctx)) > 0)
+				total += received;
+		}
+		if (ctx.Flags & ENDING_CHUNK_REQUIRED) {
+			fprintf(stderr, "Chunked body not received completely.\n");
+			exit(1);
+		}
+		elapsed = _Now() - start;
+	} while (elapsed < MIN_BENCH_TIME);
+	_HttpDisconnect(&ctx, 1);
+	return total / elapsed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	// Typical TCP segment.
+	static const size_t segments[] = { 1460 };
+	size_t scriptLength = 0;
+	size_t chunkSize = 0;
+	char* script = NULL;
+
+	printf("%-10s %16s %16s %16s\n", "chunk", "MB/s (1460 seg)", "MB/s (no seg)", "MB/s (sink)");
+	for (chunkSize = 1; chunkSize <= 64 * 1024; chunkSize *= 4) {
+		script = _BuildResponse(chunkSize, &scriptLength);
+		printf(
+			"%-10zu %16.1f %16.1f %16.1f\n",
+			chunkSize,
+			_RunCase(script, scriptLength, segments, 1, 0) / 1e6,
+			_RunCase(script, scriptLength, NULL, 0, 0) / 1e6,
+			_RunCase(script, scriptLength, segments, 1, 1) / 1e6
+		);
+		free(script);
+	}
+	return 0;
+}
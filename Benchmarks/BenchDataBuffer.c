@@ -0,0 +1,172 @@
+/*
+	DataBuffer benchmark.
+	Replays responses through loopback transport and reports how many bytes
+	were moved inside DataBuffer per response, for different caller buffer sizes.
+	Also checks that response header property looked up before body is received
+	(skipped, passed to sink, received with _HttpRecvLarge) stays valid after it,
+	memory released by context is overwritten to show dangling pointers.
+*/
+#include <HttpLib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+#define RESPONSES_PER_CASE				1000
+#define BODY_SIZE						4096
+#define CHUNK_SIZE						256
+#define ETAG							"\"view-check-etag\""
+
+///////////////////////////////////////////////////////////////////////////////
+// This function builds response with given transfer type into script buffer.
+// Returns: script length.
+static size_t _BuildResponse(char* script, int chunked) {
+	size_t length = 0;
+	int i = 0;
+
+	length += sprintf(script, "HTTP/1.1 200 OK\r\nServer: bench\r\nContent-Type: text/plain\r\nETag: %s\r\n", ETAG);
+	for (i = 0; i < 8; i++)
+		length += sprintf(script + length, "X-Header-%d: %s\r\n", i, "some-fairly-typical-header-value");
+	if (!chunked) {
+		length += sprintf(script + length, "Content-Length: %d\r\n\r\n", BODY_SIZE);
+		memset(script + length, 'a', BODY_SIZE);
+		length += BODY_SIZE;
+	}
+	else {
+		length += sprintf(script + length, "Transfer-Encoding: chunked\r\n\r\n");
+		for (i = 0; i < BODY_SIZE / CHUNK_SIZE; i++) {
+			length += sprintf(script + length, "%x\r\n", CHUNK_SIZE);
+			memset(script + length, 'a', CHUNK_SIZE);
+			length += CHUNK_SIZE;
+			length += sprintf(script + length, "\r\n");
+		}
+		length += sprintf(script + length, "0\r\n\r\n");
+	}
+	return length;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function receives RESPONSES_PER_CASE responses and returns bytes moved per response.
+static double _RunCase(const char* script, size_t scriptLength, const size_t* segments, size_t segmentCount, int bufferSize) {
+	HttpContext ctx;
+	HttpLoopback loopback;
+	char* buffer = malloc(bufferSize);
+	int received = 0;
+	int total = 0;
+	int i = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	_HttpLoopbackInit(&loopback, script, scriptLength, segments, segmentCount);
+	_HttpSetTransport(&ctx, _HttpGetLoopbackTransport(), &loopback);
+	_HttpConnect("loopback", 80, 0, &ctx);
+	for (i = 0; i < RESPONSES_PER_CASE; i++) {
+		_HttpSend("GET / HTTP/1.1\r\n\r\n", 18, &ctx);
+		// Replay response for every request.
+		_HttpLoopbackRewind(&loopback);
+		for (total = 0; total < BODY_SIZE; total += received) {
+			received = _HttpRecv(buffer, bufferSize, &ctx);
+			if (received <= 0) {
+				fprintf(stderr, "Receive failed after %d bytes.\n", total);
+				exit(1);
+			}
+		}
+	}
+	_HttpDisconnect(&ctx, 1);
+	free(buffer);
+	return (double)ctx.BufferStats.BytesMoved / RESPONSES_PER_CASE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Context allocator storing block size in front of block, so released memory can be overwritten.
+static void* _CheckAlloc(size_t size) {
+	size_t* block = malloc(sizeof(size_t) + size);
+
+	if (block == NULL)
+		return NULL;
+	*block = size;
+	return block + 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void _CheckFree(void* memory) {
+	size_t* block = (size_t*)memory - 1;
+
+	memset(memory, 0xDD, *block);
+	free(block);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _DropSink(HttpContext* ctx, const char* data, unsigned int size, void* sinkData) {
+	(void)ctx;
+	(void)data;
+	*(size_t*)sinkData += size;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function looks up ETag, receives rest of body (0 - skip, 1 - sink, 2 - _HttpRecvLarge)
+// and compares value afterwards.
+// Returns: Non-zero value on error.
+static int _CheckHeaderView(const char* script, size_t scriptLength, int mode) {
+	static char body[BODY_SIZE];
+	HttpContext ctx;
+	HttpLoopback loopback;
+	const char* value = NULL;
+	unsigned int length = 0;
+	size_t received = 0;
+	int result = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	_HttpSetContextMemoryInterface(&ctx, _CheckAlloc, _CheckFree);
+	_HttpLoopbackInit(&loopback, script, scriptLength, NULL, 0);
+	_HttpSetTransport(&ctx, _HttpGetLoopbackTransport(), &loopback);
+	_HttpConnect("loopback", 80, 0, &ctx);
+	_HttpSend("GET / HTTP/1.1\r\n\r\n", 18, &ctx);
+	// First body byte brings header in.
+	if (_HttpRecv(body, 1, &ctx) != 1 || _HttpGetResponseHeader(&ctx, "ETag", &value, &length) != 0)
+		result = -1;
+	else if (mode == 0)
+		result = _HttpSkipBody(&ctx, BODY_SIZE);
+	else if (mode == 1)
+		result = _HttpRecvToSink(&ctx, _DropSink, &received);
+	else
+		result = _HttpRecvLarge(&ctx, body, sizeof(body), &received);
+	if (result == 0 && (length != sizeof(ETAG) - 1 || memcmp(value, ETAG, length) != 0))
+		result = -1;
+	_HttpDisconnect(&ctx, 1);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	static char script[BODY_SIZE * 2];
+	static const int bufferSizes[] = { 1, 16, 64, 256, 1024, 4096 };
+	// Typical small TCP segments.
+	static const size_t segments[] = { 536 };
+	size_t scriptLength = 0;
+	int chunked = 0;
+	int segmented = 0;
+	int failed = 0;
+	int mode = 0;
+	unsigned int i = 0;
+
+	printf("%-8s %-10s %8s %16s\n", "transfer", "segments", "buffer", "moved/response");
+	for (chunked = 0; chunked <= 1; chunked++) {
+		scriptLength = _BuildResponse(script, chunked);
+		for (segmented = 0; segmented <= 1; segmented++)
+			for (i = 0; i < sizeof(bufferSizes) / sizeof(bufferSizes[0]); i++)
+				printf(
+					"%-8s %-10s %8d %16.1f\n",
+					(chunked ? "chunked" : "plain"),
+					(segmented ? "536" : "none"),
+					bufferSizes[i],
+					_RunCase(script, scriptLength, (segmented ? segments : NULL), 1, bufferSizes[i])
+				);
+		for (mode = 0; mode < 3; mode++)
+			if (_CheckHeaderView(script, scriptLength, mode) != 0) {
+				fprintf(stderr, "Header property not valid after body (%s, mode %d).\n", (chunked ? "chunked" : "plain"), mode);
+				failed = 1;
+			}
+	}
+	return failed;
+}
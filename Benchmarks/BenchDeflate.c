@@ -0,0 +1,229 @@
+/*
+	Request compression benchmark.
+	Sends JSON-like and log-like bodies through loopback transport with
+	_HttpSendCompressed (several levels) and with compressed chunked upload
+	(1 KiB writes). Captured request is decoded back (chunked framing and gzip)
+	and checked. Reports compression ratio, compression MB/s and bodies sent
+	uncompressed because of minimum size.
+*/
+#include <HttpDeflate.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef HTTPLIB_ZLIB
+#include <zlib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+#define PAYLOAD_SIZE					(1024 * 1024)
+#define SENT_BUFFER_SIZE				(2 * PAYLOAD_SIZE)
+#define REQUEST_BUFFER_SIZE				512
+#define WRITE_SIZE						1024
+#define SMALL_BODY_SIZE					200
+#define ROUNDS							10
+
+///////////////////////////////////////////////////////////////////////////////
+typedef enum BenchPayload {
+	PAYLOAD_JSON,
+	PAYLOAD_LOG
+} BenchPayload;
+
+///////////////////////////////////////////////////////////////////////////////
+static const char _response[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+
+///////////////////////////////////////////////////////////////////////////////
+static double _Now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function fills buffer with JSON records or log lines.
+static void _MakePayload(char* payload, size_t size, BenchPayload type) {
+	size_t length = 0;
+	unsigned long id = 0;
+	int written = 0;
+
+	while (length < size) {
+		if (type == PAYLOAD_JSON)
+			written = snprintf(payload + length, size - length,
+				"{\"id\":%lu,\"terminal\":\"T%06lu\",\"amount\":%lu.%02lu,\"currency\":\"EUR\",\"status\":\"%s\"},\n",
+				id, id % 5000, (id * 7919) % 10000, id % 100, ((id % 3) ? "approved" : "declined"));
+		else
+			written = snprintf(payload + length, size - length,
+				"2026-10-%02lu %02lu:%02lu:%02lu.%03lu [%s] txn=%08lx reader=%lu latency=%lums\n",
+				id % 28 + 1, (id / 3600) % 24, (id / 60) % 60, id % 60, (id * 37) % 1000,
+				((id % 7) ? "INFO" : "WARN"), id * 2654435761ul, id % 4, (id * 13) % 900);
+		if (written <= 0 || (size_t)written >= size - length)
+			break;
+		length += written;
+		id++;
+	}
+	memset(payload + length, ' ', size - length);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function decodes captured request body (chunked or with Content-Length) and
+// compares it with payload.
+// Returns: Non-zero value on mismatch.
+static int _CheckRequest(const char* sent, size_t sentSize, const char* payload, size_t payloadSize, int compressed) {
+	static char body[SENT_BUFFER_SIZE];
+	static char decoded[PAYLOAD_SIZE];
+	const char* header = NULL;
+	const char* position = NULL;
+	const char* end = sent + sentSize;
+	unsigned long piece = 0;
+	size_t bodySize = 0;
+	uLongf decodedSize = sizeof(decoded);
+	z_stream stream;
+	int result = 0;
+
+	header = strstr(sent, "\r\n\r\n");
+	if (header == NULL)
+		return 1;
+	position = header + 4;
+	if (compressed != (strstr(sent, "Content-Encoding: gzip\r\n") != NULL && strstr(sent, "Content-Encoding: gzip\r\n") < header))
+		return 1;
+	if (strstr(sent, "Transfer-Encoding: chunked\r\n") != NULL && strstr(sent, "Transfer-Encoding: chunked\r\n") < header) {
+		do {
+			piece = strtoul(position, (char**)&position, 16);
+			position += 2;
+			if (position + piece + 2 > end)
+				return 1;
+			memcpy(body + bodySize, position, piece);
+			bodySize += piece;
+			position += piece + 2;
+		} while (piece > 0);
+	}
+	else {
+		bodySize = (size_t)(end - position);
+		memcpy(body, position, bodySize);
+	}
+	if (!compressed)
+		return (bodySize != payloadSize || memcmp(body, payload, payloadSize) != 0);
+	memset(&stream, 0, sizeof(stream));
+	inflateInit2(&stream, 15 + 16);
+	stream.next_in = (Bytef*)body;
+	stream.avail_in = (uInt)bodySize;
+	stream.next_out = (Bytef*)decoded;
+	stream.avail_out = (uInt)decodedSize;
+	result = inflate(&stream, Z_FINISH);
+	decodedSize = stream.total_out;
+	inflateEnd(&stream);
+	return (result != Z_STREAM_END || decodedSize != payloadSize || memcmp(decoded, payload, payloadSize) != 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function sends payload ROUNDS times and checks last request.
+// Returns: Non-zero value on error.
+static int _RunCase(const char* name, const char* payload, size_t payloadSize, int level, int streaming) {
+	static char sent[SENT_BUFFER_SIZE];
+	static char requestBuffer[REQUEST_BUFFER_SIZE];
+	HttpContext ctx;
+	HttpLoopback loopback;
+	HttpDeflater deflater;
+	HttpRequestBuilder builder;
+	char response[16];
+	size_t received = 0;
+	size_t offset = 0;
+	unsigned short status = 0;
+	double start = 0;
+	double elapsed = 0;
+	int failed = 0;
+	int result = 0;
+	int round = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	if (_HttpDeflaterInit(&deflater, level, HTTP_DEFLATE_MIN_SIZE) != 0)
+		return 1;
+	_HttpSetDeflater(&ctx, &deflater);
+	start = _Now();
+	for (round = 0; round < ROUNDS; round++) {
+		_HttpLoopbackInit(&loopback, _response, sizeof(_response) - 1, NULL, 0);
+		loopback.SentBuffer = sent;
+		loopback.SentBufferSize = sizeof(sent) - 1;
+		_HttpSetTransport(&ctx, _HttpGetLoopbackTransport(), &loopback);
+		_HttpConnect("loopback", 80, 0, &ctx);
+		_HttpBuilderInit(&builder, requestBuffer, sizeof(requestBuffer), POST, "/upload", HTTP_11);
+		_HttpBuilderSetProperty(&builder, "Host", "loopback");
+		_HttpBuilderSetProperty(&builder, "Content-Type", "application/octet-stream");
+		if (!streaming)
+			result = _HttpSendCompressed(&ctx, &builder, payload, payloadSize);
+		else {
+			result = _HttpBeginCompressedUpload(&ctx, &builder);
+			for (offset = 0; result == 0 && offset < payloadSize; offset += WRITE_SIZE)
+				result = _HttpWriteCompressed(&ctx, payload + offset, (payloadSize - offset > WRITE_SIZE ? WRITE_SIZE : payloadSize - offset));
+			if (result == 0)
+				result = _HttpEndCompressedUpload(&ctx, NULL, 0);
+		}
+		if (result == 0)
+			result = _HttpRecvLarge(&ctx, response, sizeof(response), &received);
+		if (result == 0)
+			result = _HttpGetResponseStatus(&ctx, &status, NULL, NULL, NULL);
+		if (result != 0 || status != 200)
+			failed = 1;
+		_HttpDisconnect(&ctx, 1);
+	}
+	elapsed = _Now() - start;
+	if (!failed && loopback.SentSize < sizeof(sent) - 1) {
+		sent[loopback.SentSize] = '\0';
+		failed = _CheckRequest(sent, loopback.SentSize, payload, payloadSize, (payloadSize >= deflater.MinSize));
+	}
+	else
+		failed = 1;
+	printf(
+		"%-28s %7lu B -> %7lu B %6.2fx %8.1f MB/s, skipped %lu %s\n",
+		name,
+		(unsigned long)payloadSize,
+		(unsigned long)(deflater.RawBytes > 0 ? deflater.CompressedBytes / ROUNDS : payloadSize),
+		(deflater.CompressedBytes > 0 ? (double)deflater.RawBytes / deflater.CompressedBytes : 1.0),
+		(double)payloadSize * ROUNDS / elapsed / 1e6,
+		deflater.Skipped,
+		(failed ? "FAILED" : "ok")
+	);
+	_HttpSetDeflater(&ctx, NULL);
+	_HttpDeflaterDestroy(&deflater);
+	return failed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	static const char* payloadNames[] = { "json", "log" };
+	static const int levels[] = { 1, HTTP_DEFLATE_LEVEL, 9 };
+	char* payload = malloc(PAYLOAD_SIZE);
+	char name[64];
+	unsigned int i = 0;
+	int type = 0;
+	int failed = 0;
+
+	printf("Payload: %d bytes, %d rounds per case\n", PAYLOAD_SIZE, ROUNDS);
+	for (type = PAYLOAD_JSON; type <= PAYLOAD_LOG; type++) {
+		_MakePayload(payload, PAYLOAD_SIZE, (BenchPayload)type);
+		for (i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+			sprintf(name, "%s, level %d", payloadNames[type], levels[i]);
+			failed |= _RunCase(name, payload, PAYLOAD_SIZE, levels[i], 0);
+		}
+		sprintf(name, "%s, level %d, streamed", payloadNames[type], HTTP_DEFLATE_LEVEL);
+		failed |= _RunCase(name, payload, PAYLOAD_SIZE, HTTP_DEFLATE_LEVEL, 1);
+		// Compressed body fits in single window (sent with Content-Length).
+		sprintf(name, "%s, 3000 B", payloadNames[type]);
+		failed |= _RunCase(name, payload, 3000, HTTP_DEFLATE_LEVEL, 0);
+		sprintf(name, "%s, %d B (below minimum)", payloadNames[type], SMALL_BODY_SIZE);
+		failed |= _RunCase(name, payload, SMALL_BODY_SIZE, HTTP_DEFLATE_LEVEL, 0);
+	}
+	free(payload);
+	return failed;
+}
+
+#else
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	printf("Library built without zlib (ZLIB=0), nothing to measure.\n");
+	return 0;
+}
+
+#endif	// HTTPLIB_ZLIB
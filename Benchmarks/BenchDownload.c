@@ -0,0 +1,217 @@
+/*
+	Range download benchmark.
+	Downloads 16 MiB file from server (forked child process, process per connection)
+	on 127.0.0.1 which sends about 31 MiB/s per connection (like servers and links
+	throttling single streams). Runs:
+	1) single connection,
+	2) single connection cut in the middle, resumed from progress file,
+	3) 4 connections, file written with pwrite,
+	4) 4 connections, file memory-mapped.
+	Reports time, throughput, bytes received and download calls (interrupted download
+	is continued by next call). Output file is checked after every run.
+*/
+#include <HttpDownload.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+///////////////////////////////////////////////////////////////////////////////
+#define FILE_SIZE						(16 * 1024 * 1024)
+#define CONNECTIONS						4
+// Throttling: piece sent every PIECE_INTERVAL microseconds.
+#define PIECE_SIZE						(64 * 1024)
+#define PIECE_INTERVAL					2000
+#define OUTPUT_PATH						"/tmp/BenchDownload.out"
+#define STATE_PATH						"/tmp/BenchDownload.state"
+
+///////////////////////////////////////////////////////////////////////////////
+static char _file[FILE_SIZE];
+
+///////////////////////////////////////////////////////////////////////////////
+static double _Now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function sends body range at throttled rate, connection is dropped at cut offset.
+// Returns: Non-zero value on error.
+static int _SendBody(int client, unsigned long first, unsigned long last, unsigned long cut) {
+	unsigned long size = 0;
+
+	while (first <= last) {
+		size = last + 1 - first;
+		if (size > PIECE_SIZE)
+			size = PIECE_SIZE;
+		if (first >= cut)
+			return -1;
+		if (send(client, _file + first, size, 0) != (ssize_t)size)
+			return -1;
+		first += size;
+		usleep(PIECE_INTERVAL);
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function serves single connection. Path '/cut' drops connection in the
+// middle of file when whole file is asked for.
+static void _ServeConnection(int client) {
+	char header[256];
+	char buffer[2048];
+	const char* range = NULL;
+	char* next = NULL;
+	unsigned long first = 0;
+	unsigned long last = 0;
+	size_t filled = 0;
+	ssize_t result = 0;
+	int headerLength = 0;
+
+	while ((result = recv(client, buffer + filled, sizeof(buffer) - 1 - filled, 0)) > 0) {
+		filled += (size_t)result;
+		buffer[filled] = '\0';
+		if (strstr(buffer, "\r\n\r\n") == NULL)
+			continue;
+		filled = 0;
+		first = 0;
+		last = FILE_SIZE - 1;
+		range = strstr(buffer, "\r\nRange: bytes=");
+		if (range != NULL) {
+			first = strtoul(range + 15, &next, 10);
+			if (next[1] >= '0' && next[1] <= '9')
+				last = strtoul(next + 1, NULL, 10);
+			headerLength = sprintf(
+				header, "HTTP/1.1 206 Partial Content\r\nETag: \"b1\"\r\nContent-Range: bytes %lu-%lu/%d\r\nContent-Length: %lu\r\n\r\n",
+				first, last, FILE_SIZE, last + 1 - first
+			);
+		}
+		else {
+			headerLength = sprintf(header, "HTTP/1.1 200 OK\r\nETag: \"b1\"\r\nContent-Length: %d\r\n\r\n", FILE_SIZE);
+		}
+		send(client, header, headerLength, MSG_MORE);
+		if (_SendBody(client, first, last, (strncmp(buffer, "GET /cut ", 9) == 0 && first == 0 ? FILE_SIZE / 2 : FILE_SIZE)) != 0)
+			break;
+	}
+	close(client);
+	_exit(0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void _Serve(int listener) {
+	int client = -1;
+
+	signal(SIGCHLD, SIG_IGN);
+	while ((client = accept(listener, NULL, NULL)) >= 0) {
+		if (fork() == 0) {
+			close(listener);
+			_ServeConnection(client);
+		}
+		close(client);
+	}
+	_exit(0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Returns: Non-zero value if output file matches served file.
+static int _CheckOutput(void) {
+	static char output[FILE_SIZE + 1];
+	ssize_t size = 0;
+	int file = open(OUTPUT_PATH, O_RDONLY);
+
+	if (file < 0)
+		return 0;
+	size = read(file, output, sizeof(output));
+	close(file);
+	return (size == FILE_SIZE && memcmp(output, _file, FILE_SIZE) == 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function runs single download.
+// Returns: Non-zero value on error.
+static int _Run(const char* name, unsigned short port, const char* path, unsigned int connections, unsigned char mapped) {
+	HttpContext contexts[CONNECTIONS];
+	HttpDownload download;
+	HttpLength_t received = 0;
+	double start = 0;
+	int result = 0;
+	unsigned int i = 0;
+	unsigned int runs = 0;
+
+	memset(contexts, 0, sizeof(contexts));
+	for (i = 0; i < CONNECTIONS; i++) {
+		contexts[i].ConnectTimeout = 5;
+		contexts[i].RecvTimeout = 5;
+	}
+	unlink(OUTPUT_PATH);
+	unlink(STATE_PATH);
+	start = _Now();
+	// Interrupted download is continued by another call (as after restart).
+	do {
+		_HttpDownloadInit(&download, "127.0.0.1", port, 0, path, OUTPUT_PATH, STATE_PATH);
+		download.MaxRetries = 0;
+		download.Mapped = mapped;
+		if (connections == 1)
+			result = _HttpDownloadRun(&download, &contexts[0]);
+		else
+			result = _HttpDownloadRunParallel(&download, contexts, connections);
+		received += download.Received;
+	} while (result != 0 && result != HTTP_DOWNLOAD_ERROR_FILE && result != HTTP_DOWNLOAD_ERROR_RESPONSE && ++runs < 4);
+	start = _Now() - start;
+	for (i = 0; i < CONNECTIONS; i++)
+		_HttpDisconnect(&contexts[i], 1);
+	printf(
+		"%-26s %8.1f %10.1f %13.1f %6u\n",
+		name, start * 1e3, FILE_SIZE / start / (1024 * 1024), (double)received / (1024 * 1024), runs + 1
+	);
+	return (result != 0 || !_CheckOutput());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	struct sockaddr_in address;
+	socklen_t addressSize = sizeof(address);
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	int failed = 0;
+	pid_t server = 0;
+	unsigned short port = 0;
+	int i = 0;
+
+	for (i = 0; i < FILE_SIZE; i++)
+		_file[i] = (char)(i * 7 + i / 4093);
+	signal(SIGPIPE, SIG_IGN);
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 16) != 0)
+		return 1;
+	getsockname(listener, (struct sockaddr*)&address, &addressSize);
+	port = ntohs(address.sin_port);
+	server = fork();
+	if (server == 0)
+		_Serve(listener);
+	close(listener);
+
+	printf("%d MiB file on 127.0.0.1, %.1f MiB/s per connection:\n", FILE_SIZE / (1024 * 1024), PIECE_SIZE * (1e6 / PIECE_INTERVAL) / (1024 * 1024));
+	printf("%-26s %8s %10s %13s %6s\n", "", "ms", "MiB/s", "received MiB", "calls");
+	failed = failed || _Run("1 connection", port, "/file", 1, 0);
+	failed = failed || _Run("1 connection, cut, resumed", port, "/cut", 1, 0);
+	failed = failed || _Run("4 connections, pwrite", port, "/file", CONNECTIONS, 0);
+	failed = failed || _Run("4 connections, mmap", port, "/file", CONNECTIONS, 1);
+	kill(server, SIGKILL);
+	waitpid(server, NULL, 0);
+	unlink(OUTPUT_PATH);
+	unlink(STATE_PATH);
+	if (failed)
+		fprintf(stderr, "Benchmark failed.\n");
+	return failed;
+}
@@ -0,0 +1,273 @@
+/*
+	Event loop benchmark.
+	Runs 10000 concurrent requests on single thread with HttpEpoll against
+	keep-alive server (forked child process) on 127.0.0.1. First round opens
+	all connections, second round reuses them. Reports requests per second.
+	Loopback transport has no descriptors, so real sockets are used here.
+	Also checks (loopback transport, request never waits) that request on
+	connection closed by remote host (Connection: close) opens new connection.
+*/
+#include <HttpEpoll.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+///////////////////////////////////////////////////////////////////////////////
+#define REQUEST_COUNT					10000
+#define ROUND_COUNT						2
+#define SERVER_BUFFER_SIZE				1024
+
+///////////////////////////////////////////////////////////////////////////////
+static const char _request[] = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+static const char _response[] = "HTTP/1.1 200 OK\r\nContent-Length: 13\r\n\r\nHello, world!";
+
+///////////////////////////////////////////////////////////////////////////////
+typedef struct BenchClient {
+	HttpContext Context;
+	HttpAsync Async;
+	size_t BodySize;
+} BenchClient;
+
+///////////////////////////////////////////////////////////////////////////////
+static unsigned long _completed = 0;
+static unsigned long _failed = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+static double _Now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function serves keep-alive connections until killed. Every request
+// (terminated by empty line) gets the same response.
+static void _Serve(int listener) {
+	static char buffers[REQUEST_COUNT + 16][4];
+	struct epoll_event events[256];
+	struct epoll_event event;
+	char buffer[SERVER_BUFFER_SIZE];
+	int loop = epoll_create1(0);
+	int count = 0;
+	int fd = 0;
+	int i = 0;
+	ssize_t received = 0;
+	ssize_t j = 0;
+
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = listener;
+	epoll_ctl(loop, EPOLL_CTL_ADD, listener, &event);
+	while (1) {
+		count = epoll_wait(loop, events, 256, -1);
+		for (i = 0; i < count; i++) {
+			fd = events[i].data.fd;
+			if (fd == listener) {
+				while ((fd = accept(listener, NULL, NULL)) >= 0) {
+					event.events = EPOLLIN;
+					event.data.fd = fd;
+					memset(buffers[fd % (REQUEST_COUNT + 16)], 0, 4);
+					epoll_ctl(loop, EPOLL_CTL_ADD, fd, &event);
+				}
+				continue;
+			}
+			received = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+			if (received <= 0) {
+				if (received < 0 && errno == EAGAIN)
+					continue;
+				close(fd);
+				continue;
+			}
+			// Track last four bytes to find end of each request header.
+			for (j = 0; j < received; j++) {
+				char* tail = buffers[fd % (REQUEST_COUNT + 16)];
+				memmove(tail, tail + 1, 3);
+				tail[3] = buffer[j];
+				if (memcmp(tail, "\r\n\r\n", 4) == 0)
+					send(fd, _response, sizeof(_response) - 1, MSG_NOSIGNAL);
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _CountBody(HttpContext* ctx, const char* data, unsigned int size, void* sinkData) {
+	(void)ctx;
+	(void)data;
+	((BenchClient*)sinkData)->BodySize += size;
+	return HTTP_SINK_CONTINUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void _Done(HttpAsync* async, int result) {
+	BenchClient* client = (BenchClient*)async->UserData;
+	unsigned short status = 0;
+
+	if (result == 0)
+		_HttpGetResponseStatus(&client->Context, &status, NULL, NULL, NULL);
+	if (status == 200 && client->BodySize == sizeof("Hello, world!") - 1)
+		_completed++;
+	else
+		_failed++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function runs all clients once.
+// Returns: Non-zero value if any request failed.
+static int _RunRound(const char* name, HttpEpoll* loop, BenchClient* clients, unsigned short port) {
+	double start = 0;
+	double elapsed = 0;
+	int left = 0;
+	int i = 0;
+
+	_completed = 0;
+	_failed = 0;
+	start = _Now();
+	for (i = 0; i < REQUEST_COUNT; i++) {
+		BenchClient* client = &clients[i];
+
+		client->BodySize = 0;
+		if (_HttpAsyncInit(&client->Async, &client->Context, "127.0.0.1", port, _request, sizeof(_request) - 1) != 0) {
+			_failed++;
+			continue;
+		}
+		client->Async.Sink = _CountBody;
+		client->Async.SinkData = client;
+		client->Async.Done = _Done;
+		client->Async.UserData = client;
+		_HttpEpollStart(loop, &client->Async);
+	}
+	left = _HttpEpollRun(loop, 10000);
+	elapsed = _Now() - start;
+	printf(
+		"%-24s %8lu ok %6lu failed %6d stuck %9.3f s %10.0f req/s\n",
+		name,
+		_completed,
+		_failed,
+		left,
+		elapsed,
+		_completed / elapsed
+	);
+	return (_failed != 0 || left != 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Check transport connect: loopback replaying next script.
+static int _CheckConnect(HttpContext* ctx, const char* url, unsigned short port, unsigned char ssl) {
+	static const char first[] =
+		"HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 3\r\n\r\none"
+		"HTTP/1.1 500 Stale\r\nContent-Length: 3\r\n\r\nbad";
+	static const char second[] = "HTTP/1.1 200 OK\r\nContent-Length: 13\r\n\r\nHello, world!";
+	HttpLoopback* loopback = (HttpLoopback*)ctx->TransportData;
+
+	if (loopback->Script == NULL)
+		_HttpLoopbackInit(loopback, first, sizeof(first) - 1, NULL, 0);
+	else
+		_HttpLoopbackInit(loopback, second, sizeof(second) - 1, NULL, 0);
+	return _HttpGetLoopbackTransport()->Connect(ctx, url, port, ssl);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function receives response with Connection: close, then runs async request
+// on the same context.
+// Returns: Non-zero value on error.
+static int _CheckClosedConnection(void) {
+	HttpTransport transport = *_HttpGetLoopbackTransport();
+	BenchClient client;
+	HttpLoopback loopback;
+	HttpAsync async;
+	char body[16];
+	unsigned short status = 0;
+	int result = 0;
+
+	memset(&client, 0, sizeof(client));
+	memset(&loopback, 0, sizeof(loopback));
+	transport.Connect = _CheckConnect;
+	_HttpSetTransport(&client.Context, &transport, &loopback);
+	if (_HttpConnect("loopback", 80, 0, &client.Context) != 0 || _HttpSend(_request, sizeof(_request) - 1, &client.Context) != 0
+		|| _HttpRecv(body, sizeof(body), &client.Context) != 3 || !_HttpIsResponseConsumed(&client.Context))
+		result = -1;
+	else if (_HttpAsyncInit(&async, &client.Context, "loopback", 80, _request, sizeof(_request) - 1) != 0 || async.State != HTTP_ASYNC_CONNECTING)
+		result = -1;
+	else {
+		async.Sink = _CountBody;
+		async.SinkData = &client;
+		result = _HttpAsyncStep(&async);
+		if (result == HTTP_ASYNC_DONE)
+			result = _HttpGetResponseStatus(&client.Context, &status, NULL, NULL, NULL);
+		if (result == 0 && (status != 200 || client.BodySize != sizeof("Hello, world!") - 1))
+			result = -1;
+	}
+	_HttpDisconnect(&client.Context, 1);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	static BenchClient clients[REQUEST_COUNT];
+	struct sockaddr_in address;
+	socklen_t addressLength = sizeof(address);
+	struct rlimit limit;
+	HttpEpoll loop;
+	pid_t server = 0;
+	int listener = 0;
+	int failed = 0;
+	int i = 0;
+
+	// Both processes hold one descriptor per connection.
+	getrlimit(RLIMIT_NOFILE, &limit);
+	if (limit.rlim_cur < REQUEST_COUNT + 64) {
+		limit.rlim_cur = (limit.rlim_max < REQUEST_COUNT + 64 ? limit.rlim_max : REQUEST_COUNT + 64);
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+	if (limit.rlim_cur < REQUEST_COUNT + 64) {
+		printf("Descriptor limit too low: %lu\n", (unsigned long)limit.rlim_cur);
+		return 1;
+	}
+
+	listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+		listen(listener, 4096) != 0 ||
+		getsockname(listener, (struct sockaddr*)&address, &addressLength) != 0) {
+		printf("Can not create listener: %d\n", errno);
+		return 1;
+	}
+	server = fork();
+	if (server == 0) {
+		_Serve(listener);
+		_exit(0);
+	}
+	close(listener);
+
+	printf("Concurrent requests: %d\n", REQUEST_COUNT);
+	memset(clients, 0, sizeof(clients));
+	_HttpEpollInit(&loop);
+	failed |= _RunRound("new connections", &loop, clients, ntohs(address.sin_port));
+	for (i = 1; i < ROUND_COUNT; i++)
+		failed |= _RunRound("keep-alive", &loop, clients, ntohs(address.sin_port));
+	for (i = 0; i < REQUEST_COUNT; i++)
+		_HttpDisconnect(&clients[i].Context, 1);
+	_HttpEpollDestroy(&loop);
+
+	kill(server, SIGKILL);
+	waitpid(server, NULL, 0);
+	if (_CheckClosedConnection() != 0) {
+		fprintf(stderr, "Request on connection closed by remote host did not reconnect.\n");
+		failed = 1;
+	}
+	return failed;
+}
@@ -0,0 +1,225 @@
+/*
+	Content decoding benchmark.
+	Compresses JSON-like payload (gzip, zlib deflate and raw deflate), replays it
+	through loopback transport with Content-Length and in chunks, with and without
+	1460-byte segmentation, and decodes it with _HttpRecvDecoded and
+	_HttpRecvDecodedToSink. Checks decoded body and reports compression ratio and
+	decoded MB/s.
+*/
+#include <HttpInflate.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef HTTPLIB_ZLIB
+#include <zlib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+#define PAYLOAD_SIZE					(4 * 1024 * 1024)
+#define CHUNK_SIZE						4096
+#define RECV_BUFFER_SIZE				16384
+#define ROUNDS							5
+
+///////////////////////////////////////////////////////////////////////////////
+typedef enum BenchWrapper {
+	WRAPPER_GZIP,
+	WRAPPER_ZLIB,
+	WRAPPER_RAW
+} BenchWrapper;
+
+///////////////////////////////////////////////////////////////////////////////
+typedef struct BenchCheck {
+	const char* Expected;
+	size_t Offset;
+	int Mismatch;
+} BenchCheck;
+
+///////////////////////////////////////////////////////////////////////////////
+static const size_t _tcpSegments[] = { 1460 };
+static const char _request[] = "GET /data.json HTTP/1.1\r\nHost: loopback\r\n\r\n";
+
+///////////////////////////////////////////////////////////////////////////////
+static double _Now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function fills buffer with JSON records.
+static void _MakePayload(char* payload, size_t size) {
+	size_t length = 0;
+	unsigned long id = 0;
+	int written = 0;
+
+	while (length < size) {
+		written = snprintf(payload + length, size - length,
+			"{\"id\":%lu,\"terminal\":\"T%06lu\",\"amount\":%lu.%02lu,\"currency\":\"EUR\",\"status\":\"%s\"},\n",
+			id, id % 5000, (id * 7919) % 10000, id % 100, ((id % 3) ? "approved" : "declined"));
+		if (written <= 0 || (size_t)written >= size - length)
+			break;
+		length += written;
+		id++;
+	}
+	memset(payload + length, ' ', size - length);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function compresses payload.
+// Returns: Compressed size.
+static size_t _Compress(const char* payload, size_t size, char* output, size_t outputSize, BenchWrapper wrapper) {
+	static const int windowBits[] = { 15 + 16, 15, -15 };
+	z_stream stream;
+	size_t compressed = 0;
+
+	memset(&stream, 0, sizeof(stream));
+	deflateInit2(&stream, 6, Z_DEFLATED, windowBits[wrapper], 8, Z_DEFAULT_STRATEGY);
+	stream.next_in = (Bytef*)payload;
+	stream.avail_in = (uInt)size;
+	stream.next_out = (Bytef*)output;
+	stream.avail_out = (uInt)outputSize;
+	deflate(&stream, Z_FINISH);
+	compressed = stream.total_out;
+	deflateEnd(&stream);
+	return compressed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function builds response script with compressed body.
+// Returns: Script size.
+static size_t _MakeScript(char* script, const char* body, size_t bodySize, BenchWrapper wrapper, int chunked) {
+	const char* coding = (wrapper == WRAPPER_GZIP ? "gzip" : "deflate");
+	size_t length = 0;
+	size_t offset = 0;
+	size_t piece = 0;
+
+	if (!chunked) {
+		length = sprintf(script, "HTTP/1.1 200 OK\r\nContent-Encoding: %s\r\nContent-Length: %lu\r\n\r\n", coding, (unsigned long)bodySize);
+		memcpy(script + length, body, bodySize);
+		return length + bodySize;
+	}
+	length = sprintf(script, "HTTP/1.1 200 OK\r\nContent-Encoding: %s\r\nTransfer-Encoding: chunked\r\n\r\n", coding);
+	for (offset = 0; offset < bodySize; offset += piece) {
+		piece = (bodySize - offset > CHUNK_SIZE ? CHUNK_SIZE : bodySize - offset);
+		length += sprintf(script + length, "%lx\r\n", (unsigned long)piece);
+		memcpy(script + length, body + offset, piece);
+		length += piece;
+		memcpy(script + length, "\r\n", 2);
+		length += 2;
+	}
+	memcpy(script + length, "0\r\n\r\n", 5);
+	return length + 5;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _CheckSink(HttpContext* ctx, const char* data, unsigned int size, void* sinkData) {
+	BenchCheck* check = (BenchCheck*)sinkData;
+
+	(void)ctx;
+	if (check->Offset + size > PAYLOAD_SIZE || memcmp(check->Expected + check->Offset, data, size) != 0)
+		check->Mismatch = 1;
+	check->Offset += size;
+	return HTTP_SINK_CONTINUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function decodes script ROUNDS times.
+// Returns: Non-zero value if decoded body differs from payload.
+static int _RunCase(const char* name, const char* payload, const char* script, size_t scriptSize, size_t compressedSize, int segmented, int sink) {
+	static char buffer[RECV_BUFFER_SIZE];
+	static char sent[512];
+	HttpContext ctx;
+	HttpLoopback loopback;
+	HttpInflater inflater;
+	BenchCheck check;
+	size_t received = 0;
+	double start = 0;
+	double elapsed = 0;
+	int failed = 0;
+	int result = 0;
+	int round = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	_HttpInflaterInit(&inflater);
+	_HttpSetInflater(&ctx, &inflater);
+	start = _Now();
+	for (round = 0; round < ROUNDS; round++) {
+		_HttpLoopbackInit(&loopback, script, scriptSize, (segmented ? _tcpSegments : NULL), (segmented ? 1 : 0));
+		loopback.SentBuffer = sent;
+		loopback.SentBufferSize = sizeof(sent) - 1;
+		_HttpSetTransport(&ctx, _HttpGetLoopbackTransport(), &loopback);
+		_HttpConnect("loopback", 80, 0, &ctx);
+		_HttpSend(_request, sizeof(_request) - 1, &ctx);
+		memset(&check, 0, sizeof(check));
+		check.Expected = payload;
+		if (sink)
+			result = _HttpRecvDecodedToSink(&ctx, _CheckSink, &check);
+		else {
+			do {
+				result = _HttpRecvDecoded(&ctx, buffer, sizeof(buffer), &received);
+				_CheckSink(&ctx, buffer, (unsigned int)received, &check);
+			} while (result == 0 && received == sizeof(buffer));
+		}
+		sent[loopback.SentSize < sizeof(sent) ? loopback.SentSize : sizeof(sent) - 1] = '\0';
+		if (result != 0 || check.Mismatch || check.Offset != PAYLOAD_SIZE || !_HttpIsResponseConsumed(&ctx) ||
+			strstr(sent, "Accept-Encoding: gzip, deflate\r\n") == NULL)
+			failed = 1;
+		_HttpDisconnect(&ctx, 1);
+	}
+	elapsed = _Now() - start;
+	printf(
+		"%-36s %6.2fx %10.1f MB/s %s\n",
+		name,
+		(double)PAYLOAD_SIZE / compressedSize,
+		(double)PAYLOAD_SIZE * ROUNDS / elapsed / 1e6,
+		(failed ? "FAILED" : "ok")
+	);
+	_HttpInflaterDestroy(&inflater);
+	return failed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	static const char* wrapperNames[] = { "gzip", "deflate", "raw deflate" };
+	char* payload = malloc(PAYLOAD_SIZE);
+	char* compressed = malloc(PAYLOAD_SIZE);
+	char* script = malloc(2 * PAYLOAD_SIZE);
+	char name[64];
+	size_t compressedSize = 0;
+	size_t scriptSize = 0;
+	int wrapper = 0;
+	int chunked = 0;
+	int segmented = 0;
+	int failed = 0;
+
+	_MakePayload(payload, PAYLOAD_SIZE);
+	printf("Payload: %d bytes, %d rounds per case\n", PAYLOAD_SIZE, ROUNDS);
+	for (wrapper = WRAPPER_GZIP; wrapper <= WRAPPER_RAW; wrapper++) {
+		compressedSize = _Compress(payload, PAYLOAD_SIZE, compressed, PAYLOAD_SIZE, (BenchWrapper)wrapper);
+		for (chunked = 0; chunked <= 1; chunked++) {
+			scriptSize = _MakeScript(script, compressed, compressedSize, (BenchWrapper)wrapper, chunked);
+			for (segmented = 0; segmented <= 1; segmented++) {
+				sprintf(name, "%s, %s%s", wrapperNames[wrapper], (chunked ? "chunked" : "plain"), (segmented ? ", 1460" : ""));
+				failed |= _RunCase(name, payload, script, scriptSize, compressedSize, segmented, 0);
+				strcat(name, ", sink");
+				failed |= _RunCase(name, payload, script, scriptSize, compressedSize, segmented, 1);
+			}
+		}
+	}
+	free(payload);
+	free(compressed);
+	free(script);
+	return failed;
+}
+
+#else
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	printf("Library built without zlib (ZLIB=0), nothing to measure.\n");
+	return 0;
+}
+
+#endif	// HTTPLIB_ZLIB
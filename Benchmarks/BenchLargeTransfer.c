@@ -0,0 +1,121 @@
+/*
+	Large transfer benchmark.
+	Streams response bodies bigger than 4 GiB (Content-Length and single chunk)
+	through loopback transport, checks that every byte arrives and reports
+	throughput and number of transport calls.
+*/
+#include <HttpLib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+///////////////////////////////////////////////////////////////////////////////
+#define BODY_SIZE						(5ull * 1024 * 1024 * 1024)
+#define PATTERN_SIZE					(4 * 1024 * 1024)
+#define LARGE_BUFFER_SIZE				(4 * 1024 * 1024)
+#define SMALL_BUFFER_SIZE				(64 * 1024)
+
+///////////////////////////////////////////////////////////////////////////////
+typedef enum BenchApi {
+	API_RECV,
+	API_RECV_LARGE
+} BenchApi;
+
+///////////////////////////////////////////////////////////////////////////////
+static double _Now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function receives up to given number of body bytes with selected API.
+// Returns: number of bytes received.
+static HttpLength_t _Receive(HttpContext* ctx, char* buffer, size_t bufferSize, HttpLength_t limit, BenchApi api) {
+	HttpLength_t total = 0;
+	size_t received = 0;
+	int result = 0;
+
+	while (total < limit) {
+		if (bufferSize > limit - total)
+			bufferSize = (size_t)(limit - total);
+		if (api == API_RECV_LARGE)
+			result = _HttpRecvLarge(ctx, buffer, bufferSize, &received);
+		else {
+			result = _HttpRecv(buffer, (int)bufferSize, ctx);
+			received = (result > 0 ? (size_t)result : 0);
+			result = 0;
+		}
+		total += received;
+		if (result != 0 || received == 0)
+			break;
+	}
+	return total;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function streams BODY_SIZE bytes once.
+// Returns: Non-zero value if body did not arrive complete.
+static int _RunCase(const char* name, int chunked, BenchApi api, size_t bufferSize) {
+	static const char chunkEnd[] = "\r\n0\r\n\r\n";
+	static char script[512 + PATTERN_SIZE];
+	unsigned long recvCalls = 0;
+	HttpContext ctx;
+	HttpLoopback loopback;
+	char* buffer = malloc(bufferSize);
+	size_t headerLength = 0;
+	HttpLength_t total = 0;
+	double start = 0;
+	double elapsed = 0;
+	int failed = 0;
+
+	// Body is pattern replayed behind header.
+	if (chunked)
+		headerLength = sprintf(script, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n%llx\r\n", BODY_SIZE);
+	else
+		headerLength = sprintf(script, "HTTP/1.1 200 OK\r\nContent-Length: %llu\r\n\r\n", BODY_SIZE);
+	memset(script + headerLength, 'a', PATTERN_SIZE);
+	memset(&ctx, 0, sizeof(ctx));
+	_HttpLoopbackInit(&loopback, script, headerLength + PATTERN_SIZE, NULL, 0);
+	loopback.Flags = HTTP_LOOPBACK_REPEAT;
+	loopback.RepeatOffset = headerLength;
+	_HttpSetTransport(&ctx, _HttpGetLoopbackTransport(), &loopback);
+	_HttpConnect("loopback", 80, 0, &ctx);
+	_HttpSend("GET / HTTP/1.1\r\n\r\n", 18, &ctx);
+	start = _Now();
+	total = _Receive(&ctx, buffer, bufferSize, BODY_SIZE, api);
+	elapsed = _Now() - start;
+	recvCalls = loopback.RecvCalls;
+	if (chunked) {
+		// Chunk payload was received exactly, last chunk follows.
+		_HttpLoopbackInit(&loopback, chunkEnd, sizeof(chunkEnd) - 1, NULL, 0);
+		loopback.Connected = 1;
+		total += _Receive(&ctx, buffer, bufferSize, 1, api);
+		recvCalls += loopback.RecvCalls;
+	}
+	failed = (total != BODY_SIZE || !_HttpIsResponseConsumed(&ctx));
+	printf(
+		"%-28s %10.2f GB/s %10lu calls %s\n",
+		name,
+		total / elapsed / 1e9,
+		recvCalls,
+		(failed ? "BODY INCOMPLETE" : "ok")
+	);
+	_HttpDisconnect(&ctx, 1);
+	free(buffer);
+	return failed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	int failed = 0;
+
+	printf("Body size: %llu bytes\n", BODY_SIZE);
+	failed |= _RunCase("plain, HttpRecv 64 KiB", 0, API_RECV, SMALL_BUFFER_SIZE);
+	failed |= _RunCase("plain, HttpRecvLarge 4 MiB", 0, API_RECV_LARGE, LARGE_BUFFER_SIZE);
+	failed |= _RunCase("chunked, HttpRecv 64 KiB", 1, API_RECV, SMALL_BUFFER_SIZE);
+	failed |= _RunCase("chunked, HttpRecvLarge 4 MiB", 1, API_RECV_LARGE, LARGE_BUFFER_SIZE);
+	return failed;
+}
@@ -0,0 +1,347 @@
+/*
+	Hot path microbenchmarks.
+	Replays responses through loopback transport and measures:
+	- header reading (_ReadHttpHeader) for header sizes from 128 B to 8 KiB and
+	  a single long property, unsegmented and in 1460, 536 and 1-byte segments,
+	- chunked body decoding (_ReceiveChunkedTransfer) for chunk sizes from 16 B
+	  to 64 KiB,
+	- plain body receiving (_ReceivePlainTransfer) for caller buffer sizes from
+	  64 B to 64 KiB,
+	- request building with legacy _HttpSetProperty/_HttpSetRequestBody and
+	  with request builder.
+	Every case reports ns per byte, heap allocations per operation (counting
+	global memory interface) and bytes moved per operation (DataBuffer
+	compaction, request tail moves; not available for legacy functions).
+*/
+#include <HttpLib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+///////////////////////////////////////////////////////////////////////////////
+#define MIN_BENCH_TIME					0.2
+#define BODY_SIZE						(1024 * 1024)
+#define RECV_BUFFER_SIZE				(64 * 1024)
+#define REQUEST_BUFFER_SIZE				8192
+
+///////////////////////////////////////////////////////////////////////////////
+typedef struct BenchResult {
+	double NsPerByte;
+	double AllocsPerOp;
+	// Negative - not measured.
+	double MovedPerOp;
+} BenchResult;
+
+///////////////////////////////////////////////////////////////////////////////
+static unsigned long _allocs = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+static void* _CountingAlloc(size_t size) {
+	_allocs++;
+	return malloc(size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static double _Now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void _PrintResult(const char* name, const BenchResult* result) {
+	if (result->MovedPerOp < 0)
+		printf("%-34s %10.3f %10.2f %12s\n", name, result->NsPerByte, result->AllocsPerOp, "n/a");
+	else
+		printf("%-34s %10.3f %10.2f %12.1f\n", name, result->NsPerByte, result->AllocsPerOp, result->MovedPerOp);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void _SegmentName(char* name, size_t segment) {
+	if (segment == 0)
+		strcpy(name, "whole");
+	else
+		sprintf(name, "%lu B segments", (unsigned long)segment);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function builds response with header of about headerSize bytes (or single
+// long property) and plain or chunked body.
+// Returns: Script length.
+static size_t _BuildResponse(char* script, size_t headerSize, int longProperty, size_t bodySize, size_t chunkSize) {
+	size_t length = 0;
+	size_t offset = 0;
+	size_t piece = 0;
+	int i = 0;
+
+	length = sprintf(script, "HTTP/1.1 200 OK\r\nServer: bench\r\n");
+	if (longProperty) {
+		length += sprintf(script + length, "Set-Cookie: session=");
+		memset(script + length, 'c', headerSize);
+		length += headerSize;
+		length += sprintf(script + length, "\r\n");
+	}
+	else {
+		for (i = 0; length + 64 <= headerSize; i++)
+			length += sprintf(script + length, "X-Header-%03d: %-46s\r\n", i, "some-fairly-typical-header-value");
+	}
+	if (chunkSize == 0) {
+		length += sprintf(script + length, "Content-Length: %lu\r\n\r\n", (unsigned long)bodySize);
+		memset(script + length, 'a', bodySize);
+		return length + bodySize;
+	}
+	length += sprintf(script + length, "Transfer-Encoding: chunked\r\n\r\n");
+	for (offset = 0; offset < bodySize; offset += piece) {
+		piece = (bodySize - offset > chunkSize ? chunkSize : bodySize - offset);
+		length += sprintf(script + length, "%lx\r\n", (unsigned long)piece);
+		memset(script + length, 'a', piece);
+		length += piece;
+		length += sprintf(script + length, "\r\n");
+	}
+	length += sprintf(script + length, "0\r\n\r\n");
+	return length;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function replays response until MIN_BENCH_TIME passes, receiving body with
+// _HttpRecvLarge into buffer of given size.
+// Arguments:
+// 1) Script.
+// 2) Script length.
+// 3) Segment size (0 - whole script at once).
+// 4) Caller buffer size.
+// 5) Measured bytes per response (header or body size).
+// 6) Result.
+// Returns: Non-zero value on error.
+static int _RunResponses(const char* script, size_t scriptLength, size_t segment, size_t bufferSize, size_t measuredBytes, BenchResult* result) {
+	static char buffer[RECV_BUFFER_SIZE];
+	HttpContext ctx;
+	HttpLoopback loopback;
+	size_t received = 0;
+	size_t total = 0;
+	unsigned long responses = 0;
+	unsigned long allocs = 0;
+	double start = 0;
+	double elapsed = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	_HttpLoopbackInit(&loopback, script, scriptLength, (segment ? &segment : NULL), (segment ? 1 : 0));
+	_HttpSetTransport(&ctx, _HttpGetLoopbackTransport(), &loopback);
+	_HttpConnect("loopback", 80, 0, &ctx);
+	// Warm up (first DataBuffer allocation is not counted).
+	_HttpSend("GET / HTTP/1.1\r\n\r\n", 18, &ctx);
+	if (_HttpRecvLarge(&ctx, buffer, bufferSize, &received) != 0)
+		return 1;
+	while (!_HttpIsResponseConsumed(&ctx))
+		if (_HttpRecvLarge(&ctx, buffer, bufferSize, &received) != 0)
+			return 1;
+	memset(&ctx.BufferStats, 0, sizeof(ctx.BufferStats));
+	allocs = _allocs;
+	start = _Now();
+	do {
+		_HttpSend("GET / HTTP/1.1\r\n\r\n", 18, &ctx);
+		_HttpLoopbackRewind(&loopback);
+		total = 0;
+		do {
+			if (_HttpRecvLarge(&ctx, buffer, bufferSize, &received) != 0)
+				return 1;
+			total += received;
+		} while (!_HttpIsResponseConsumed(&ctx));
+		if (total != BODY_SIZE && total != 0)
+			return 1;
+		responses++;
+		elapsed = _Now() - start;
+	} while (elapsed < MIN_BENCH_TIME);
+	result->NsPerByte = elapsed * 1e9 / ((double)responses * measuredBytes);
+	result->AllocsPerOp = (double)(_allocs - allocs) / responses;
+	result->MovedPerOp = (double)ctx.BufferStats.BytesMoved / responses;
+	_HttpDisconnect(&ctx, 1);
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Returns: Non-zero value on error.
+static int _BenchHeaders(char* script) {
+	static const size_t headerSizes[] = { 128, 512, 2048, 8192 };
+	static const size_t segments[] = { 0, 1460, 536, 1 };
+	BenchResult result;
+	size_t scriptLength = 0;
+	char name[64];
+	unsigned int i = 0;
+	unsigned int j = 0;
+	int longProperty = 0;
+
+	printf("\n%-34s %10s %10s %12s\n", "header (size, segment)", "ns/byte", "allocs/op", "moved/op");
+	for (longProperty = 0; longProperty <= 1; longProperty++) {
+		for (i = 0; i < sizeof(headerSizes) / sizeof(headerSizes[0]); i++) {
+			// Property line has to fit in HTTP_BUFFER_LIMIT.
+			if (longProperty && headerSizes[i] >= HTTP_BUFFER_LIMIT)
+				continue;
+			scriptLength = _BuildResponse(script, headerSizes[i], longProperty, 0, 0);
+			for (j = 0; j < sizeof(segments) / sizeof(segments[0]); j++) {
+				sprintf(name, "%s%5lu B, ", (longProperty ? "long " : ""), (unsigned long)scriptLength);
+				_SegmentName(name + strlen(name), segments[j]);
+				if (_RunResponses(script, scriptLength, segments[j], RECV_BUFFER_SIZE, scriptLength, &result) != 0)
+					return 1;
+				_PrintResult(name, &result);
+			}
+		}
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Returns: Non-zero value on error.
+static int _BenchChunked(char* script) {
+	static const size_t chunkSizes[] = { 16, 256, 4096, 65536 };
+	BenchResult result;
+	size_t scriptLength = 0;
+	char name[64];
+	unsigned int i = 0;
+
+	printf("\n%-34s %10s %10s %12s\n", "chunked body (chunk, 1460 seg)", "ns/byte", "allocs/op", "moved/op");
+	for (i = 0; i < sizeof(chunkSizes) / sizeof(chunkSizes[0]); i++) {
+		scriptLength = _BuildResponse(script, 128, 0, BODY_SIZE, chunkSizes[i]);
+		sprintf(name, "%lu B", (unsigned long)chunkSizes[i]);
+		if (_RunResponses(script, scriptLength, 1460, 16384, BODY_SIZE, &result) != 0)
+			return 1;
+		_PrintResult(name, &result);
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Returns: Non-zero value on error.
+static int _BenchPlain(char* script) {
+	static const size_t bufferSizes[] = { 64, 512, 4096, 65536 };
+	static const size_t segments[] = { 0, 1460 };
+	BenchResult result;
+	size_t scriptLength = 0;
+	char name[64];
+	unsigned int i = 0;
+	unsigned int j = 0;
+
+	printf("\n%-34s %10s %10s %12s\n", "plain body (buffer, segment)", "ns/byte", "allocs/op", "moved/op");
+	scriptLength = _BuildResponse(script, 128, 0, BODY_SIZE, 0);
+	for (i = 0; i < sizeof(bufferSizes) / sizeof(bufferSizes[0]); i++) {
+		for (j = 0; j < sizeof(segments) / sizeof(segments[0]); j++) {
+			sprintf(name, "%lu B, ", (unsigned long)bufferSizes[i]);
+			_SegmentName(name + strlen(name), segments[j]);
+			if (_RunResponses(script, scriptLength, segments[j], bufferSizes[i], BODY_SIZE, &result) != 0)
+				return 1;
+			_PrintResult(name, &result);
+		}
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function builds request with given number of properties and body. Every
+// property is set twice (second time replaced with longer value).
+// Arguments:
+// 1) Request buffer.
+// 2) Number of properties.
+// 3) Body.
+// 4) Builder to use (NULL - legacy functions).
+// Returns: Request length, 0 on error.
+static unsigned int _BuildRequest(char* request, unsigned int propertyCount, const char* body, HttpRequestBuilder* builder) {
+	static const char* values[] = { "value", "longer-replacement-value" };
+	char key[24];
+	unsigned int i = 0;
+	unsigned int pass = 0;
+
+	if (builder == NULL) {
+		if (_HttpInitRequest(POST, "/api/v1/transactions", HTTP_11, request, REQUEST_BUFFER_SIZE) != 0)
+			return 0;
+		for (pass = 0; pass < 2; pass++) {
+			for (i = 0; i < propertyCount; i++) {
+				sprintf(key, "X-Prop-%02u", i);
+				if (_HttpSetProperty(key, values[pass], request, REQUEST_BUFFER_SIZE) != 0)
+					return 0;
+			}
+		}
+		// Request length is returned.
+		return (unsigned int)(_HttpSetRequestBody(body, request, REQUEST_BUFFER_SIZE) > 0 ? strlen(request) : 0);
+	}
+	if (_HttpBuilderInit(builder, request, REQUEST_BUFFER_SIZE, POST, "/api/v1/transactions", HTTP_11) != 0)
+		return 0;
+	for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i < propertyCount; i++) {
+			sprintf(key, "X-Prop-%02u", i);
+			if (_HttpBuilderSetProperty(builder, key, values[pass]) != 0)
+				return 0;
+		}
+	}
+	return (_HttpBuilderSetBody(builder, body, (unsigned int)strlen(body)) > 0 ? builder->Length : 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Returns: Non-zero value on error.
+static int _BenchRequests(void) {
+	static const unsigned int propertyCounts[] = { 4, 16, 30 };
+	static const size_t bodySizes[] = { 64, 4096 };
+	static char request[REQUEST_BUFFER_SIZE];
+	static char body[4096 + 1];
+	HttpRequestBuilder builder;
+	BenchResult result = { 0, 0, 0 };
+	unsigned long requests = 0;
+	unsigned long allocs = 0;
+	unsigned long moved = 0;
+	unsigned int length = 0;
+	char name[64];
+	double start = 0;
+	double elapsed = 0;
+	unsigned int i = 0;
+	unsigned int j = 0;
+	int legacy = 0;
+
+	printf("\n%-34s %10s %10s %12s\n", "request (properties, body)", "ns/byte", "allocs/op", "moved/op");
+	for (i = 0; i < sizeof(propertyCounts) / sizeof(propertyCounts[0]); i++) {
+		for (j = 0; j < sizeof(bodySizes) / sizeof(bodySizes[0]); j++) {
+			moved = 0;
+			memset(body, 'b', bodySizes[j]);
+			body[bodySizes[j]] = '\0';
+			for (legacy = 0; legacy <= 1; legacy++) {
+				requests = 0;
+				allocs = _allocs;
+				start = _Now();
+				do {
+					length = _BuildRequest(request, propertyCounts[i], body, (legacy ? NULL : &builder));
+					if (length == 0)
+						return 1;
+					if (!legacy)
+						moved += builder.BytesMoved;
+					requests++;
+					elapsed = _Now() - start;
+				} while (elapsed < MIN_BENCH_TIME);
+				result.NsPerByte = elapsed * 1e9 / ((double)requests * length);
+				result.AllocsPerOp = (double)(_allocs - allocs) / requests;
+				// Legacy functions use builder of their own, its moves are not visible here.
+				result.MovedPerOp = (legacy ? -1 : (double)moved / requests);
+				sprintf(name, "%s%2u, %4lu B", (legacy ? "legacy " : "builder "), propertyCounts[i], (unsigned long)bodySizes[j]);
+				_PrintResult(name, &result);
+			}
+		}
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	// Chunked body with 16-byte chunks takes about 1.4 times body size.
+	char* script = malloc(2 * BODY_SIZE + 16384);
+	int failed = 0;
+
+	_HttpSetMemoryInterface(_CountingAlloc, free);
+	printf("Minimum time per case: %.1f s, body: %d bytes\n", MIN_BENCH_TIME, BODY_SIZE);
+	failed |= _BenchHeaders(script);
+	failed |= _BenchChunked(script);
+	failed |= _BenchPlain(script);
+	failed |= _BenchRequests();
+	free(script);
+	if (failed)
+		fprintf(stderr, "Benchmark failed.\n");
+	return failed;
+}
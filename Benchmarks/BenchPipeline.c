@@ -0,0 +1,235 @@
+/*
+	Pipeline benchmark.
+	Receives responses through loopback transport one by one (request, response)
+	and pipelined (HTTP_PIPELINE_DEPTH requests per flush), bodies are left unread
+	and skipped. Reports time per response for different body sizes.
+	Also checks that unread body is skipped whole before next response, also when
+	it is ended by connection close (remaining requests are sent again on new
+	connection), and that request following response with Connection: close
+	(or HTTP/1.0 one) goes on new connection and that connection to long host
+	name can be opened again.
+*/
+#include <HttpPipeline.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+///////////////////////////////////////////////////////////////////////////////
+#define RESPONSE_COUNT					200000
+#define CHECK_BODY_SIZE					5000
+
+///////////////////////////////////////////////////////////////////////////////
+static const char _request[] = "GET / HTTP/1.1\r\nHost: loopback\r\n\r\n";
+// Scripts replayed by check transport, next one on every connection.
+static const char* _checkScripts[2];
+static size_t _checkSizes[2];
+static unsigned int _checkConnects = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+static double _Now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function builds response with given body size into script buffer.
+// Returns: script length.
+static size_t _BuildResponse(char* script, int bodySize) {
+	size_t length = sprintf(script, "HTTP/1.1 200 OK\r\nServer: bench\r\nContent-Length: %d\r\n\r\n", bodySize);
+
+	memset(script + length, 'a', bodySize);
+	return length + bodySize;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function receives RESPONSE_COUNT responses (replayed script) and returns time per response.
+// Returns: Time in nanoseconds or negative value on error.
+static double _RunCase(const char* script, size_t scriptLength, int pipelined) {
+	HttpContext ctx;
+	HttpLoopback loopback;
+	HttpPipeline pipeline;
+	char body[1];
+	double start = 0;
+	unsigned short status = 0;
+	int received = 0;
+	int i = 0;
+	int j = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	_HttpLoopbackInit(&loopback, script, scriptLength, NULL, 0);
+	loopback.Flags = HTTP_LOOPBACK_REPEAT;
+	_HttpSetTransport(&ctx, _HttpGetLoopbackTransport(), &loopback);
+	_HttpConnect("loopback", 80, 0, &ctx);
+	start = _Now();
+	for (i = 0; i < RESPONSE_COUNT && received == i; i += j) {
+		if (!pipelined) {
+			// First body byte brings header in, rest is skipped by next request.
+			j = 1;
+			if (_HttpSend(_request, sizeof(_request) - 1, &ctx) == 0) {
+				_HttpRecv(body, 1, &ctx);
+				if (_HttpGetResponseStatus(&ctx, &status, NULL, NULL, NULL) == 0 && status == 200)
+					received++;
+			}
+			continue;
+		}
+		_HttpPipelineInit(&pipeline, &ctx);
+		for (j = 0; j < HTTP_PIPELINE_DEPTH; j++)
+			_HttpPipelineQueue(&pipeline, _request, sizeof(_request) - 1);
+		while (_HttpPipelineNext(&pipeline) == 0)
+			received++;
+	}
+	start = _Now() - start;
+	_HttpDisconnect(&ctx, 1);
+	return (received == RESPONSE_COUNT ? start * 1e9 / RESPONSE_COUNT : -1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Check transport connect: loopback replaying next script.
+static int _CheckConnect(HttpContext* ctx, const char* url, unsigned short port, unsigned char ssl) {
+	unsigned int index = _checkConnects++ % 2;
+
+	_HttpLoopbackInit((HttpLoopback*)ctx->TransportData, _checkScripts[index], _checkSizes[index], NULL, 0);
+	return _HttpGetLoopbackTransport()->Connect(ctx, url, port, ssl);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function pipelines two requests, leaves first response body unread and
+// checks second response. First body is delimited by Content-Length or by connection
+// close (second response comes on new connection then).
+// Returns: Non-zero value on error.
+static int _CheckSkip(int closeDelimited) {
+	static char first[CHECK_BODY_SIZE + 256];
+	static const char second[] = "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\ntwo";
+	HttpTransport transport = *_HttpGetLoopbackTransport();
+	HttpContext ctx;
+	HttpLoopback loopback;
+	HttpPipeline pipeline;
+	char body[16];
+	size_t length = 0;
+	int result = 0;
+
+	length = sprintf(first, (closeDelimited ? "HTTP/1.1 200 OK\r\n\r\n" : "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n"), CHECK_BODY_SIZE);
+	memset(first + length, 'a', CHECK_BODY_SIZE);
+	length += CHECK_BODY_SIZE;
+	if (!closeDelimited) {
+		memcpy(first + length, second, sizeof(second) - 1);
+		length += sizeof(second) - 1;
+	}
+	_checkScripts[0] = first;
+	_checkSizes[0] = length;
+	_checkScripts[1] = second;
+	_checkSizes[1] = sizeof(second) - 1;
+	_checkConnects = 0;
+	transport.Connect = _CheckConnect;
+	memset(&ctx, 0, sizeof(ctx));
+	_HttpSetTransport(&ctx, &transport, &loopback);
+	_HttpConnect("loopback", 80, 0, &ctx);
+	_HttpPipelineInit(&pipeline, &ctx);
+	_HttpPipelineQueue(&pipeline, _request, sizeof(_request) - 1);
+	_HttpPipelineQueue(&pipeline, _request, sizeof(_request) - 1);
+	if (_HttpPipelineNext(&pipeline) != 0 || _HttpPipelineNext(&pipeline) != 0 || _HttpPipelineCurrent(&pipeline) != 1)
+		result = -1;
+	else if (_HttpRecv(body, sizeof(body), &ctx) != 3 || memcmp(body, "two", 3) != 0)
+		result = -1;
+	else if (_HttpPipelineNext(&pipeline) != 1 || pipeline.Retries != (closeDelimited ? 1u : 0u))
+		result = -1;
+	_HttpDisconnect(&ctx, 1);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function sends two requests one by one, first response ends connection
+// (Connection: close or HTTP/1.0). Old connection would answer second request with 500.
+// Returns: Non-zero value on error.
+static int _CheckConnectionClose(const char* host, const char* first) {
+	static char script[256];
+	static const char second[] = "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\ntwo";
+	HttpTransport transport = *_HttpGetLoopbackTransport();
+	HttpContext ctx;
+	HttpLoopback loopback;
+	char body[16];
+	int result = 0;
+
+	_checkScripts[0] = script;
+	_checkSizes[0] = sprintf(script, "%sHTTP/1.1 500 Stale\r\nContent-Length: 3\r\n\r\nbad", first);
+	_checkScripts[1] = second;
+	_checkSizes[1] = sizeof(second) - 1;
+	_checkConnects = 0;
+	transport.Connect = _CheckConnect;
+	memset(&ctx, 0, sizeof(ctx));
+	_HttpSetTransport(&ctx, &transport, &loopback);
+	_HttpConnect(host, 80, 0, &ctx);
+	if (_HttpSend(_request, sizeof(_request) - 1, &ctx) != 0 || _HttpRecv(body, sizeof(body), &ctx) != 3 || !_HttpIsResponseConsumed(&ctx))
+		result = -1;
+	else if (_HttpSend(_request, sizeof(_request) - 1, &ctx) != 0 || _HttpRecv(body, sizeof(body), &ctx) != 3 || memcmp(body, "two", 3) != 0)
+		result = -1;
+	else if (_checkConnects != 2)
+		result = -1;
+	_HttpDisconnect(&ctx, 1);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function checks that connection to host name of maximum length is opened
+// again after Connection: close and that longer name is refused.
+// Returns: Non-zero value on error.
+static int _CheckLongHost(void) {
+	char host[HTTP_MAX_HOST_SIZE + 1];
+	HttpContext ctx;
+	HttpLoopback loopback;
+	int result = 0;
+
+	memset(host, 'a', sizeof(host) - 1);
+	host[HTTP_MAX_HOST_SIZE - 1] = '\0';
+	if (_CheckConnectionClose(host, "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 3\r\n\r\none") != 0)
+		return -1;
+	// Name not fitting context is refused instead of being forgotten.
+	host[HTTP_MAX_HOST_SIZE - 1] = 'a';
+	host[HTTP_MAX_HOST_SIZE] = '\0';
+	memset(&ctx, 0, sizeof(ctx));
+	memset(&loopback, 0, sizeof(loopback));
+	_HttpSetTransport(&ctx, _HttpGetLoopbackTransport(), &loopback);
+	if (_HttpConnect(host, 80, 0, &ctx) == 0)
+		result = -1;
+	_HttpDisconnect(&ctx, 1);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	static char script[8192];
+	static const int bodySizes[] = { 0, 64, 1024, 4096 };
+	size_t scriptLength = 0;
+	double sequential = 0;
+	double pipelined = 0;
+	int failed = 0;
+	unsigned int i = 0;
+
+	printf("%-10s %16s %16s\n", "body", "ns/response", "ns (pipelined)");
+	for (i = 0; i < sizeof(bodySizes) / sizeof(bodySizes[0]); i++) {
+		scriptLength = _BuildResponse(script, bodySizes[i]);
+		sequential = _RunCase(script, scriptLength, 0);
+		pipelined = _RunCase(script, scriptLength, 1);
+		failed = failed || sequential < 0 || pipelined < 0;
+		printf("%-10d %16.1f %16.1f\n", bodySizes[i], sequential, pipelined);
+	}
+	if (_CheckSkip(0) != 0 || _CheckSkip(1) != 0) {
+		fprintf(stderr, "Unread response body was not skipped.\n");
+		failed = 1;
+	}
+	if (_CheckConnectionClose("loopback", "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 3\r\n\r\none") != 0
+		|| _CheckConnectionClose("loopback", "HTTP/1.0 200 OK\r\nContent-Length: 3\r\n\r\none") != 0) {
+		fprintf(stderr, "Connection closed by remote host was reused.\n");
+		failed = 1;
+	}
+	if (_CheckLongHost() != 0) {
+		fprintf(stderr, "Connection to long host name cannot be opened again.\n");
+		failed = 1;
+	}
+	if (failed)
+		fprintf(stderr, "Benchmark failed.\n");
+	return failed;
+}
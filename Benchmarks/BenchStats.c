@@ -0,0 +1,241 @@
+/*
+	Performance counters benchmark.
+	1) Overhead: replays 64 KiB responses (1460-byte segments) through loopback
+	   transport with and without stats attached, reports best time per response.
+	2) Phase breakdown: sends requests to server (forked child process) on
+	   127.0.0.1 which waits before header and between header and body, and
+	   reconnects every RECONNECT_EVERY requests. Reports counters and latency
+	   percentiles from aggregator.
+*/
+#include <HttpStats.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+///////////////////////////////////////////////////////////////////////////////
+#define BODY_SIZE						(64 * 1024)
+#define LOOPBACK_RESPONSES				20000
+// Loopback runs alternate, best one of each kind counts.
+#define LOOPBACK_RUNS					5
+#define SERVER_REQUESTS					200
+#define RECONNECT_EVERY					20
+// Server delays (microseconds): before header (time to first byte) and before body.
+#define SERVER_HEADER_DELAY				2000
+#define SERVER_BODY_DELAY				3000
+
+///////////////////////////////////////////////////////////////////////////////
+static const char _request[] = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+
+///////////////////////////////////////////////////////////////////////////////
+static double _Now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function receives whole response.
+// Returns: Non-zero value on error.
+static int _ReceiveResponse(HttpContext* ctx, char* buffer, size_t bufferSize) {
+	size_t received = 0;
+	size_t total = 0;
+
+	do {
+		if (_HttpRecvLarge(ctx, buffer, bufferSize, &received) != 0)
+			return 1;
+		total += received;
+	} while (!_HttpIsResponseConsumed(ctx));
+	return (total != BODY_SIZE);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function replays response LOOPBACK_RESPONSES times.
+// Returns: Time per response (ns), negative value on error.
+static double _RunLoopback(const char* script, size_t scriptLength, HttpStats* stats) {
+	static const size_t segments[] = { 1460 };
+	static char buffer[16384];
+	HttpContext ctx;
+	HttpLoopback loopback;
+	double start = 0;
+	int i = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	_HttpSetStats(&ctx, stats);
+	_HttpLoopbackInit(&loopback, script, scriptLength, segments, 1);
+	_HttpSetTransport(&ctx, _HttpGetLoopbackTransport(), &loopback);
+	_HttpConnect("loopback", 80, 0, &ctx);
+	start = _Now();
+	for (i = 0; i < LOOPBACK_RESPONSES; i++) {
+		_HttpSend(_request, sizeof(_request) - 1, &ctx);
+		_HttpLoopbackRewind(&loopback);
+		if (_ReceiveResponse(&ctx, buffer, sizeof(buffer)) != 0)
+			return -1;
+	}
+	start = (_Now() - start) * 1e9 / LOOPBACK_RESPONSES;
+	_HttpDisconnect(&ctx, 1);
+	return start;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function serves connections one after another until killed.
+static void _Serve(int listener, const char* body) {
+	char header[128];
+	char buffer[1024];
+	size_t filled = 0;
+	ssize_t result = 0;
+	int headerLength = sprintf(header, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n", BODY_SIZE);
+	int client = -1;
+
+	while ((client = accept(listener, NULL, NULL)) >= 0) {
+		filled = 0;
+		while ((result = recv(client, buffer + filled, sizeof(buffer) - 1 - filled, 0)) > 0) {
+			filled += (size_t)result;
+			buffer[filled] = '\0';
+			// Requests are not pipelined, whole request is in buffer.
+			if (strstr(buffer, "\r\n\r\n") == NULL)
+				continue;
+			filled = 0;
+			usleep(SERVER_HEADER_DELAY);
+			send(client, header, headerLength, 0);
+			usleep(SERVER_BODY_DELAY);
+			send(client, body, BODY_SIZE, 0);
+		}
+		close(client);
+	}
+	_exit(0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function prints latency percentiles.
+static void _PrintLatencies(const HttpStatsAggregator* aggregator) {
+	static const char* names[HTTP_LATENCY_COUNT] = { "session", "connect", "send", "first byte", "header", "body", "total" };
+	int latency = 0;
+
+	printf("%-12s %8s %8s %8s %8s %8s %8s\n", "latency", "samples", "avg ms", "p50 <=", "p90 <=", "p99 <=", "max");
+	for (latency = 0; latency < HTTP_LATENCY_COUNT; latency++) {
+		if (aggregator->Count[latency] == 0)
+			continue;
+		printf(
+			"%-12s %8lu %8.2f %8lu %8lu %8lu %8lu\n",
+			names[latency],
+			aggregator->Count[latency],
+			(double)aggregator->Sum[latency] / aggregator->Count[latency],
+			_HttpStatsPercentile(aggregator, (HttpLatency)latency, 50),
+			_HttpStatsPercentile(aggregator, (HttpLatency)latency, 90),
+			_HttpStatsPercentile(aggregator, (HttpLatency)latency, 99),
+			aggregator->Max[latency]
+		);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Returns: Non-zero value on error.
+static int _RunServer(const char* body) {
+	static char buffer[16384];
+	struct sockaddr_in address;
+	socklen_t addressSize = sizeof(address);
+	HttpStatsAggregator aggregator;
+	HttpStats stats;
+	HttpStats snapshot;
+	HttpContext ctx;
+	unsigned long ttfb = 0;
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	int failed = 0;
+	int i = 0;
+	pid_t server = 0;
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 4) != 0)
+		return 1;
+	getsockname(listener, (struct sockaddr*)&address, &addressSize);
+	server = fork();
+	if (server == 0)
+		_Serve(listener, body);
+	close(listener);
+
+	_HttpStatsAggregatorInit(&aggregator);
+	_HttpStatsInit(&stats, &aggregator);
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.ConnectTimeout = 5;
+	ctx.RecvTimeout = 5;
+	_HttpSetStats(&ctx, &stats);
+	for (i = 0; i < SERVER_REQUESTS && !failed; i++) {
+		if (i % RECONNECT_EVERY == 0) {
+			_HttpDisconnect(&ctx, 1);
+			if (_HttpConnect("127.0.0.1", ntohs(address.sin_port), 0, &ctx) != 0)
+				failed = 1;
+		}
+		if (!failed && _HttpSend(_request, sizeof(_request) - 1, &ctx) != 0)
+			failed = 1;
+		if (!failed)
+			failed = _ReceiveResponse(&ctx, buffer, sizeof(buffer));
+	}
+	_HttpStatsSnapshot(&ctx, &snapshot);
+	_HttpDisconnect(&ctx, 1);
+	kill(server, SIGKILL);
+	waitpid(server, NULL, 0);
+
+	printf(
+		"\nServer on 127.0.0.1 (%d us to header, %d us to body), %d requests:\n",
+		SERVER_HEADER_DELAY, SERVER_BODY_DELAY, SERVER_REQUESTS
+	);
+	printf(
+		"connects %lu, requests %lu, responses %lu, retries %lu\n"
+		"sent %llu B in %lu calls, received %llu B in %lu calls\n"
+		"moved %lu B, buffer grows %lu\n",
+		snapshot.Connects, snapshot.Requests, snapshot.Responses, snapshot.Retries,
+		snapshot.BytesSent, snapshot.SendCalls, snapshot.BytesReceived, snapshot.RecvCalls,
+		snapshot.BytesMoved, snapshot.BufferGrows
+	);
+	if (_HttpStatsPhaseTime(&snapshot, HTTP_PHASE_REQUEST_SENT, HTTP_PHASE_FIRST_BYTE, &ttfb) == 0)
+		printf("last request time to first byte: %lu ms\n", ttfb);
+	_PrintLatencies(&aggregator);
+	if (snapshot.Responses != SERVER_REQUESTS || snapshot.Connects != SERVER_REQUESTS / RECONNECT_EVERY)
+		failed = 1;
+	return failed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	char* script = malloc(BODY_SIZE + 128);
+	size_t scriptLength = 0;
+	HttpStats stats;
+	double without = 0;
+	double with = 0;
+	double time = 0;
+	int failed = 0;
+	int run = 0;
+
+	signal(SIGPIPE, SIG_IGN);
+	scriptLength = sprintf(script, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n", BODY_SIZE);
+	memset(script + scriptLength, 'a', BODY_SIZE);
+	for (run = 0; run < LOOPBACK_RUNS && !failed; run++) {
+		time = _RunLoopback(script, scriptLength + BODY_SIZE, NULL);
+		if (run == 0 || time < without)
+			without = time;
+		_HttpStatsInit(&stats, NULL);
+		time = _RunLoopback(script, scriptLength + BODY_SIZE, &stats);
+		if (run == 0 || time < with)
+			with = time;
+		failed = (without < 0 || with < 0 || stats.Responses != LOOPBACK_RESPONSES);
+	}
+	printf("Loopback, %d B responses in 1460 B segments:\n", BODY_SIZE);
+	printf("without stats %10.1f ns/response\n", without);
+	printf("with stats    %10.1f ns/response (%+.1f%%), %lu recv calls per response\n",
+		with, (with - without) * 100 / without, stats.RecvCalls / LOOPBACK_RESPONSES);
+	failed |= _RunServer(script + scriptLength);
+	free(script);
+	if (failed)
+		fprintf(stderr, "Benchmark failed.\n");
+	return failed;
+}
@@ -0,0 +1,164 @@
+/*
+	Concurrency benchmark.
+	Runs 1 to 64 client threads, each with its own context, loopback transport
+	and per-context allocator. Every thread sends requests and receives small
+	keep-alive responses, reconnecting every RECONNECT_INTERVAL requests (so its
+	buffers are freed and allocated again). Reports throughput and scaling.
+*/
+#include <HttpLib.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+///////////////////////////////////////////////////////////////////////////////
+#define MAX_THREADS						64
+#define REQUESTS_PER_THREAD				100000
+#define RECONNECT_INTERVAL				100
+#define BODY_SIZE						512
+
+///////////////////////////////////////////////////////////////////////////////
+static const char _request[] = "GET / HTTP/1.1\r\nHost: loopback\r\n\r\n";
+
+///////////////////////////////////////////////////////////////////////////////
+typedef struct BenchThread {
+	pthread_t Thread;
+	const char* Script;
+	size_t ScriptSize;
+	unsigned long Completed;
+	unsigned long Allocations;
+	unsigned long Frees;
+} BenchThread;
+
+///////////////////////////////////////////////////////////////////////////////
+// Allocator counters of calling thread (Allocator_t has no user data).
+static __thread BenchThread* _current = NULL;
+
+///////////////////////////////////////////////////////////////////////////////
+static double _Now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void* _CountingAlloc(size_t size) {
+	_current->Allocations++;
+	return malloc(size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void _CountingFree(void* memory) {
+	_current->Frees++;
+	free(memory);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void* _RunThread(void* argument) {
+	BenchThread* thread = (BenchThread*)argument;
+	HttpContext ctx;
+	HttpLoopback loopback;
+	char body[BODY_SIZE];
+	size_t received = 0;
+	size_t total = 0;
+	int i = 0;
+
+	_current = thread;
+	memset(&ctx, 0, sizeof(ctx));
+	_HttpLoopbackInit(&loopback, thread->Script, thread->ScriptSize, NULL, 0);
+	loopback.Flags = HTTP_LOOPBACK_REPEAT;
+	_HttpSetTransport(&ctx, _HttpGetLoopbackTransport(), &loopback);
+	_HttpSetContextMemoryInterface(&ctx, _CountingAlloc, _CountingFree);
+	for (i = 0; i < REQUESTS_PER_THREAD; i++) {
+		if ((i % RECONNECT_INTERVAL) == 0) {
+			_HttpDisconnect(&ctx, 1);
+			_HttpLoopbackRewind(&loopback);
+			if (_HttpConnect("loopback", 80, 0, &ctx) != 0)
+				break;
+		}
+		if (_HttpSend(_request, sizeof(_request) - 1, &ctx) != 0)
+			break;
+		total = 0;
+		do {
+			if (_HttpRecvLarge(&ctx, body, sizeof(body), &received) != 0)
+				break;
+			total += received;
+		} while (received > 0 && !_HttpIsResponseConsumed(&ctx));
+		if (total != BODY_SIZE || !_HttpIsResponseConsumed(&ctx))
+			break;
+		thread->Completed++;
+	}
+	_HttpDisconnect(&ctx, 1);
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function runs given number of threads once.
+// Returns: Requests per second (negative if any request failed).
+static double _RunCase(unsigned int threadCount, const char* script, size_t scriptSize) {
+	static BenchThread threads[MAX_THREADS];
+	unsigned long completed = 0;
+	unsigned long allocations = 0;
+	unsigned long frees = 0;
+	double start = 0;
+	double elapsed = 0;
+	unsigned int i = 0;
+
+	memset(threads, 0, sizeof(threads));
+	start = _Now();
+	for (i = 0; i < threadCount; i++) {
+		threads[i].Script = script;
+		threads[i].ScriptSize = scriptSize;
+		pthread_create(&threads[i].Thread, NULL, _RunThread, &threads[i]);
+	}
+	for (i = 0; i < threadCount; i++) {
+		pthread_join(threads[i].Thread, NULL);
+		completed += threads[i].Completed;
+		allocations += threads[i].Allocations;
+		frees += threads[i].Frees;
+	}
+	elapsed = _Now() - start;
+	printf(
+		"%3u threads %10lu requests %12.0f req/s %8lu allocs %8lu frees %s\n",
+		threadCount,
+		completed,
+		completed / elapsed,
+		allocations,
+		frees,
+		(completed == (unsigned long)threadCount * REQUESTS_PER_THREAD && allocations == frees ? "ok" : "FAILED")
+	);
+	if (completed != (unsigned long)threadCount * REQUESTS_PER_THREAD || allocations != frees)
+		return -1;
+	return completed / elapsed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(void) {
+	static char script[256 + BODY_SIZE];
+	size_t scriptSize = 0;
+	double single = 0;
+	double current = 0;
+	unsigned int threadCount = 0;
+	int failed = 0;
+
+	scriptSize = sprintf(script, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n", BODY_SIZE);
+	memset(script + scriptSize, 'a', BODY_SIZE);
+	scriptSize += BODY_SIZE;
+
+	printf("Online CPUs: %ld, requests per thread: %d\n", sysconf(_SC_NPROCESSORS_ONLN), REQUESTS_PER_THREAD);
+	for (threadCount = 1; threadCount <= MAX_THREADS; threadCount *= 2) {
+		current = _RunCase(threadCount, script, scriptSize);
+		if (current < 0) {
+			failed = 1;
+			continue;
+		}
+		if (threadCount == 1)
+			single = current;
+		if (single > 0)
+			printf("%3u threads scaling: %.2fx\n", threadCount, current / single);
+	}
+	return failed;
+}
@@ -0,0 +1,110 @@
+#ifndef HTTPASYNC_H
+#define HTTPASYNC_H
+
+#include <HttpLib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Step results (negative value is error).
+#define HTTP_ASYNC_DONE					0
+#define HTTP_ASYNC_WOULD_BLOCK			1
+// Events request waits for (HttpAsync::WaitEvents).
+#define HTTP_WAIT_READ					1
+#define HTTP_WAIT_WRITE					2
+
+#ifdef __cplusplus
+extern "C" {
+#endif	// __cplusplus
+
+	/*
+		HttpAsync runs single request (connect, send, response header and body)
+		as resumable state machine on non-blocking context. Every step does as much
+		as it can without waiting and reports descriptor and events it waits for,
+		so any event loop can drive thousands of requests on single thread
+		(see HttpEpoll). Needs transport with SendSome (POSIX, loopback).
+		There are no timeouts in this mode, event loop has to enforce them.
+	*/
+
+	struct HttpAsync;
+	// Completion handler used by event loop drivers: request and its result
+	// (0 - response received, negative value - error).
+	typedef void(*HttpAsyncDone_t)(struct HttpAsync*, int);
+
+	///////////////////////////////////////////////////////////////////////////////
+	typedef enum HttpAsyncState {
+		HTTP_ASYNC_CONNECTING,
+		HTTP_ASYNC_SENDING,
+		HTTP_ASYNC_RECEIVING_HEADER,
+		HTTP_ASYNC_RECEIVING_BODY,
+		HTTP_ASYNC_COMPLETE,
+		HTTP_ASYNC_FAILED
+	} HttpAsyncState;
+
+	///////////////////////////////////////////////////////////////////////////////
+	typedef struct HttpAsync {
+		// Context request runs on. If it is not connected, connection is opened first.
+		HttpContext* Context;
+		// Remote host (numeric address, name resolution would block) and port.
+		const char* Host;
+		unsigned short Port;
+		// Serialized request (not copied) and number of bytes already sent.
+		const char* Request;
+		size_t RequestSize;
+		size_t RequestSent;
+		// Body sink (NULL - body is dropped) and its data. Pausing has no effect here.
+		HttpBodySink_t Sink;
+		void* SinkData;
+		// Completion handler (can be NULL) and user data.
+		HttpAsyncDone_t Done;
+		void* UserData;
+		// Current state (HttpAsyncState).
+		unsigned char State;
+		// Descriptor and events (HTTP_WAIT_*) request waits for after HTTP_ASYNC_WOULD_BLOCK.
+		int WaitFd;
+		unsigned int WaitEvents;
+		// Result of completed request.
+		int Result;
+		// Event loop driver data (i.e. events registered with epoll).
+		unsigned int DriverEvents;
+	} HttpAsync;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function prepares request. Context is switched to non-blocking mode.
+	// If context holds unread response or remote host closes connection (Connection: close),
+	// connection is closed (it can not be drained or reopened without waiting) and
+	// request opens new one. Sink and completion handler can be set in structure afterwards.
+	// Arguments:
+	// 1) Request.
+	// 2) Valid HttpContext pointer.
+	// 3) Remote host (used if context is not connected).
+	// 4) Remote host port.
+	// 5) Serialized request (has to stay valid until request completes).
+	// 6) Request size.
+	// Returns: Non-zero value on error.
+	extern int _HttpAsyncInit(HttpAsync*, HttpContext*, const char*, unsigned short, const void*, size_t);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function advances request as far as it gets without waiting.
+	// Returns:
+	// HTTP_ASYNC_DONE : Response received (body passed to sink), connection can be reused.
+	// HTTP_ASYNC_WOULD_BLOCK : Call again when WaitFd is ready for WaitEvents.
+	// < 0 : On error (connection is closed).
+	extern int _HttpAsyncStep(HttpAsync*);
+
+#ifdef __cplusplus
+}
+#endif	// __cplusplus
+
+///////////////////////////////////////////////////////////////////////////////
+// Set global names for async interface functions.
+#ifdef HttpAsyncInit
+#undef HttpAsyncInit
+#endif
+#define HttpAsyncInit _HttpAsyncInit
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpAsyncStep
+#undef HttpAsyncStep
+#endif
+#define HttpAsyncStep _HttpAsyncStep
+
+#endif	// HTTPASYNC_H
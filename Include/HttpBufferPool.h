@@ -0,0 +1,139 @@
+#ifndef HTTPBUFFERPOOL_H
+#define HTTPBUFFERPOOL_H
+
+#include <HttpLib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Buffer pool defaults.
+// Number of size classes: HTTP_BUFFER_SIZE, doubled up to HTTP_BUFFER_LIMIT.
+#define HTTP_BUFFER_POOL_CLASSES		6
+// Maximum number of free buffers kept in single size class (allocator memory).
+#define HTTP_BUFFER_POOL_CAP			4
+
+#ifdef __cplusplus
+extern "C" {
+#endif	// __cplusplus
+
+	/*
+		HttpBufferPool keeps DataBuffers returned by contexts (on disconnect, shrink
+		or grow) and lends them again, so connection cycles do not hit heap.
+		Buffers come in size classes (HTTP_BUFFER_SIZE doubled up to HTTP_BUFFER_LIMIT),
+		bigger ones go straight to allocator. Optional arena (memory block given by
+		user) is carved into buffers first and never returned to heap, so long
+		running terminal does not fragment its heap. Pool is not synchronized,
+		contexts sharing pool have to run on single thread.
+	*/
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Buffer pool usage statistics.
+	typedef struct HttpBufferPoolStats {
+		// Buffers lent from free list.
+		unsigned long Hits;
+		// Buffers which had to be carved from arena or allocated.
+		unsigned long Misses;
+		// Misses served from arena.
+		unsigned long ArenaCarves;
+		// Buffers bigger than biggest size class (allocated and freed directly).
+		unsigned long Oversized;
+		// Buffers freed on return, because their size class was full.
+		unsigned long Dropped;
+		// Failed allocations.
+		unsigned long Failures;
+		// Bytes lent to contexts now and at most.
+		unsigned long InUse;
+		unsigned long PeakInUse;
+		// Bytes kept in free lists now and at most.
+		unsigned long Cached;
+		unsigned long PeakCached;
+	} HttpBufferPoolStats;
+
+	///////////////////////////////////////////////////////////////////////////////
+	typedef struct HttpBufferPool {
+		// Free buffers of each size class (linked through their first bytes) and their number.
+		void* FreeLists[HTTP_BUFFER_POOL_CLASSES];
+		unsigned int FreeCounts[HTTP_BUFFER_POOL_CLASSES];
+		// Maximum number of allocator buffers kept per size class (arena buffers are always kept).
+		unsigned int Caps[HTTP_BUFFER_POOL_CLASSES];
+		// Arena memory (can be NULL), its size and bytes already carved.
+		char* Arena;
+		size_t ArenaSize;
+		size_t ArenaUsed;
+		// Memory interface used when arena is exhausted (NULL - global one).
+		Allocator_t MemAlloc;
+		Deallocator_t MemFree;
+		HttpBufferPoolStats Stats;
+	} HttpBufferPool;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function initializes pool. Every size class is capped at HTTP_BUFFER_POOL_CAP,
+	// caps can be changed in structure afterwards.
+	// Arguments:
+	// 1) Pool.
+	// 2) Arena memory (can be NULL, has to stay valid as long as pool is used).
+	// 3) Arena size.
+	// Returns: Non-zero value on error.
+	extern int _HttpBufferPoolInit(HttpBufferPool*, void*, size_t);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function lends buffer of at least given size.
+	// Returns: Buffer or NULL if there is no memory.
+	extern void* _HttpBufferPoolGet(HttpBufferPool*, size_t);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function takes buffer back.
+	// Arguments:
+	// 1) Pool.
+	// 2) Buffer lent by pool.
+	// 3) Size buffer was requested with.
+	extern void _HttpBufferPoolPut(HttpBufferPool*, void*, size_t);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function frees cached buffers. Lent buffers have to be returned first
+	// (disconnect contexts using pool).
+	extern void _HttpBufferPoolDestroy(HttpBufferPool*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function makes context borrow its DataBuffer from pool. Can be called anytime,
+	// current buffer goes back where it came from.
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Pool (NULL - context allocates its buffers again).
+	// Returns: Non-zero value on error.
+	extern int _HttpSetBufferPool(HttpContext*, HttpBufferPool*);
+
+#ifdef __cplusplus
+}
+#endif	// __cplusplus
+
+///////////////////////////////////////////////////////////////////////////////
+// Set global names for buffer pool interface functions.
+#ifdef HttpBufferPoolInit
+#undef HttpBufferPoolInit
+#endif
+#define HttpBufferPoolInit _HttpBufferPoolInit
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpBufferPoolGet
+#undef HttpBufferPoolGet
+#endif
+#define HttpBufferPoolGet _HttpBufferPoolGet
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpBufferPoolPut
+#undef HttpBufferPoolPut
+#endif
+#define HttpBufferPoolPut _HttpBufferPoolPut
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpBufferPoolDestroy
+#undef HttpBufferPoolDestroy
+#endif
+#define HttpBufferPoolDestroy _HttpBufferPoolDestroy
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpSetBufferPool
+#undef HttpSetBufferPool
+#endif
+#define HttpSetBufferPool _HttpSetBufferPool
+
+#endif	// HTTPBUFFERPOOL_H
@@ -0,0 +1,236 @@
+#ifndef HTTPCACHE_H
+#define HTTPCACHE_H
+
+#include <HttpLib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Cache limits.
+// Number of responses kept in store.
+#define HTTP_CACHE_MAX_ENTRIES			16
+// Maximum key length: "host:port/path" with null-terminator.
+#define HTTP_CACHE_MAX_KEY				128
+// Maximum validator length (ETag, Last-Modified) with null-terminator.
+#define HTTP_CACHE_MAX_VALIDATOR		64
+// Store signature and layout version (memory-mapped stores are checked on open).
+#define HTTP_CACHE_MAGIC				"HCST"
+#define HTTP_CACHE_VERSION				1
+
+#ifdef __cplusplus
+extern "C" {
+#endif	// __cplusplus
+
+	/*
+		HttpCache keeps bodies of GET responses with their validators (ETag,
+		Last-Modified) in bounded store given by user: memory block or file mapped
+		into memory (Linux only, survives restarts). _HttpCacheSend sends request
+		only when needed: fresh response (Cache-Control max-age not exceeded) is served
+		without touching network, stale one is revalidated with If-None-Match /
+		If-Modified-Since and 304 response is served from store.
+		Only 200 responses with validator or max-age are stored ('no-store' ones
+		never, 'no-cache' ones are revalidated every time). Vary and Expires are not
+		supported. Bodies are stored as received (see _HttpRecvLarge), so cache
+		should not be combined with inflater.
+		Least recently used responses are evicted when store is full. Cache serves
+		one request at a time and is not synchronized.
+	*/
+
+	///////////////////////////////////////////////////////////////////////////////
+	// How last request was served.
+	typedef enum HttpCacheResult {
+		// Not cacheable (not GET request, no key), response comes from network only.
+		HTTP_CACHE_BYPASS,
+		// Not in store (or store could not be used), response comes from network.
+		HTTP_CACHE_MISS,
+		// Fresh response served from store, nothing was sent.
+		HTTP_CACHE_HIT,
+		// Server confirmed stored response (304), it is served from store.
+		HTTP_CACHE_REVALIDATED
+	} HttpCacheResult;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Stored response. Entries live in store, so they persist with memory-mapped file.
+	typedef struct HttpCacheEntry {
+		// Key hash (0 - entry is free) and key.
+		unsigned int Hash;
+		char Key[HTTP_CACHE_MAX_KEY];
+		// Validators (empty - none).
+		char ETag[HTTP_CACHE_MAX_VALIDATOR];
+		char LastModified[HTTP_CACHE_MAX_VALIDATOR];
+		// Time response was stored or revalidated (seconds) and its freshness lifetime.
+		unsigned long StoredAt;
+		unsigned long MaxAge;
+		// Value of store use counter when entry was used last time (LRU).
+		unsigned long LastUsed;
+		// Body position in store data and its length.
+		unsigned int Offset;
+		unsigned int Length;
+	} HttpCacheEntry;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Store layout: this header, body data follows it.
+	typedef struct HttpCacheStore {
+		char Magic[4];
+		unsigned int Version;
+		// Size of whole store.
+		unsigned int Size;
+		// Bytes of data area taken by bodies (they are packed, free space is at the end).
+		unsigned int DataUsed;
+		unsigned long UseCounter;
+		HttpCacheEntry Entries[HTTP_CACHE_MAX_ENTRIES];
+	} HttpCacheStore;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Cache usage statistics.
+	typedef struct HttpCacheStats {
+		// Requests served from store without sending anything.
+		unsigned long Hits;
+		// Requests served from store after 304.
+		unsigned long Revalidated;
+		// Requests sent without usable entry (also revalidations answered with full response).
+		unsigned long Misses;
+		// Responses stored, not stored (not cacheable, too big) and entries evicted to make room.
+		unsigned long Stored;
+		unsigned long NotStored;
+		unsigned long Evicted;
+		// Bytes served from store.
+		HttpLength_t BytesServed;
+	} HttpCacheStats;
+
+	///////////////////////////////////////////////////////////////////////////////
+	typedef struct HttpCache {
+		HttpCacheStore* Store;
+		// Body data area (behind store header) and its size.
+		char* Data;
+		unsigned int DataSize;
+		// Mapped file descriptor (-1 - store is memory given by user).
+		int File;
+		// Last request: HttpCacheResult, its key and entry used (-1 - none).
+		unsigned char Result;
+		char Key[HTTP_CACHE_MAX_KEY];
+		unsigned int KeyHash;
+		int Entry;
+		// Stale entry found for last request (-1 - none), replaced by 200 response.
+		int Stale;
+		// Bytes of stored body served so far.
+		unsigned int ReadOffset;
+		// Response body being stored (at DataUsed offset) and its length.
+		unsigned char Storing;
+		unsigned int WriteLength;
+		HttpCacheStats Stats;
+	} HttpCache;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function initializes empty cache in memory block.
+	// Arguments:
+	// 1) Cache.
+	// 2) Store memory (aligned as for malloc).
+	// 3) Store size (bigger than HttpCacheStore).
+	// Returns: Non-zero value on error.
+	extern int _HttpCacheInit(HttpCache*, void*, unsigned int);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function opens cache kept in file mapped into memory (Linux only).
+	// Entries stored by previous run are used if file has the same size and layout,
+	// otherwise file is formatted.
+	// Arguments:
+	// 1) Cache.
+	// 2) File path (created if it does not exist).
+	// 3) Store size.
+	// Returns: Non-zero value on error (also on terminal).
+	extern int _HttpCacheOpenFile(HttpCache*, const char*, unsigned int);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function closes cache (mapped file is written back and unmapped).
+	extern void _HttpCacheClose(HttpCache*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function sends request unless it can be served from store. Request of
+	// stale entry gets its validators. Connected context is needed only when
+	// something is sent.
+	// Arguments:
+	// 1) Cache.
+	// 2) Valid HttpContext pointer.
+	// 3) Request builder (completed here if needed).
+	// Returns: Non-zero value on error (see _HttpSend). Result field tells how request was served.
+	extern int _HttpCacheSend(HttpCache*, HttpContext*, HttpRequestBuilder*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function receives response body (from store or from context, see _HttpRecvLarge).
+	// Cacheable response received from network is stored as it is read.
+	// Arguments:
+	// 1) Cache.
+	// 2) Valid HttpContext pointer.
+	// 3) Buffer.
+	// 4) Buffer size.
+	// 5) Number of bytes received.
+	// Returns: Non-zero value on error.
+	extern int _HttpCacheRecv(HttpCache*, HttpContext*, void*, size_t, size_t*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function checks if whole response body was received.
+	// Returns: Non-zero value if body was received completely.
+	extern int _HttpCacheIsResponseConsumed(const HttpCache*, const HttpContext*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function returns status of last response (200 for responses served from store).
+	// Returns: Non-zero value on error (response header not received).
+	extern int _HttpCacheGetStatus(const HttpCache*, const HttpContext*, unsigned short*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function drops all stored responses.
+	extern void _HttpCacheClear(HttpCache*);
+
+#ifdef __cplusplus
+}
+#endif	// __cplusplus
+
+///////////////////////////////////////////////////////////////////////////////
+// Set global names for cache interface functions.
+#ifdef HttpCacheInit
+#undef HttpCacheInit
+#endif
+#define HttpCacheInit _HttpCacheInit
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpCacheOpenFile
+#undef HttpCacheOpenFile
+#endif
+#define HttpCacheOpenFile _HttpCacheOpenFile
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpCacheClose
+#undef HttpCacheClose
+#endif
+#define HttpCacheClose _HttpCacheClose
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpCacheSend
+#undef HttpCacheSend
+#endif
+#define HttpCacheSend _HttpCacheSend
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpCacheRecv
+#undef HttpCacheRecv
+#endif
+#define HttpCacheRecv _HttpCacheRecv
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpCacheIsResponseConsumed
+#undef HttpCacheIsResponseConsumed
+#endif
+#define HttpCacheIsResponseConsumed _HttpCacheIsResponseConsumed
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpCacheGetStatus
+#undef HttpCacheGetStatus
+#endif
+#define HttpCacheGetStatus _HttpCacheGetStatus
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpCacheClear
+#undef HttpCacheClear
+#endif
+#define HttpCacheClear _HttpCacheClear
+
+#endif	// HTTPCACHE_H
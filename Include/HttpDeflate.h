@@ -0,0 +1,146 @@
+#ifndef HTTPDEFLATE_H
+#define HTTPDEFLATE_H
+
+#include <HttpLib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Size of compressed data window (size of chunks sent).
+#define HTTP_DEFLATE_OUTPUT_SIZE		4096
+// Compressor window size (log2) and hash memory level. Deflate state takes about
+// (1 << (WINDOW_BITS + 2)) + (1 << (MEM_LEVEL + 9)) bytes (96 KiB by default).
+#ifndef HTTP_DEFLATE_WINDOW_BITS
+#define HTTP_DEFLATE_WINDOW_BITS		13
+#endif
+#ifndef HTTP_DEFLATE_MEM_LEVEL
+#define HTTP_DEFLATE_MEM_LEVEL			7
+#endif
+// Default compression level (1 - fastest, 9 - smallest output).
+#define HTTP_DEFLATE_LEVEL				6
+// Bodies smaller than this are sent without compression by default.
+#define HTTP_DEFLATE_MIN_SIZE			1024
+
+#ifdef __cplusplus
+extern "C" {
+#endif	// __cplusplus
+
+	/*
+		HttpDeflater gzip-encodes request bodies while they are sent
+		('Content-Encoding: gzip'). Compressed size is not known in advance, so
+		body goes out in chunks (compressed body which fits in single output window
+		is sent with Content-Length). Deflate state is allocated once and reset for
+		every request. Remote host has to accept compressed requests.
+		Needs zlib, library has to be built with HTTPLIB_ZLIB defined; without it
+		bodies are sent uncompressed.
+	*/
+
+	///////////////////////////////////////////////////////////////////////////////
+	typedef struct HttpDeflater {
+		// zlib stream (internal).
+		void* Stream;
+		// Compressed data window and number of bytes waiting in it.
+		char* Output;
+		unsigned int OutputUsed;
+		// Bodies smaller than this are sent uncompressed (_HttpSendCompressed only).
+		size_t MinSize;
+		// Totals of body bytes given and compressed bytes sent (never reset by library).
+		HttpLength_t RawBytes;
+		HttpLength_t CompressedBytes;
+		// Bodies sent uncompressed because of MinSize.
+		unsigned long Skipped;
+	} HttpDeflater;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function allocates deflater state (global memory interface is used).
+	// Arguments:
+	// 1) Deflater.
+	// 2) Compression level (1 - 9, HTTP_DEFLATE_LEVEL).
+	// 3) Minimum body size to compress (HTTP_DEFLATE_MIN_SIZE), can be changed in structure later.
+	// Returns: Non-zero value on error (also when built without zlib).
+	extern int _HttpDeflaterInit(HttpDeflater*, int, size_t);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function frees deflater state. Contexts using it have to be detached first.
+	extern void _HttpDeflaterDestroy(HttpDeflater*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function makes context compress request bodies sent with functions below.
+	// Single deflater serves single context.
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Initialized deflater (NULL - detach, bodies are sent uncompressed).
+	// Returns: Non-zero value on error.
+	extern int _HttpSetDeflater(HttpContext*, HttpDeflater*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function sends request with body, compressed if context has deflater and body
+	// is not smaller than its MinSize. Body is not copied into request buffer, body
+	// set in builder (if any) is not sent. Legacy request buffer can be attached to builder
+	// (_HttpBuilderAttach).
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Request builder with request header.
+	// 3) Body.
+	// 4) Body size.
+	// Returns: Non-zero value on error.
+	extern int _HttpSendCompressed(HttpContext*, HttpRequestBuilder*, const void*, size_t);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function starts compressed chunked upload (see _HttpBeginChunkedUpload) of
+	// body of unknown size. Context has to have deflater.
+	// Returns: Non-zero value on error.
+	extern int _HttpBeginCompressedUpload(HttpContext*, HttpRequestBuilder*);
+	// This function compresses body data. Chunks are sent whenever output window fills up.
+	// Returns: Non-zero value on error.
+	extern int _HttpWriteCompressed(HttpContext*, const void*, size_t);
+	// This function sends rest of compressed body and ends upload (see _HttpEndChunkedUpload).
+	// Returns: Non-zero value on error.
+	extern int _HttpEndCompressedUpload(HttpContext*, const char* const*, unsigned int);
+
+#ifdef __cplusplus
+}
+#endif	// __cplusplus
+
+///////////////////////////////////////////////////////////////////////////////
+// Set global names for deflate interface functions.
+#ifdef HttpDeflaterInit
+#undef HttpDeflaterInit
+#endif
+#define HttpDeflaterInit _HttpDeflaterInit
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpDeflaterDestroy
+#undef HttpDeflaterDestroy
+#endif
+#define HttpDeflaterDestroy _HttpDeflaterDestroy
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpSetDeflater
+#undef HttpSetDeflater
+#endif
+#define HttpSetDeflater _HttpSetDeflater
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpSendCompressed
+#undef HttpSendCompressed
+#endif
+#define HttpSendCompressed _HttpSendCompressed
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpBeginCompressedUpload
+#undef HttpBeginCompressedUpload
+#endif
+#define HttpBeginCompressedUpload _HttpBeginCompressedUpload
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpWriteCompressed
+#undef HttpWriteCompressed
+#endif
+#define HttpWriteCompressed _HttpWriteCompressed
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpEndCompressedUpload
+#undef HttpEndCompressedUpload
+#endif
+#define HttpEndCompressedUpload _HttpEndCompressedUpload
+
+#endif	// HTTPDEFLATE_H
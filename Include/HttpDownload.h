@@ -0,0 +1,182 @@
+#ifndef HTTPDOWNLOAD_H
+#define HTTPDOWNLOAD_H
+
+#include <HttpLib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Download limits and defaults.
+// Maximum number of ranges file is split into (parallel mode).
+#define HTTP_DOWNLOAD_MAX_SEGMENTS		8
+// Ranges smaller than this are not split further.
+#define HTTP_DOWNLOAD_MIN_SEGMENT		(64 * 1024)
+// Maximum resource key length: "host:port/path" with null-terminator.
+#define HTTP_DOWNLOAD_MAX_KEY			128
+// Maximum validator length (ETag, Last-Modified) with null-terminator.
+#define HTTP_DOWNLOAD_MAX_VALIDATOR		64
+// Progress is saved after this many bytes are written.
+#define HTTP_DOWNLOAD_SAVE_INTERVAL		(256 * 1024)
+// Reconnections after transport error (HttpDownload::MaxRetries default).
+#define HTTP_DOWNLOAD_RETRIES			3
+// Unknown length (segment or file).
+#define HTTP_DOWNLOAD_UNKNOWN			((HttpLength_t)-1)
+// Progress file signature and layout version.
+#define HTTP_DOWNLOAD_MAGIC				"HDLS"
+#define HTTP_DOWNLOAD_VERSION			1
+// Errors (other negative values are transport errors, progress is kept).
+#define HTTP_DOWNLOAD_ERROR_ARGUMENT	-1
+#define HTTP_DOWNLOAD_ERROR_FILE		-10
+#define HTTP_DOWNLOAD_ERROR_RESPONSE	-11
+
+#ifdef __cplusplus
+extern "C" {
+#endif	// __cplusplus
+
+	/*
+		HttpDownload fetches single resource into file with GET requests carrying
+		Range property. Server answering 206 Partial Content gets asked only for bytes
+		still missing, Content-Range of every response is checked against them.
+		Progress (ranges and bytes already written, validator) is saved in small
+		progress file, so download interrupted by error, power loss or restart continues
+		where it stopped. If-Range with saved validator (strong ETag or Last-Modified)
+		makes server send whole new resource (200) if it changed meanwhile, download
+		then starts over. Servers without range support (200 to every request) work too,
+		just without resuming.
+		On Linux file can be split into ranges fetched in parallel over several
+		connections (see _HttpDownloadRunParallel), written into preallocated or
+		memory-mapped output file.
+	*/
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Range of file: first byte, length (HTTP_DOWNLOAD_UNKNOWN until server tells)
+	// and bytes already written.
+	typedef struct HttpDownloadSegment {
+		HttpLength_t Start;
+		HttpLength_t Length;
+		HttpLength_t Done;
+	} HttpDownloadSegment;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Download progress, this is what progress file holds.
+	typedef struct HttpDownloadState {
+		char Magic[4];
+		unsigned int Version;
+		// Resource progress belongs to: "host:port/path".
+		char Key[HTTP_DOWNLOAD_MAX_KEY];
+		// Validator sent in If-Range (empty - none, range is asked for without it).
+		char Validator[HTTP_DOWNLOAD_MAX_VALIDATOR];
+		// File size (HTTP_DOWNLOAD_UNKNOWN until server tells).
+		HttpLength_t Total;
+		// Ranges file is split into (they cover it without gaps).
+		unsigned int SegmentCount;
+		HttpDownloadSegment Segments[HTTP_DOWNLOAD_MAX_SEGMENTS];
+	} HttpDownloadState;
+
+	///////////////////////////////////////////////////////////////////////////////
+	typedef struct HttpDownload {
+		// Remote host (numeric address in parallel mode), port, SSL flag and requested site.
+		const char* Host;
+		unsigned short Port;
+		unsigned char Ssl;
+		const char* Path;
+		// Output file and progress file (NULL - progress is not saved).
+		const char* OutputPath;
+		const char* StatePath;
+		// Reconnections after transport error before download gives up.
+		unsigned int MaxRetries;
+		// Parallel mode writes into output file mapped into memory instead of pwrite calls.
+		unsigned char Mapped;
+		// Download progress.
+		HttpDownloadState State;
+		// Bytes received by this download, bytes found done in progress file,
+		// reconnections and restarts from file beginning (resource changed, no range support).
+		HttpLength_t Received;
+		HttpLength_t Resumed;
+		unsigned long Retries;
+		unsigned long Restarts;
+		// Output file descriptor, its mapping (parallel mode) and bytes written since progress was saved.
+		int File;
+		char* Map;
+		HttpLength_t Unsaved;
+	} HttpDownload;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function initializes download. Strings are not copied.
+	// Arguments:
+	// 1) Download.
+	// 2) Remote host.
+	// 3) Remote host port.
+	// 4) SSL usage flag.
+	// 5) Requested site (path).
+	// 6) Output file path.
+	// 7) Progress file path (NULL - progress is kept in memory only).
+	// Returns: Non-zero value on error.
+	extern int _HttpDownloadInit(HttpDownload*, const char*, unsigned short, unsigned char, const char*, const char*, const char*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function downloads missing ranges one after another over single
+	// connection (opened if context is not connected). Transport errors are retried
+	// MaxRetries times, then progress is saved and error returned, so download can be
+	// continued by another call (also after restart). Progress file is removed when
+	// download completes.
+	// Arguments:
+	// 1) Download.
+	// 2) Valid HttpContext pointer (blocking).
+	// Returns:
+	// 0 : Download complete.
+	// HTTP_DOWNLOAD_ERROR_ARGUMENT : Invalid arguments.
+	// HTTP_DOWNLOAD_ERROR_FILE : Output or progress file cannot be written.
+	// HTTP_DOWNLOAD_ERROR_RESPONSE : Server response cannot be used (status, Content-Range).
+	// Other negative value : Transport error.
+	extern int _HttpDownloadRun(HttpDownload*, HttpContext*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function downloads file split into ranges, fetched in parallel over given
+	// connections (see HttpAsync, HttpEpoll). File size is learned with one-byte
+	// range request first, output file is preallocated then. Resumed download keeps
+	// split of progress file. Server without range support gets single request
+	// (see _HttpDownloadRun). Linux only.
+	// Arguments:
+	// 1) Download.
+	// 2) Contexts (switched to non-blocking mode).
+	// 3) Number of contexts.
+	// Returns: See _HttpDownloadRun (error also on terminal).
+	extern int _HttpDownloadRunParallel(HttpDownload*, HttpContext*, unsigned int);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function returns download progress.
+	// Arguments:
+	// 1) Download.
+	// 2) Bytes written to output file.
+	// 3) File size (HTTP_DOWNLOAD_UNKNOWN if not known yet).
+	extern void _HttpDownloadGetProgress(const HttpDownload*, HttpLength_t*, HttpLength_t*);
+
+#ifdef __cplusplus
+}
+#endif	// __cplusplus
+
+///////////////////////////////////////////////////////////////////////////////
+// Set global names for download interface functions.
+#ifdef HttpDownloadInit
+#undef HttpDownloadInit
+#endif
+#define HttpDownloadInit _HttpDownloadInit
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpDownloadRun
+#undef HttpDownloadRun
+#endif
+#define HttpDownloadRun _HttpDownloadRun
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpDownloadRunParallel
+#undef HttpDownloadRunParallel
+#endif
+#define HttpDownloadRunParallel _HttpDownloadRunParallel
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpDownloadGetProgress
+#undef HttpDownloadGetProgress
+#endif
+#define HttpDownloadGetProgress _HttpDownloadGetProgress
+
+#endif	// HTTPDOWNLOAD_H
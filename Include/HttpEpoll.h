@@ -0,0 +1,84 @@
+#ifndef HTTPEPOLL_H
+#define HTTPEPOLL_H
+
+#include <HttpAsync.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Maximum number of events handled per epoll_wait call.
+#define HTTP_EPOLL_BATCH				256
+
+#ifdef __cplusplus
+extern "C" {
+#endif	// __cplusplus
+
+	/*
+		HttpEpoll drives HttpAsync requests with Linux epoll, so thousands of
+		requests run on single thread. Requests are not copied, they have to stay
+		valid until their completion handler is called. Linux only.
+	*/
+
+	///////////////////////////////////////////////////////////////////////////////
+	typedef struct HttpEpoll {
+		// epoll instance descriptor.
+		int Fd;
+		// Number of requests in progress.
+		unsigned int Active;
+	} HttpEpoll;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function creates epoll instance.
+	// Returns: Non-zero value on error.
+	extern int _HttpEpollInit(HttpEpoll*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function starts initialized request (see _HttpAsyncInit). First step is done
+	// right away, so completion handler may be called before this function returns.
+	// Completion handler may start new requests.
+	// Arguments:
+	// 1) Event loop.
+	// 2) Request.
+	extern void _HttpEpollStart(HttpEpoll*, HttpAsync*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function waits for events and advances ready requests until all requests
+	// complete or no event arrives within timeout.
+	// Arguments:
+	// 1) Event loop.
+	// 2) Timeout in miliseconds (negative - no timeout).
+	// Returns: Number of requests still in progress or negative value on error.
+	extern int _HttpEpollRun(HttpEpoll*, int);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function closes epoll instance. Requests in progress are not completed.
+	extern void _HttpEpollDestroy(HttpEpoll*);
+
+#ifdef __cplusplus
+}
+#endif	// __cplusplus
+
+///////////////////////////////////////////////////////////////////////////////
+// Set global names for epoll interface functions.
+#ifdef HttpEpollInit
+#undef HttpEpollInit
+#endif
+#define HttpEpollInit _HttpEpollInit
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpEpollStart
+#undef HttpEpollStart
+#endif
+#define HttpEpollStart _HttpEpollStart
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpEpollRun
+#undef HttpEpollRun
+#endif
+#define HttpEpollRun _HttpEpollRun
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpEpollDestroy
+#undef HttpEpollDestroy
+#endif
+#define HttpEpollDestroy _HttpEpollDestroy
+
+#endif	// HTTPEPOLL_H
@@ -0,0 +1,118 @@
+#ifndef HTTPINFLATE_H
+#define HTTPINFLATE_H
+
+#include <HttpLib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Size of window decoded body is passed to sinks in.
+#define HTTP_INFLATE_OUTPUT_SIZE		4096
+// Decoding errors.
+// Response uses content coding library does not decode (body can be received with _HttpRecvLarge).
+#define HTTP_INFLATE_ERROR_CODING		-3
+// Compressed stream is corrupted or truncated.
+#define HTTP_INFLATE_ERROR_DATA			-4
+
+#ifdef __cplusplus
+extern "C" {
+#endif	// __cplusplus
+
+	/*
+		HttpInflater decodes gzip and deflate response bodies (Content-Encoding)
+		while they are received. It stacks on top of both plain and chunked body
+		receiving: compressed bytes are inflated straight from DataBuffer, so
+		whole response is never buffered. Inflate state (with its 32 KiB window)
+		is allocated once and reset for every response.
+		Context with inflater asks for compressed responses (see _HttpSend).
+		Needs zlib, library has to be built with HTTPLIB_ZLIB defined.
+	*/
+
+	///////////////////////////////////////////////////////////////////////////////
+	typedef struct HttpInflater {
+		// zlib stream (internal).
+		void* Stream;
+		// Output window for sinks.
+		char* Output;
+		// Compressed bytes taken by current response stream (raw deflate fallback is possible until first output).
+		HttpLength_t ResponseIn;
+		// Raw deflate (no zlib header) is being decoded.
+		unsigned char RawDeflate;
+		// Output was full, inflater may hold more decoded data.
+		unsigned char Pending;
+		// Totals of compressed and decoded body bytes (never reset by library).
+		HttpLength_t CompressedBytes;
+		HttpLength_t DecodedBytes;
+	} HttpInflater;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function allocates inflater state (global memory interface is used).
+	// Returns: Non-zero value on error (also when built without zlib).
+	extern int _HttpInflaterInit(HttpInflater*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function frees inflater state. Contexts using it have to be detached first.
+	extern void _HttpInflaterDestroy(HttpInflater*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function makes context ask for compressed responses and decode them in
+	// _HttpRecvDecoded and _HttpRecvDecodedToSink. Single inflater serves single context.
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Initialized inflater (NULL - detach).
+	// Returns: Non-zero value on error.
+	extern int _HttpSetInflater(HttpContext*, HttpInflater*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function receives decoded response body (header is received on first call).
+	// Body which is not compressed (or context without inflater) is received as it is.
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Buffer.
+	// 3) Buffer size.
+	// 4) Number of decoded bytes received (also on error).
+	// Returns: Non-zero value on error (HTTP_INFLATE_ERROR_*, transport error).
+	// Less bytes than buffer size are received only at response end.
+	extern int _HttpRecvDecoded(HttpContext*, void*, size_t, size_t*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function receives response and passes decoded body to sink (see _HttpRecvToSink),
+	// at most HTTP_INFLATE_OUTPUT_SIZE bytes at once.
+	// Returns: 0 when body is complete, 1 when sink paused, -2 when sink aborted,
+	// other negative value on error.
+	extern int _HttpRecvDecodedToSink(HttpContext*, HttpBodySink_t, void*);
+
+#ifdef __cplusplus
+}
+#endif	// __cplusplus
+
+///////////////////////////////////////////////////////////////////////////////
+// Set global names for inflate interface functions.
+#ifdef HttpInflaterInit
+#undef HttpInflaterInit
+#endif
+#define HttpInflaterInit _HttpInflaterInit
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpInflaterDestroy
+#undef HttpInflaterDestroy
+#endif
+#define HttpInflaterDestroy _HttpInflaterDestroy
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpSetInflater
+#undef HttpSetInflater
+#endif
+#define HttpSetInflater _HttpSetInflater
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpRecvDecoded
+#undef HttpRecvDecoded
+#endif
+#define HttpRecvDecoded _HttpRecvDecoded
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpRecvDecodedToSink
+#undef HttpRecvDecodedToSink
+#endif
+#define HttpRecvDecodedToSink _HttpRecvDecodedToSink
+
+#endif	// HTTPINFLATE_H
@@ -3,11 +3,35 @@
 
 // For size_t.
 #include <string.h>
+// For transport interface.
+#include <HttpTransport.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 // Library defines.
 // This value is used for buffering response header data.
 #define HTTP_BUFFER_SIZE				256
+// Default limit DataBuffer can grow to, when single header property does not fit in it.
+#define HTTP_BUFFER_LIMIT				8192
+// Maximum number of response header properties indexed for lookup.
+#define HTTP_MAX_HEADERS				32
+// Number of hash slots in response header index (power of 2, more than HTTP_MAX_HEADERS).
+#define HTTP_HEADER_INDEX_SIZE			64
+// Maximum number of request header properties tracked by request builder.
+#define HTTP_MAX_REQUEST_PROPERTIES		32
+// Maximum number of trailer properties sent after chunked upload.
+#define HTTP_MAX_TRAILERS				8
+// Size of remote host name buffer in context (including null-terminator), fits full DNS name.
+#define HTTP_MAX_HOST_SIZE				254
+// Unread response body up to this size is drained before next request, bigger one is dropped with connection.
+#define HTTP_SKIP_BODY_LIMIT			16384
+// _HttpSkipBody limit draining whole body, also one ended by connection close.
+#define HTTP_SKIP_BODY_ALL				((HttpLength_t)-1)
+// Body sink results.
+#define HTTP_SINK_CONTINUE				0
+// Stop receiving, call _HttpRecvToSink again to resume.
+#define HTTP_SINK_PAUSE					1
+// Stop receiving (any other value aborts as well).
+#define HTTP_SINK_ABORT					-1
 #define HTTP_HEADER_TERMINATOR			"\r\n\r\n"
 #define HTTP_PROPERTY_DELIMITER         "\r\n"
 
@@ -17,12 +41,30 @@ extern "C" {
 
 	/*
 		HttpLib delivers tools for HTTP communication.
+		Thread safety: library keeps no mutable global state apart from global
+		memory interface (set once at startup), so contexts can be used from
+		different threads in parallel. Single context (and its pool, pipeline,
+		transport data) must not be used by two threads at once.
 	*/
 
 	///////////////////////////////////////////////////////////////////////////////
 	// Library memory allocator and deallocator type.
 	typedef void*(*Allocator_t)(size_t);
 	typedef void(*Deallocator_t)(void*);
+	// Body and chunk length type (bodies may exceed 4 GiB).
+	typedef unsigned long long HttpLength_t;
+
+	struct HttpContext;
+	struct HttpBufferPool;
+	struct HttpInflater;
+	struct HttpDeflater;
+	struct HttpStats;
+	// Handler of chunked body trailer property: context, name, name length, value,
+	// value length (both not null-terminated) and handler data.
+	typedef void(*HttpTrailerHandler_t)(struct HttpContext*, const char*, unsigned int, const char*, unsigned int, void*);
+	// Response body sink: context, body span (valid during call only), span size and sink data.
+	// Returns HTTP_SINK_* value.
+	typedef int(*HttpBodySink_t)(struct HttpContext*, const char*, unsigned int, void*);
 
 	///////////////////////////////////////////////////////////////////////////////
 	// Enumeration of HTTP versions.
@@ -40,6 +82,16 @@ extern "C" {
 		PUT
 	} HttpMethod;
 
+	///////////////////////////////////////////////////////////////////////////////
+	// Response body content codings (Content-Encoding).
+	typedef enum HttpContentCoding {
+		HTTP_CODING_IDENTITY,
+		HTTP_CODING_GZIP,
+		HTTP_CODING_DEFLATE,
+		// Coding (or list of codings) library does not decode.
+		HTTP_CODING_UNKNOWN
+	} HttpContentCoding;
+
 	///////////////////////////////////////////////////////////////////////////////
 	typedef enum HttpFlags {
 		TRANSFER_CHUNKED = 1,
@@ -47,9 +99,130 @@ extern "C" {
 		// Or if we have to first find chunk size.
 		READING_CHUNK = 2,
 		HEADER_RECEIVED = 4,
-		ENDING_CHUNK_REQUIRED = 8
+		ENDING_CHUNK_REQUIRED = 8,
+		// Transport connection is established (kept between requests).
+		CONNECTED = 16,
+		// Request body is being uploaded in chunks.
+		UPLOADING_CHUNKED = 32,
+		// Response has valid Content-Length property.
+		CONTENT_LENGTH_KNOWN = 64,
+		// Remote host closes connection after response ('Connection: close' or HTTP/1.0 without keep-alive).
+		CONNECTION_CLOSE = 128,
+		// Request sent uses HEAD method, so response has no body.
+		HEAD_REQUEST = 256,
+		// Request was sent, its response header was not received yet.
+		RESPONSE_PENDING = 512,
+		// Remote host closed connection while body was received (ends body without Content-Length).
+		CONNECTION_CLOSED = 1024,
+		// Non-blocking connect is in progress (call _HttpConnect again to finish it).
+		CONNECTING = 2048,
+		// Inflater was set up for current response body / its compressed stream ended.
+		INFLATING = 4096,
+		INFLATE_END = 8192
 	} HttpFlags;
 
+	///////////////////////////////////////////////////////////////////////////////
+	// Request builder. Tracks write cursor and property offsets, so request can be
+	// built without rescanning buffer. Every write is bounds checked and request
+	// is kept null-terminated.
+	typedef struct HttpRequestBuilder {
+		// Request buffer.
+		char* Buffer;
+		unsigned int Size;
+		// Request length (write cursor).
+		unsigned int Length;
+		// Offset behind last header property (where next property goes).
+		unsigned int HeaderEnd;
+		// Offset of body (valid when header is complete).
+		unsigned int BodyOffset;
+		// Offsets of header property lines.
+		unsigned short PropertyOffsets[HTTP_MAX_REQUEST_PROPERTIES];
+		unsigned char PropertyCount;
+		// Header is terminated with empty line.
+		unsigned char Complete;
+		// Number of bytes moved to make room for (or close gap after) properties and body.
+		unsigned long BytesMoved;
+	} HttpRequestBuilder;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Response header parser state.
+	// Parser is resumable: every received byte is processed exactly once,
+	// response header is kept at DataBuffer's beginning until next request.
+	typedef struct HttpResponseParser {
+		// Current parser state (internal).
+		unsigned char State;
+		// Number of matched characters of currently expected literal/token.
+		unsigned char Match;
+		// Id of known header property being parsed (internal).
+		unsigned char PropertyId;
+		// HTTP version from status line.
+		unsigned char VersionMajor;
+		unsigned char VersionMinor;
+		// Status code from status line.
+		unsigned short StatusCode;
+		// 'Connection: keep-alive' was received.
+		unsigned char KeepAlive;
+		// Body content coding from Content-Encoding (HttpContentCoding).
+		unsigned char ContentCoding;
+		// Known property names still matching property name being parsed (bit mask).
+		unsigned int Candidates;
+		// Length of property name being parsed.
+		unsigned int NameLength;
+		// Hash of lowercase property name being parsed.
+		unsigned int NameHash;
+		// Offsets of property being parsed: line start, value start and value end (trailing spaces excluded).
+		unsigned int LineOffset;
+		unsigned int ValueOffset;
+		unsigned int ValueEnd;
+		// Offset (in DataBuffer) of first byte not parsed yet.
+		unsigned int Position;
+		// Reason phrase offset (in DataBuffer) and length.
+		unsigned int ReasonOffset;
+		unsigned int ReasonLength;
+		// Complete header length (valid when header is received).
+		unsigned int HeaderLength;
+	} HttpResponseParser;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Response header property entry. Offsets point into DataBuffer.
+	typedef struct HttpHeaderEntry {
+		// Hash of lowercase property name.
+		unsigned int Hash;
+		unsigned short NameOffset;
+		unsigned short NameLength;
+		unsigned short ValueOffset;
+		unsigned short ValueLength;
+	} HttpHeaderEntry;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Response header properties table, built by parser.
+	typedef struct HttpHeaderTable {
+		// Properties in order of appearance.
+		HttpHeaderEntry Entries[HTTP_MAX_HEADERS];
+		// Hash index: entry number + 1 (0 - empty slot).
+		unsigned char Index[HTTP_HEADER_INDEX_SIZE];
+		// Number of entries.
+		unsigned char Count;
+		// Number of properties which did not fit in table.
+		unsigned char Dropped;
+	} HttpHeaderTable;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// DataBuffer usage statistics.
+	typedef struct HttpBufferStats {
+		// Number of bytes moved inside DataBuffer (compaction of unread data).
+		unsigned long BytesMoved;
+		// Number of compactions.
+		unsigned long Compactions;
+		// Number of times buffer grew (long header property) and shrunk back.
+		unsigned long Grows;
+		unsigned long Shrinks;
+		// Biggest buffer size allocated.
+		unsigned int PeakSize;
+		// Biggest amount of unread data held in buffer.
+		unsigned int PeakUsage;
+	} HttpBufferStats;
+
 	///////////////////////////////////////////////////////////////////////////////
 	typedef struct HttpContext {
 		// Session handle used for VCS communication.
@@ -61,18 +234,69 @@ extern "C" {
 		// Flags.
 		unsigned int Flags;
 		// Response content length.
-		unsigned int ContentLength;
+		HttpLength_t ContentLength;
 		// Buffer for data.
 		char* DataBuffer;
 		unsigned int DataBufferSize;
-		// Size of data currently stored in buffer.
-		unsigned int DataInBuffer;
+		// Read cursor: offset of first unread byte in buffer.
+		unsigned int DataHead;
+		// Write cursor: offset behind last received byte in buffer.
+		unsigned int DataTail;
 		// Current chunk size.
-		unsigned int ChunkSize;
+		HttpLength_t ChunkSize;
 		// Bytes of chunk already read.
-		unsigned int ChunkRead;
+		HttpLength_t ChunkRead;
 		// Socket connect timeout (in miliseconds).
 		unsigned short ConnectTimeout;
+		// Transport backend (NULL - platform default) and its data.
+		const HttpTransport* Transport;
+		void* TransportData;
+		// Socket descriptor used by POSIX transport.
+		int Socket;
+		// DataBuffer usage statistics (never reset by library).
+		HttpBufferStats BufferStats;
+		// Limit DataBuffer can grow to (0 - HTTP_BUFFER_LIMIT).
+		unsigned int DataBufferLimit;
+		// Response header parser.
+		HttpResponseParser Parser;
+		// Response header properties.
+		HttpHeaderTable Headers;
+		// Bytes of plain response body received so far.
+		HttpLength_t ContentRead;
+		// Remote host given to _HttpConnect, its port and SSL flag.
+		char RemoteHost[HTTP_MAX_HOST_SIZE];
+		unsigned short RemotePort;
+		unsigned char RemoteSsl;
+		// Chunked body decoder state and number of size digits parsed.
+		unsigned char ChunkState;
+		unsigned char ChunkDigits;
+		// Handler receiving chunked body trailer properties (can be NULL) and its data.
+		HttpTrailerHandler_t TrailerHandler;
+		void* TrailerHandlerData;
+		// Transport calls do not wait, they return HTTP_TRANSPORT_WOULD_BLOCK instead
+		// (POSIX transport, used by HttpAsync).
+		unsigned char NonBlocking;
+		// Memory interface of this context (NULL - global one), see _HttpSetContextMemoryInterface.
+		Allocator_t MemAlloc;
+		Deallocator_t MemFree;
+		// Deallocator matching current DataBuffer allocation (set by library).
+		Deallocator_t DataBufferFree;
+		// Buffer pool DataBuffer is borrowed from (NULL - allocate it), see _HttpSetBufferPool.
+		struct HttpBufferPool* BufferPool;
+		// Pool current DataBuffer was lent by (set by library).
+		struct HttpBufferPool* DataBufferPool;
+		// Decoder of compressed response bodies (NULL - bodies are not decoded), see _HttpSetInflater.
+		struct HttpInflater* Inflater;
+		// Compressor of request bodies (NULL - bodies are sent as they are), see _HttpSetDeflater.
+		struct HttpDeflater* Deflater;
+		// Performance counters (NULL - nothing is counted), see _HttpSetStats.
+		struct HttpStats* Stats;
+		// DataBuffer replaced while body was received: response header property values
+		// still point into it, so it is released with next request (set by library).
+		char* RetiredBuffer;
+		unsigned int RetiredBufferSize;
+		Deallocator_t RetiredBufferFree;
+		struct HttpBufferPool* RetiredBufferPool;
 	} HttpContext;
 
 	///////////////////////////////////////////////////////////////////////////////
@@ -110,6 +334,7 @@ extern "C" {
 	// Returns non-zero value on error.
 	// -1 : Property is not terminated correctly.
 	// -2 : Property not found.
+	// -3 : Buffer too small to store value.
 	extern int _HttpGetProperty(const char*, char*, int, const char*);
 
 	///////////////////////////////////////////////////////////////////////////////
@@ -124,17 +349,67 @@ extern "C" {
 	extern int _HttpSetRequestBody(const char*, char*, int);
 	// This function sets body to raw data (can cantain zeroes).
 	// Returns request size (in bytes). Important when sending binary data.
+	// -2 : Buffer too small to store body.
 	extern int _HttpSetRequestBodyRaw(const void*, int, char*, int);
 
+	///////////////////////////////////////////////////////////////////////////////
+	// This function initializes request builder and writes request line.
+	// Arguments:
+	// 1) Request builder.
+	// 2) Request buffer.
+	// 3) Request buffer size.
+	// 4) Request method.
+	// 5) Requested remote site.
+	// 6) HTTP protocol version.
+	// Returns: Non-zero value on error.
+	// -1 : Invalid buffer.
+	// -2 : Buffer too small.
+	extern int _HttpBuilderInit(HttpRequestBuilder*, char*, unsigned int, HttpMethod, const char*, HttpVersion);
+	// This function initializes request builder over request already stored in buffer (null-terminated).
+	// Returns: Non-zero value on error.
+	extern int _HttpBuilderAttach(HttpRequestBuilder*, char*, unsigned int);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function sets request property. Property with the same name (case-insensitive)
+	// is replaced, otherwise new property is appended to header.
+	// Arguments:
+	// 1) Request builder.
+	// 2) Property name.
+	// 3) Property value.
+	// Returns: Non-zero value on error.
+	// -2 : Buffer too small (or too many properties).
+	extern int _HttpBuilderSetProperty(HttpRequestBuilder*, const char*, const char*);
+	// This function sets request property with numeric value.
+	extern int _HttpBuilderSetPropertyNumber(HttpRequestBuilder*, const char*, unsigned long);
+	// This function removes request property (case-insensitive name).
+	// Returns: Non-zero value on error.
+	// -2 : Property not found.
+	extern int _HttpBuilderRemoveProperty(HttpRequestBuilder*, const char*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function terminates request header (if not terminated yet).
+	// Returns:
+	// >= 0 : Request size.
+	// < 0 : On error.
+	extern int _HttpBuilderComplete(HttpRequestBuilder*);
+	// This function sets Content-Length, terminates header and sets (replaces) request body.
+	// Body can contain zeroes.
+	// Returns:
+	// >= 0 : Request size.
+	// < 0 : On error.
+	extern int _HttpBuilderSetBody(HttpRequestBuilder*, const void*, unsigned int);
+
 	///////////////////////////////////////////////////////////////////////////////
 	// This function establishes connection with remote host, using given: url, port and SSL setting.
 	// Requires valid HttpContext object passes as argument.
 	// Arguments:
-	// 1) URL.
+	// 1) URL (shorter than HTTP_MAX_HOST_SIZE).
 	// 2) Remote host port number.
 	// 3) SSL usage flag (0 - do not use, other - use ssl).
 	// 4) Valid pointer to HttpContext.
 	// Returns: Non-zero value on error.
+	// HTTP_TRANSPORT_WOULD_BLOCK : Non-blocking connect in progress, call again with the same
+	// arguments when socket becomes writable.
 	extern int _HttpConnect(const char*, unsigned short, unsigned char, HttpContext*);
 
 	///////////////////////////////////////////////////////////////////////////////
@@ -148,15 +423,155 @@ extern "C" {
 
 	///////////////////////////////////////////////////////////////////////////////
 	// This function sends HTTP request over established connection.
+	// If context has inflater (see _HttpSetInflater) and request has no Accept-Encoding
+	// property, 'Accept-Encoding: gzip, deflate' is sent with it.
 	// Requires valid HttpContext pointer.
 	// Arguments:
 	// 1) Request (null-terminated string).
 	// 2) Valid HttpContext pointer.
 	// Returns: Non-zero value on error.
 	extern int _HttpSend(const void*, int, HttpContext*);
+	// This function sends request given as segments (i.e. header and body fragments), so
+	// body does not have to be copied behind header. Header has to contain Content-Length
+	// (see _HttpBuilderSetPropertyNumber and _HttpBuilderComplete).
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Segments.
+	// 3) Number of segments.
+	// Returns: Non-zero value on error.
+	extern int _HttpSendv(HttpContext*, const HttpIoVec*, unsigned int);
 
 	///////////////////////////////////////////////////////////////////////////////
+	// This function starts request with body of unknown size. It sets
+	// 'Transfer-Encoding: chunked' (and removes Content-Length), terminates
+	// header and sends it. Body set in builder (if any) is not sent.
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Request builder with request header.
+	// Returns: Non-zero value on error.
+	extern int _HttpBeginChunkedUpload(HttpContext*, HttpRequestBuilder*);
+	// This function sends single body chunk. Data is not copied, chunk framing
+	// is sent as separate segments. Empty chunk is not sent (it would end body).
+	// Returns: Non-zero value on error.
+	// -1 : Upload not started.
+	extern int _HttpWriteChunk(HttpContext*, const void*, unsigned int);
+	// This function ends chunked upload with last chunk and optional trailers.
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Trailers as name and value pairs: { name1, value1, name2, value2, ... } (can be NULL).
+	// 3) Number of trailers (pairs), at most HTTP_MAX_TRAILERS.
+	// Returns: Non-zero value on error.
+	extern int _HttpEndChunkedUpload(HttpContext*, const char* const*, unsigned int);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function receives response body (header is received on first call).
+	// Reads never go past body end, data behind it is kept for next response.
+	// Arguments:
+	// 1) Buffer.
+	// 2) Buffer size.
+	// 3) Valid HttpContext pointer.
+	// Returns: Number of bytes received, 0 at response end or on error
+	// (_HttpIsResponseConsumed tells which one).
 	extern int _HttpRecv(char*, int, HttpContext*);
+	// This function receives response body into big buffer. Buffer is filled up
+	// (each transport call asks for all bytes still missing), unless response ends first.
+	// Sizes are not limited to int (see _HttpRecv), bodies may exceed 4 GiB.
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Buffer.
+	// 3) Buffer size.
+	// 4) Number of bytes received (also on error).
+	// Returns: Non-zero value on error. Less bytes than buffer size are received
+	// only at response end (see _HttpIsResponseConsumed).
+	extern int _HttpRecvLarge(HttpContext*, void*, size_t, size_t*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function checks if whole response has been received: Content-Length bytes,
+	// last chunk with trailer, connection close (body without Content-Length) or
+	// response without body (HEAD request, 1xx, 204, 304).
+	// Returns: Non-zero value if response is complete.
+	extern int _HttpIsResponseConsumed(const HttpContext*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function receives response (header, if not received yet, and body) and passes
+	// body to sink in spans pointing straight into DataBuffer, so body is not copied.
+	// Chunk framing and trailer are not passed. Sink may pause receiving
+	// (HTTP_SINK_PAUSE), receiving resumes with next call.
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Body sink.
+	// 3) Sink data.
+	// Returns:
+	// 0 : Response complete.
+	// 1 : Paused by sink.
+	// -2 : Aborted by sink.
+	// Other negative value on error.
+	extern int _HttpRecvToSink(HttpContext*, HttpBodySink_t, void*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function drops rest of current response (any transfer type), so next
+	// request can be sent on the same connection. Body is received into DataBuffer
+	// in big reads and never copied out. If more than given number of bytes would have
+	// to be received, connection is closed instead (body ended by connection close
+	// counts as unlimited, unless limit is HTTP_SKIP_BODY_ALL).
+	// _HttpSend and friends call it with HTTP_SKIP_BODY_LIMIT (and reconnect).
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Maximum number of body bytes to drain (HTTP_SKIP_BODY_ALL - no limit).
+	// Returns:
+	// 0 : Response consumed, connection can be reused.
+	// 1 : Connection closed (also when body ended by connection close or remote host
+	// closes connection after response: Connection: close, HTTP/1.0 without keep-alive).
+	// < 0 : On error (connection closed).
+	extern int _HttpSkipBody(HttpContext*, HttpLength_t);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function sets handler receiving trailer properties of chunked responses.
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Handler (NULL - trailer is skipped).
+	// 3) Handler data.
+	// Returns: Non-zero value on error.
+	extern int _HttpSetTrailerHandler(HttpContext*, HttpTrailerHandler_t, void*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function gets response status line values.
+	// Valid after response header has been received (first _HttpRecv call).
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Status code (can be NULL).
+	// 3) HTTP version (can be NULL).
+	// 4) Reason phrase, not null-terminated (can be NULL).
+	// 5) Reason phrase length (can be NULL).
+	// Returns: Non-zero value if response header is not received.
+	extern int _HttpGetResponseStatus(const HttpContext*, unsigned short*, HttpVersion*, const char**, unsigned int*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function finds response header property (name is case-insensitive).
+	// Value is not copied, returned pointer is valid until next request on context
+	// (or disconnection), also while body is received.
+	// If property appears more than once, first occurence is returned.
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Property name (null-terminated).
+	// 3) Value pointer (not null-terminated).
+	// 4) Value length.
+	// Returns: Non-zero value on error.
+	// -1 : Response header not received.
+	// -2 : Property not found.
+	extern int _HttpGetResponseHeader(const HttpContext*, const char*, const char**, unsigned int*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function gets response header property by its position in header.
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Property index (0 .. Headers.Count - 1).
+	// 3) Name pointer (not null-terminated, can be NULL).
+	// 4) Name length (can be NULL).
+	// 5) Value pointer (not null-terminated, can be NULL).
+	// 6) Value length (can be NULL).
+	// Returns: Non-zero value if there is no such property.
+	extern int _HttpGetResponseHeaderAt(const HttpContext*, unsigned int, const char**, unsigned int*, const char**, unsigned int*);
 
 	///////////////////////////////////////////////////////////////////////////////
 	// This function checks underlying socket status and returns:
@@ -167,12 +582,25 @@ extern "C" {
 	///////////////////////////////////////////////////////////////////////////////
 	// This function is used to set library memory managment functions.
 	// Memory allocation and free.
+	// It is used by contexts without their own interface. It is not synchronized,
+	// call it before contexts are used (i.e. before threads start).
+	// Buffers allocated earlier are freed with deallocator they were allocated for.
 	// Arguments:
 	// Allocator_t - valid pointer to function allocating memory.
 	// Deallocator_t - valid pointer to function freeing allocated memory.
 	// Returns: Non-zero value on error.
 	extern int _HttpSetMemoryInterface(Allocator_t, Deallocator_t);
 
+	///////////////////////////////////////////////////////////////////////////////
+	// This function sets memory managment functions of single context.
+	// Can be called anytime, buffer allocated earlier is freed with its own deallocator.
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Allocator (NULL - use global one).
+	// 3) Deallocator (NULL only together with allocator).
+	// Returns: Non-zero value on error.
+	extern int _HttpSetContextMemoryInterface(HttpContext*, Allocator_t, Deallocator_t);
+
 #ifdef __cplusplus
 }
 #endif	// __cplusplus
@@ -202,12 +630,108 @@ extern "C" {
 #endif	// HttpSetRequestBody
 #define HttpSetRequestBody _HttpSetRequestBody
 
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpBuilderInit
+#undef HttpBuilderInit
+#endif
+#define HttpBuilderInit _HttpBuilderInit
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpBuilderAttach
+#undef HttpBuilderAttach
+#endif
+#define HttpBuilderAttach _HttpBuilderAttach
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpBuilderSetProperty
+#undef HttpBuilderSetProperty
+#endif
+#define HttpBuilderSetProperty _HttpBuilderSetProperty
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpBuilderSetPropertyNumber
+#undef HttpBuilderSetPropertyNumber
+#endif
+#define HttpBuilderSetPropertyNumber _HttpBuilderSetPropertyNumber
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpBuilderRemoveProperty
+#undef HttpBuilderRemoveProperty
+#endif
+#define HttpBuilderRemoveProperty _HttpBuilderRemoveProperty
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpBuilderComplete
+#undef HttpBuilderComplete
+#endif
+#define HttpBuilderComplete _HttpBuilderComplete
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpBuilderSetBody
+#undef HttpBuilderSetBody
+#endif
+#define HttpBuilderSetBody _HttpBuilderSetBody
+
 ///////////////////////////////////////////////////////////////////////////////
 #ifdef HttpSend
 #undef HttpSend
 #endif
 #define HttpSend _HttpSend
 
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpSendv
+#undef HttpSendv
+#endif
+#define HttpSendv _HttpSendv
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpBeginChunkedUpload
+#undef HttpBeginChunkedUpload
+#endif
+#define HttpBeginChunkedUpload _HttpBeginChunkedUpload
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpWriteChunk
+#undef HttpWriteChunk
+#endif
+#define HttpWriteChunk _HttpWriteChunk
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpEndChunkedUpload
+#undef HttpEndChunkedUpload
+#endif
+#define HttpEndChunkedUpload _HttpEndChunkedUpload
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpIsResponseConsumed
+#undef HttpIsResponseConsumed
+#endif
+#define HttpIsResponseConsumed _HttpIsResponseConsumed
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpRecvLarge
+#undef HttpRecvLarge
+#endif
+#define HttpRecvLarge _HttpRecvLarge
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpRecvToSink
+#undef HttpRecvToSink
+#endif
+#define HttpRecvToSink _HttpRecvToSink
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpSkipBody
+#undef HttpSkipBody
+#endif
+#define HttpSkipBody _HttpSkipBody
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpSetTrailerHandler
+#undef HttpSetTrailerHandler
+#endif
+#define HttpSetTrailerHandler _HttpSetTrailerHandler
+
 ///////////////////////////////////////////////////////////////////////////////
 #ifdef HttpRecv
 #undef HttpRecv
@@ -244,10 +768,34 @@ extern "C" {
 #endif
 #define HttpCompleteRequest _HttpCompleteRequest
 
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpGetResponseStatus
+#undef HttpGetResponseStatus
+#endif
+#define HttpGetResponseStatus _HttpGetResponseStatus
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpGetResponseHeader
+#undef HttpGetResponseHeader
+#endif
+#define HttpGetResponseHeader _HttpGetResponseHeader
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpGetResponseHeaderAt
+#undef HttpGetResponseHeaderAt
+#endif
+#define HttpGetResponseHeaderAt _HttpGetResponseHeaderAt
+
 ///////////////////////////////////////////////////////////////////////////////
 #ifdef HttpIsConnected
 #undef HttpIsConnected
 #endif
 #define HttpIsConnected _HttpIsConnected
 
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpSetContextMemoryInterface
+#undef HttpSetContextMemoryInterface
+#endif
+#define HttpSetContextMemoryInterface _HttpSetContextMemoryInterface
+
 #endif	// HTTPLIB_H
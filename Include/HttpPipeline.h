@@ -0,0 +1,112 @@
+#ifndef HTTPPIPELINE_H
+#define HTTPPIPELINE_H
+
+#include <HttpLib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Maximum number of requests in pipeline.
+#define HTTP_PIPELINE_DEPTH				8
+
+#ifdef __cplusplus
+extern "C" {
+#endif	// __cplusplus
+
+	/*
+		HttpPipeline sends several requests on single connection back-to-back
+		(HTTP/1.1 pipelining) and hands out responses in request order.
+		Requests are not copied, they have to stay valid until their responses
+		are received (they are resent if remote host closes connection).
+	*/
+
+	///////////////////////////////////////////////////////////////////////////////
+	typedef struct HttpPipeline {
+		// Connected context pipeline works on.
+		HttpContext* Context;
+		// Serialized requests.
+		HttpIoVec Requests[HTTP_PIPELINE_DEPTH];
+		// Number of queued requests.
+		unsigned int Count;
+		// Number of requests written to connection.
+		unsigned int Sent;
+		// Index of current response.
+		unsigned int Current;
+		// Current response has been handed out.
+		unsigned char Started;
+		// Number of reconnections allowed (default 1) and done.
+		unsigned int MaxRetries;
+		unsigned int Retries;
+	} HttpPipeline;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function initializes pipeline on connected context.
+	// Returns: Non-zero value on error.
+	extern int _HttpPipelineInit(HttpPipeline*, HttpContext*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function queues complete serialized request (header and body).
+	// Arguments:
+	// 1) Pipeline.
+	// 2) Request.
+	// 3) Request size.
+	// Returns: Non-zero value on error.
+	// -2 : Pipeline is full.
+	extern int _HttpPipelineQueue(HttpPipeline*, const void*, unsigned int);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function writes all queued requests not sent yet (in single vectored send).
+	// Returns: Non-zero value on error.
+	extern int _HttpPipelineFlush(HttpPipeline*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function moves to next response and receives its header. Rest of
+	// previous response body (if not read) is skipped. Body is read with _HttpRecv,
+	// which returns 0 at response end. Unsent requests are flushed first.
+	// If remote host closed connection before response arrived, connection is
+	// reopened and unanswered requests are sent again, but only if all of them
+	// are idempotent (GET, HEAD, PUT, DELETE, OPTIONS, TRACE).
+	// Returns:
+	// 0 : Response header received, see _HttpGetResponseStatus.
+	// 1 : All responses were handed out.
+	// < 0 : On error.
+	extern int _HttpPipelineNext(HttpPipeline*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function returns index (in queue order) of current response.
+	extern unsigned int _HttpPipelineCurrent(const HttpPipeline*);
+
+#ifdef __cplusplus
+}
+#endif	// __cplusplus
+
+///////////////////////////////////////////////////////////////////////////////
+// Set global names for pipeline interface functions.
+#ifdef HttpPipelineInit
+#undef HttpPipelineInit
+#endif
+#define HttpPipelineInit _HttpPipelineInit
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpPipelineQueue
+#undef HttpPipelineQueue
+#endif
+#define HttpPipelineQueue _HttpPipelineQueue
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpPipelineFlush
+#undef HttpPipelineFlush
+#endif
+#define HttpPipelineFlush _HttpPipelineFlush
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpPipelineNext
+#undef HttpPipelineNext
+#endif
+#define HttpPipelineNext _HttpPipelineNext
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpPipelineCurrent
+#undef HttpPipelineCurrent
+#endif
+#define HttpPipelineCurrent _HttpPipelineCurrent
+
+#endif	// HTTPPIPELINE_H
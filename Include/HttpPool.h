@@ -0,0 +1,145 @@
+#ifndef HTTPPOOL_H
+#define HTTPPOOL_H
+
+#include <HttpLib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Pool defaults.
+// Idle connection is closed after this time (in miliseconds).
+#define HTTP_POOL_IDLE_TIMEOUT			30000
+// Maximum number of connections to single (host, port, ssl).
+#define HTTP_POOL_MAX_PER_HOST			2
+
+#ifdef __cplusplus
+extern "C" {
+#endif	// __cplusplus
+
+	/*
+		HttpPool keeps connections open between requests (HTTP keep-alive), so
+		requests to the same remote host do not pay for connect (and SSL handshake).
+		Pool does not allocate memory, entries are given by user.
+	*/
+
+	///////////////////////////////////////////////////////////////////////////////
+	typedef enum HttpPoolEntryState {
+		// Entry holds no connection.
+		POOL_ENTRY_FREE,
+		// Connection is open and waits for request.
+		POOL_ENTRY_IDLE,
+		// Connection is checked out by user.
+		POOL_ENTRY_BUSY
+	} HttpPoolEntryState;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Pool entry. Context has to be first member (entry is found by context pointer).
+	typedef struct HttpPoolEntry {
+		HttpContext Context;
+		// HttpPoolEntryState.
+		unsigned char State;
+		// Tick (in miliseconds) when connection became idle.
+		unsigned long IdleSince;
+	} HttpPoolEntry;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Pool usage statistics.
+	typedef struct HttpPoolStats {
+		// Checkouts served with idle connection.
+		unsigned long Hits;
+		// Checkouts which had to connect.
+		unsigned long Misses;
+		// Idle connections closed on timeout, failed liveness check or to make room.
+		unsigned long Expired;
+		unsigned long Dead;
+		unsigned long Evicted;
+		// Connections closed on check in (body not consumed, 'Connection: close').
+		unsigned long NotReusable;
+	} HttpPoolStats;
+
+	///////////////////////////////////////////////////////////////////////////////
+	typedef struct HttpPool {
+		HttpPoolEntry* Entries;
+		unsigned int EntryCount;
+		// Idle timeout (in miliseconds, 0 - never expire).
+		unsigned long IdleTimeout;
+		// Maximum number of connections to single (host, port, ssl).
+		unsigned int MaxPerHost;
+		// Settings copied to new contexts (timeouts, transport).
+		HttpContext Template;
+		HttpPoolStats Stats;
+	} HttpPool;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function initializes pool.
+	// Arguments:
+	// 1) Pool.
+	// 2) Pool entries (pool size).
+	// 3) Number of entries.
+	// 4) Context settings: Timeout, RecvTimeout, ConnectTimeout, DataBufferLimit, Transport,
+	//    TransportData, memory interface and BufferPool are copied to pooled contexts (can be NULL).
+	// Returns: Non-zero value on error.
+	extern int _HttpPoolInit(HttpPool*, HttpPoolEntry*, unsigned int, const HttpContext*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function checks out connected context. Idle connection to the same
+	// (host, port, ssl) is reused if it is still alive, otherwise new one is made.
+	// Arguments:
+	// 1) Pool.
+	// 2) Remote host (shorter than HTTP_MAX_HOST_SIZE).
+	// 3) Remote port.
+	// 4) SSL flag.
+	// 5) Checked out context.
+	// Returns: Non-zero value on error.
+	// -1 : Invalid arguments.
+	// -2 : MaxPerHost connections to host are checked out.
+	// -3 : All entries are checked out.
+	// Other : Connect error.
+	extern int _HttpPoolAcquire(HttpPool*, const char*, unsigned short, unsigned char, HttpContext**);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function checks context in. Connection is kept open only if response
+	// has been received completely and remote host did not ask to close it.
+	// Returns: Non-zero value on error.
+	extern int _HttpPoolRelease(HttpPool*, HttpContext*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function closes idle connections which exceeded idle timeout.
+	extern void _HttpPoolPrune(HttpPool*);
+	// This function closes all connections (also checked out ones).
+	extern void _HttpPoolDestroy(HttpPool*);
+
+#ifdef __cplusplus
+}
+#endif	// __cplusplus
+
+///////////////////////////////////////////////////////////////////////////////
+// Set global names for pool interface functions.
+#ifdef HttpPoolInit
+#undef HttpPoolInit
+#endif
+#define HttpPoolInit _HttpPoolInit
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpPoolAcquire
+#undef HttpPoolAcquire
+#endif
+#define HttpPoolAcquire _HttpPoolAcquire
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpPoolRelease
+#undef HttpPoolRelease
+#endif
+#define HttpPoolRelease _HttpPoolRelease
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpPoolPrune
+#undef HttpPoolPrune
+#endif
+#define HttpPoolPrune _HttpPoolPrune
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpPoolDestroy
+#undef HttpPoolDestroy
+#endif
+#define HttpPoolDestroy _HttpPoolDestroy
+
+#endif	// HTTPPOOL_H
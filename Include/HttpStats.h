@@ -0,0 +1,199 @@
+#ifndef HTTPSTATS_H
+#define HTTPSTATS_H
+
+#include <HttpLib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of latency histogram buckets. Bucket 0 counts 0 ms, bucket i counts
+// [2^(i-1), 2^i) ms, last one everything longer (about 65 s and more).
+#define HTTP_STATS_BUCKETS				18
+
+#ifdef __cplusplus
+extern "C" {
+#endif	// __cplusplus
+
+	/*
+		HttpStats collects performance counters of single context: phase timestamps
+		of last connection and last request, bytes and transport calls, DataBuffer
+		moves and growth, retries. Counting is skipped for contexts without stats.
+		Timestamps are monotonic millisecond ticks (read_ticks on terminal), only
+		differences between them are meaningful.
+		Optional aggregator keeps latency histograms of phases; one aggregator can
+		collect from many contexts. Nothing is synchronized: stats and aggregator
+		must be used from one thread (give every thread its own aggregator).
+	*/
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Phases of connection and request-response exchange.
+	typedef enum HttpPhase {
+		// Connecting started (_HttpConnect, reconnection).
+		HTTP_PHASE_CONNECT_START,
+		// Transport session initialized (VCS session; not marked by other transports).
+		HTTP_PHASE_SESSION,
+		// Connection established (VCS does TLS handshake within connect, so it is included).
+		HTTP_PHASE_CONNECTED,
+		// Request sending started (previous response was skipped).
+		HTTP_PHASE_REQUEST_START,
+		// Whole request sent (chunked upload: after last chunk).
+		HTTP_PHASE_REQUEST_SENT,
+		// First response byte received.
+		HTTP_PHASE_FIRST_BYTE,
+		// Response header parsed.
+		HTTP_PHASE_HEADER,
+		// Response body complete.
+		HTTP_PHASE_BODY,
+		// Number of phases.
+		HTTP_PHASE_COUNT
+	} HttpPhase;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Latencies kept in aggregator histograms (time between phases).
+	typedef enum HttpLatency {
+		// CONNECT_START - SESSION.
+		HTTP_LATENCY_SESSION,
+		// SESSION (or CONNECT_START) - CONNECTED.
+		HTTP_LATENCY_CONNECT,
+		// REQUEST_START - REQUEST_SENT.
+		HTTP_LATENCY_SEND,
+		// REQUEST_SENT - FIRST_BYTE (time to first byte).
+		HTTP_LATENCY_FIRST_BYTE,
+		// FIRST_BYTE - HEADER.
+		HTTP_LATENCY_HEADER,
+		// HEADER - BODY.
+		HTTP_LATENCY_BODY,
+		// REQUEST_START - BODY.
+		HTTP_LATENCY_TOTAL,
+		// Number of latencies.
+		HTTP_LATENCY_COUNT
+	} HttpLatency;
+
+	///////////////////////////////////////////////////////////////////////////////
+	typedef struct HttpStatsAggregator {
+		// Latency histograms (see HTTP_STATS_BUCKETS).
+		unsigned long Histograms[HTTP_LATENCY_COUNT][HTTP_STATS_BUCKETS];
+		// Number of samples, their sum and maximum (ms).
+		unsigned long Count[HTTP_LATENCY_COUNT];
+		HttpLength_t Sum[HTTP_LATENCY_COUNT];
+		unsigned long Max[HTTP_LATENCY_COUNT];
+	} HttpStatsAggregator;
+
+	///////////////////////////////////////////////////////////////////////////////
+	typedef struct HttpStats {
+		// Phase timestamps (ms ticks) of last connection and last request.
+		unsigned long Timestamps[HTTP_PHASE_COUNT];
+		// Phases marked since connection (request) started, bit per phase.
+		unsigned int Marked;
+		// Bytes given to and received from transport.
+		HttpLength_t BytesSent;
+		HttpLength_t BytesReceived;
+		// Transport calls.
+		unsigned long SendCalls;
+		unsigned long RecvCalls;
+		unsigned long Connects;
+		// Requests started and responses completed.
+		unsigned long Requests;
+		unsigned long Responses;
+		// Reconnections to retry request (stale keep-alive connection, pipeline retry).
+		unsigned long Retries;
+		// Bytes moved inside DataBuffer and number of times it grew.
+		unsigned long BytesMoved;
+		unsigned long BufferGrows;
+		// Aggregator of latencies (NULL - none).
+		HttpStatsAggregator* Aggregator;
+	} HttpStats;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function clears stats.
+	// Arguments:
+	// 1) Stats.
+	// 2) Aggregator latencies go to (NULL - none).
+	// Returns: Non-zero value on error.
+	extern int _HttpStatsInit(HttpStats*, HttpStatsAggregator*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function attaches stats to context. Single stats serve single context.
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Initialized stats (NULL - detach, nothing is counted).
+	// Returns: Non-zero value on error.
+	extern int _HttpSetStats(HttpContext*, HttpStats*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function copies context stats.
+	// Returns: Non-zero value on error (also when context has no stats).
+	extern int _HttpStatsSnapshot(const HttpContext*, HttpStats*);
+	// This function clears context stats (aggregator stays attached).
+	// Returns: Non-zero value on error.
+	extern int _HttpStatsReset(HttpContext*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function returns time between two phases.
+	// Arguments:
+	// 1) Stats.
+	// 2) Earlier phase.
+	// 3) Later phase.
+	// 4) Time in ms.
+	// Returns: Non-zero value if any of phases was not marked.
+	extern int _HttpStatsPhaseTime(const HttpStats*, HttpPhase, HttpPhase, unsigned long*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function clears aggregator.
+	// Returns: Non-zero value on error.
+	extern int _HttpStatsAggregatorInit(HttpStatsAggregator*);
+	// This function returns latency (upper bound of histogram bucket, ms) given
+	// percent of samples does not exceed. Last bucket returns maximum seen.
+	// Arguments:
+	// 1) Aggregator.
+	// 2) Latency.
+	// 3) Percent (1 - 100).
+	// Returns: Latency, 0 if there are no samples.
+	extern unsigned long _HttpStatsPercentile(const HttpStatsAggregator*, HttpLatency, unsigned int);
+
+#ifdef __cplusplus
+}
+#endif	// __cplusplus
+
+///////////////////////////////////////////////////////////////////////////////
+// Set global names for stats interface functions.
+#ifdef HttpStatsInit
+#undef HttpStatsInit
+#endif
+#define HttpStatsInit _HttpStatsInit
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpSetStats
+#undef HttpSetStats
+#endif
+#define HttpSetStats _HttpSetStats
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpStatsSnapshot
+#undef HttpStatsSnapshot
+#endif
+#define HttpStatsSnapshot _HttpStatsSnapshot
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpStatsReset
+#undef HttpStatsReset
+#endif
+#define HttpStatsReset _HttpStatsReset
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpStatsPhaseTime
+#undef HttpStatsPhaseTime
+#endif
+#define HttpStatsPhaseTime _HttpStatsPhaseTime
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpStatsAggregatorInit
+#undef HttpStatsAggregatorInit
+#endif
+#define HttpStatsAggregatorInit _HttpStatsAggregatorInit
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpStatsPercentile
+#undef HttpStatsPercentile
+#endif
+#define HttpStatsPercentile _HttpStatsPercentile
+
+#endif	// HTTPSTATS_H
@@ -0,0 +1,154 @@
+#ifndef HTTPTRACE_H
+#define HTTPTRACE_H
+
+#include <HttpLib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace levels (library is built with HTTP_TRACE_LEVEL defined to one of them).
+// Events above build level are compiled out completely.
+// Default: DEBUG with HTTPLIB_TRACE_BINARY, INFO with LOGSYS_FLAG, otherwise OFF.
+#define HTTP_TRACE_LEVEL_OFF			0
+// Errors only.
+#define HTTP_TRACE_LEVEL_ERROR			1
+// Connection and request level events.
+#define HTTP_TRACE_LEVEL_INFO			2
+// Every received segment and chunk.
+#define HTTP_TRACE_LEVEL_DEBUG			3
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace file signature and version (see _HttpTraceExport).
+#define HTTP_TRACE_MAGIC				"HTRC"
+#define HTTP_TRACE_VERSION				1
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace events: identifier and format of arguments (printf, three unsigned int arguments).
+#define HTTP_TRACE_EVENTS(EVENT) \
+	EVENT(HTTP_EVENT_CONNECT,				"connect, port %u, ssl %u") \
+	EVENT(HTTP_EVENT_CONNECT_RESULT,		"connect result %d") \
+	EVENT(HTTP_EVENT_DISCONNECT,			"disconnect, force %u") \
+	EVENT(HTTP_EVENT_RECONNECT,				"previous response dropped with connection, reconnecting") \
+	EVENT(HTTP_EVENT_SEND,					"send, %u bytes") \
+	EVENT(HTTP_EVENT_SENDV,					"sendv, %u vectors") \
+	EVENT(HTTP_EVENT_UPLOAD_BEGIN,			"chunked upload begin, header %u bytes") \
+	EVENT(HTTP_EVENT_UPLOAD_END,			"chunked upload end, %u trailers") \
+	EVENT(HTTP_EVENT_BUFFER_GROWN,			"DataBuffer grown to %u") \
+	EVENT(HTTP_EVENT_BUFFER_ERROR,			"could not allocate DataBuffer of size %u") \
+	EVENT(HTTP_EVENT_HEADER_READ,			"reading header, %u bytes buffered") \
+	EVENT(HTTP_EVENT_HEADER_SEGMENT,		"header segment, %u bytes, %u buffered") \
+	EVENT(HTTP_EVENT_HEADER_LIMIT,			"no room for response header (buffer limit %u)") \
+	EVENT(HTTP_EVENT_HEADER_RECV_ERROR,		"no header data received, result %d") \
+	EVENT(HTTP_EVENT_HEADER_MALFORMED,		"malformed response header") \
+	EVENT(HTTP_EVENT_HEADER,				"header received, status %u, length %u, %u body bytes buffered") \
+	EVENT(HTTP_EVENT_CHUNK,					"chunk, %u bytes") \
+	EVENT(HTTP_EVENT_CHUNK_LAST,			"last chunk") \
+	EVENT(HTTP_EVENT_CHUNK_MALFORMED,		"malformed chunk framing") \
+	EVENT(HTTP_EVENT_CHUNK_NO_SPACE,		"no room for chunk framing") \
+	EVENT(HTTP_EVENT_RECV,					"received %u body bytes (buffer %u)") \
+	EVENT(HTTP_EVENT_RECV_ERROR,			"receiving error %d") \
+	EVENT(HTTP_EVENT_SKIP_TOO_BIG,			"body too big to drain (%u bytes left), closing connection") \
+	EVENT(HTTP_EVENT_SKIP_ERROR,			"response skipping error %d") \
+	EVENT(HTTP_EVENT_SINK_ABORT,			"receiving aborted by sink, %d") \
+	EVENT(HTTP_EVENT_INFLATE_RAW,			"no zlib wrapper, decoding raw deflate") \
+	EVENT(HTTP_EVENT_INFLATE_ERROR,			"inflate error %d") \
+	EVENT(HTTP_EVENT_CACHE_HIT,				"fresh response served from cache, %u bytes") \
+	EVENT(HTTP_EVENT_CACHE_REVALIDATED,		"not modified, response served from cache, %u bytes") \
+	EVENT(HTTP_EVENT_CACHE_STORED,			"response stored in cache, %u bytes") \
+	EVENT(HTTP_EVENT_CACHE_EVICTED,			"response evicted from cache, %u bytes") \
+	EVENT(HTTP_EVENT_DOWNLOAD_RESUMED,		"download resumed, %u bytes done in %u ranges") \
+	EVENT(HTTP_EVENT_DOWNLOAD_SPLIT,		"download split into %u ranges of %u bytes") \
+	EVENT(HTTP_EVENT_DOWNLOAD_RANGE,		"range requested from %u, %u bytes (0 - to end)") \
+	EVENT(HTTP_EVENT_DOWNLOAD_STATUS,		"unexpected download response status %u") \
+	EVENT(HTTP_EVENT_DOWNLOAD_RETRY,		"download request failed with %d, retry %u") \
+	EVENT(HTTP_EVENT_DOWNLOAD_RESTART,		"download restarted (status %u), %u bytes dropped") \
+	EVENT(HTTP_EVENT_PIPELINE_FLUSH,		"pipeline flush, %u requests queued, %u sent") \
+	EVENT(HTTP_EVENT_PIPELINE_NEXT,			"pipeline response %u of %u") \
+	EVENT(HTTP_EVENT_PIPELINE_RECONNECT,	"pipeline reconnects, resending %u requests") \
+	EVENT(HTTP_EVENT_DEFLATE_SEND,			"request body %u bytes, compressed %u") \
+	EVENT(HTTP_EVENT_ASYNC_FAILED,			"async request failed in state %u, result %d") \
+	EVENT(HTTP_EVENT_EPOLL_ERROR,			"epoll_ctl failed, errno %d")
+
+#ifdef __cplusplus
+extern "C" {
+#endif	// __cplusplus
+
+	/*
+		Tracing replaces formatted logging in library. Text mode (default) formats
+		events with LOG_PRINTF. Binary mode (library built with HTTPLIB_TRACE_BINARY)
+		does not format anything: fixed-size records go to ring buffer given with
+		_HttpTraceInit, which can be exported and decoded offline with
+		HttpTraceDecode tool (Tools directory). Ring keeps newest records.
+		Records are reserved atomically on POSIX, so contexts on many threads can
+		trace into single ring (on terminal single thread is assumed).
+	*/
+
+	///////////////////////////////////////////////////////////////////////////////
+#define HTTP_TRACE_ENUM(id, format) id,
+	typedef enum HttpTraceEvent {
+		HTTP_TRACE_EVENTS(HTTP_TRACE_ENUM)
+		// Number of events.
+		HTTP_EVENT_COUNT
+	} HttpTraceEvent;
+#undef HTTP_TRACE_ENUM
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Trace record (24 bytes, same layout on terminal and PC).
+	typedef struct HttpTraceRecord {
+		// Record number (from 1, 0 - slot not written).
+		unsigned int Sequence;
+		// Ticks (see HttpTraceFileHeader).
+		unsigned int Timestamp;
+		// HttpTraceEvent.
+		unsigned short Event;
+		// Context id (derived from context address).
+		unsigned short Context;
+		// Event arguments.
+		unsigned int Arguments[3];
+	} HttpTraceRecord;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Exported trace starts with this header, records follow (oldest first).
+	typedef struct HttpTraceFileHeader {
+		char Magic[4];
+		unsigned int Version;
+		unsigned int RecordSize;
+		unsigned int RecordCount;
+		// Timestamp ticks per second.
+		unsigned int TickRate;
+	} HttpTraceFileHeader;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function sets ring buffer for binary trace. It is not synchronized,
+	// call it before contexts are used.
+	// Arguments:
+	// 1) Records (NULL - stop tracing).
+	// 2) Number of records (power of two).
+	// Returns: Non-zero value on error (also when built without HTTPLIB_TRACE_BINARY).
+	extern int _HttpTraceInit(HttpTraceRecord*, unsigned int);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function writes trace file (header and records, oldest first) into buffer.
+	// Tracing should be stopped meanwhile, otherwise newest records may be torn.
+	// Arguments:
+	// 1) Buffer (NULL - only size is returned).
+	// 2) Buffer size.
+	// Returns: Number of bytes written (needed), negative value on error.
+	extern int _HttpTraceExport(void*, size_t);
+
+#ifdef __cplusplus
+}
+#endif	// __cplusplus
+
+///////////////////////////////////////////////////////////////////////////////
+// Set global names for trace interface functions.
+#ifdef HttpTraceInit
+#undef HttpTraceInit
+#endif
+#define HttpTraceInit _HttpTraceInit
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpTraceExport
+#undef HttpTraceExport
+#endif
+#define HttpTraceExport _HttpTraceExport
+
+#endif	// HTTPTRACE_H
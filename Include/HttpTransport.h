@@ -0,0 +1,171 @@
+#ifndef HTTPTRANSPORT_H
+#define HTTPTRANSPORT_H
+
+// For size_t.
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Transport result codes.
+// Backends may also return their own non-zero codes (i.e. VCS errors).
+#define HTTP_TRANSPORT_OK				0
+#define HTTP_TRANSPORT_ERROR			-100
+// Remote host closed connection (or loopback script ended).
+#define HTTP_TRANSPORT_CLOSED			-101
+// No data arrived within receive timeout.
+#define HTTP_TRANSPORT_TIMEOUT			-102
+// Requested feature is not supported by backend (i.e. SSL on POSIX).
+#define HTTP_TRANSPORT_UNSUPPORTED		-103
+// Operation can not progress without waiting (non-blocking context only).
+#define HTTP_TRANSPORT_WOULD_BLOCK		-104
+
+///////////////////////////////////////////////////////////////////////////////
+// Loopback backend flags.
+// Start replaying script from the beginning when it ends (infinite stream).
+#define HTTP_LOOPBACK_REPEAT			1
+
+#ifdef __cplusplus
+extern "C" {
+#endif	// __cplusplus
+
+	/*
+		HttpTransport delivers pluggable I/O backends for HttpLib.
+		Every byte HttpLib sends or receives goes through transport assigned to HttpContext.
+	*/
+
+	struct HttpContext;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Send segment (scatter-gather I/O).
+	typedef struct HttpIoVec {
+		const void* Data;
+		size_t Size;
+	} HttpIoVec;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Transport interface (vtable).
+	// All functions return zero on success and non-zero value on error.
+	typedef struct HttpTransport {
+		// Opens connection to: host, port, using SSL flag.
+		int(*Connect)(struct HttpContext*, const char*, unsigned short, unsigned char);
+		// Closes connection. Second argument is force flag.
+		int(*Disconnect)(struct HttpContext*, unsigned char);
+		// Sends whole given buffer.
+		int(*Send)(struct HttpContext*, const void*, size_t);
+		// Receives at most given number of bytes. Received bytes count is stored under last argument.
+		int(*Recv)(struct HttpContext*, void*, size_t, size_t*);
+		// Returns: 0 if not connected, anything other if connected.
+		int(*IsConnected)(const struct HttpContext*);
+		// Sends all given segments in order (optional, can be NULL).
+		// If not provided, segments are coalesced and sent with Send.
+		int(*Sendv)(struct HttpContext*, const HttpIoVec*, size_t);
+		// Sends as much of given buffer as possible without waiting (optional, can be NULL).
+		// Sent bytes count is stored under last argument. Returns HTTP_TRANSPORT_WOULD_BLOCK
+		// if nothing could be sent. Needed for non-blocking requests (see HttpAsync).
+		int(*SendSome)(struct HttpContext*, const void*, size_t, size_t*);
+	} HttpTransport;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Loopback backend state. Assign it as transport data of HttpContext.
+	// Script is a byte stream replayed to receiver, segmentation pattern decides
+	// how many bytes single receive call can return at most.
+	typedef struct HttpLoopback {
+		// Byte stream delivered to receiver.
+		const char* Script;
+		size_t ScriptSize;
+		// Sizes of consecutive receive segments (cycled). NULL - no segmentation.
+		// Zero-sized segment simulates receive timeout.
+		const size_t* Segments;
+		size_t SegmentCount;
+		// Loopback flags (HTTP_LOOPBACK_*).
+		unsigned int Flags;
+		// Script offset replay restarts from (HTTP_LOOPBACK_REPEAT), i.e. behind response header.
+		size_t RepeatOffset;
+		// Replay position in script.
+		size_t Position;
+		// Current segment index and bytes left in it.
+		size_t SegmentIndex;
+		size_t SegmentLeft;
+		// Optional buffer capturing sent data (can be NULL).
+		char* SentBuffer;
+		size_t SentBufferSize;
+		// Total number of bytes sent (also those not captured).
+		size_t SentSize;
+		// Number of transport calls.
+		unsigned long RecvCalls;
+		unsigned long SendCalls;
+		// Connection state.
+		unsigned char Connected;
+	} HttpLoopback;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function assigns transport backend to context.
+	// Arguments:
+	// 1) Valid HttpContext pointer.
+	// 2) Transport backend (NULL - use platform default).
+	// 3) Backend specific data (i.e. HttpLoopback pointer).
+	// Returns: Non-zero value on error.
+	extern int _HttpSetTransport(struct HttpContext*, const HttpTransport*, void*);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Backend getters. VCS backend is available in Evo build only, POSIX backend in Linux build only.
+	// VCS (Verix terminal) backend.
+	extern const HttpTransport* _HttpGetVcsTransport(void);
+	// POSIX TCP sockets backend (Linux).
+	extern const HttpTransport* _HttpGetPosixTransport(void);
+	// In-memory loopback backend.
+	extern const HttpTransport* _HttpGetLoopbackTransport(void);
+
+	///////////////////////////////////////////////////////////////////////////////
+	// This function initializes loopback state.
+	// Arguments:
+	// 1) Loopback state.
+	// 2) Script (bytes replayed to receiver).
+	// 3) Script size.
+	// 4) Segmentation pattern (can be NULL).
+	// 5) Number of segments in pattern.
+	extern void _HttpLoopbackInit(HttpLoopback*, const void*, size_t, const size_t*, size_t);
+	// This function rewinds script and segmentation pattern to the beginning.
+	extern void _HttpLoopbackRewind(HttpLoopback*);
+
+#ifdef __cplusplus
+}
+#endif	// __cplusplus
+
+///////////////////////////////////////////////////////////////////////////////
+// Set global names for transport interface functions.
+#ifdef HttpSetTransport
+#undef HttpSetTransport
+#endif
+#define HttpSetTransport _HttpSetTransport
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpGetVcsTransport
+#undef HttpGetVcsTransport
+#endif
+#define HttpGetVcsTransport _HttpGetVcsTransport
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpGetPosixTransport
+#undef HttpGetPosixTransport
+#endif
+#define HttpGetPosixTransport _HttpGetPosixTransport
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpGetLoopbackTransport
+#undef HttpGetLoopbackTransport
+#endif
+#define HttpGetLoopbackTransport _HttpGetLoopbackTransport
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpLoopbackInit
+#undef HttpLoopbackInit
+#endif
+#define HttpLoopbackInit _HttpLoopbackInit
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef HttpLoopbackRewind
+#undef HttpLoopbackRewind
+#endif
+#define HttpLoopbackRewind _HttpLoopbackRewind
+
+#endif	// HTTPTRANSPORT_H
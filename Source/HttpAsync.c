@@ -0,0 +1,137 @@
+#include "HttpLibPrivate.h"
+#include <HttpAsync.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// This sink drops body.
+static int _DropBody(HttpContext* ctx, const char* data, unsigned int size, void* sinkData) {
+	(void)ctx;
+	(void)data;
+	(void)size;
+	(void)sinkData;
+	return HTTP_SINK_CONTINUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function stores what request waits for.
+static int _Wait(HttpAsync* async, unsigned int events) {
+	async->WaitFd = async->Context->Socket;
+	async->WaitEvents = events;
+	return HTTP_ASYNC_WOULD_BLOCK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function ends request with error. Connection state is unknown, so it is closed.
+static int _Fail(HttpAsync* async, int result) {
+	HTTP_TRACE_ERROR(async->Context, HTTP_EVENT_ASYNC_FAILED, async->State, result, 0);
+	async->State = HTTP_ASYNC_FAILED;
+	async->Result = (result < 0 ? result : -1);
+	_HttpDisconnect(async->Context, 1);
+	return async->Result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function checks if previous response was left (partially) unread.
+static int _HasUnreadResponse(const HttpContext* ctx) {
+	if (ctx->Flags & UPLOADING_CHUNKED)
+		return 1;
+	if (ctx->Flags & HEADER_RECEIVED)
+		return !_HttpIsResponseConsumed(ctx);
+	return ((ctx->Flags & RESPONSE_PENDING) != 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpAsyncInit(HttpAsync* async, HttpContext* ctx, const char* host, unsigned short port, const void* request, size_t requestSize) {
+	if (async == NULL || ctx == NULL || request == NULL || requestSize == 0)
+		return -1;
+	memset(async, 0, sizeof(HttpAsync));
+	async->Context = ctx;
+	async->Host = host;
+	async->Port = port;
+	async->Request = (const char*)request;
+	async->RequestSize = requestSize;
+	async->WaitFd = -1;
+	ctx->NonBlocking = 1;
+	// Unfinished connect, unread response or connection closed by remote host would
+	// need waiting (reconnecting), connection is opened again by request then.
+	if ((ctx->Flags & CONNECTING)
+		|| ((ctx->Flags & CONNECTED) && (_HasUnreadResponse(ctx) || (ctx->Flags & (CONNECTION_CLOSE | CONNECTION_CLOSED)))))
+		_HttpDisconnect(ctx, 1);
+	// Nothing is left to skip, so this does not wait (on error connection is opened again).
+	if ((ctx->Flags & CONNECTED) && _HttpPrepareSend(ctx) != 0)
+		_HttpDisconnect(ctx, 1);
+	if (ctx->Flags & CONNECTED) {
+		async->State = HTTP_ASYNC_SENDING;
+	}
+	else {
+		if (host == NULL)
+			return -1;
+		async->State = HTTP_ASYNC_CONNECTING;
+	}
+	if (_HttpIsHeadRequest(request, (unsigned int)(requestSize > 5 ? 5 : requestSize)))
+		ctx->Flags |= HEAD_REQUEST;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpAsyncStep(HttpAsync* async) {
+	HttpContext* ctx = async->Context;
+	const HttpTransport* transport = _HttpGetTransport(ctx);
+	size_t sent = 0;
+	int result = 0;
+
+	while (1) {
+		switch (async->State) {
+		case HTTP_ASYNC_CONNECTING:
+			result = _HttpConnect(async->Host, async->Port, 0, ctx);
+			if (result == HTTP_TRANSPORT_WOULD_BLOCK)
+				return _Wait(async, HTTP_WAIT_WRITE);
+			if (result != 0)
+				return _Fail(async, result);
+			// Connection is new, nothing to skip before request.
+			HTTP_STATS_MARK(ctx, HTTP_PHASE_REQUEST_START);
+			async->State = HTTP_ASYNC_SENDING;
+			break;
+		case HTTP_ASYNC_SENDING:
+			if (transport->SendSome == NULL)
+				return _Fail(async, HTTP_TRANSPORT_UNSUPPORTED);
+			while (async->RequestSent < async->RequestSize) {
+				result = transport->SendSome(ctx, async->Request + async->RequestSent, async->RequestSize - async->RequestSent, &sent);
+				HTTP_STATS_SENT(ctx, sent);
+				if (result == HTTP_TRANSPORT_WOULD_BLOCK)
+					return _Wait(async, HTTP_WAIT_WRITE);
+				if (result != 0)
+					return _Fail(async, result);
+				async->RequestSent += sent;
+			}
+			ctx->Flags |= RESPONSE_PENDING;
+			HTTP_STATS_MARK(ctx, HTTP_PHASE_REQUEST_SENT);
+			async->State = HTTP_ASYNC_RECEIVING_HEADER;
+			break;
+		case HTTP_ASYNC_RECEIVING_HEADER:
+			// Parser keeps its state, header parsing resumes where it stopped.
+			result = _HttpReceiveHeader(ctx);
+			if (result == HTTP_TRANSPORT_WOULD_BLOCK)
+				return _Wait(async, HTTP_WAIT_READ);
+			if (result != 0)
+				return _Fail(async, result);
+			async->State = HTTP_ASYNC_RECEIVING_BODY;
+			break;
+		case HTTP_ASYNC_RECEIVING_BODY:
+			result = _HttpRecvToSink(ctx, (async->Sink ? async->Sink : _DropBody), async->SinkData);
+			// Sink paused, there is no one to resume it later.
+			if (result == 1)
+				break;
+			if (result == HTTP_TRANSPORT_WOULD_BLOCK)
+				return _Wait(async, HTTP_WAIT_READ);
+			if (result != 0)
+				return _Fail(async, result);
+			async->State = HTTP_ASYNC_COMPLETE;
+			async->Result = 0;
+			break;
+		case HTTP_ASYNC_COMPLETE:
+			return HTTP_ASYNC_DONE;
+		default:
+			return async->Result;
+		}
+	}
+}
@@ -0,0 +1,171 @@
+#include "HttpLibPrivate.h"
+#include <HttpBufferPool.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Arena buffers start at this alignment.
+#define HTTP_ARENA_ALIGNMENT			16
+// Size class index of buffers bigger than biggest class.
+#define HTTP_NO_SIZE_CLASS				HTTP_BUFFER_POOL_CLASSES
+
+///////////////////////////////////////////////////////////////////////////////
+// This function finds smallest size class given size fits in.
+static unsigned int _SizeClass(size_t size) {
+	unsigned int index = 0;
+	size_t classSize = HTTP_BUFFER_SIZE;
+
+	while (index < HTTP_BUFFER_POOL_CLASSES && classSize < size) {
+		classSize <<= 1;
+		index++;
+	}
+	return index;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static size_t _ClassSize(unsigned int index) {
+	return ((size_t)HTTP_BUFFER_SIZE << index);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _IsArenaBuffer(const HttpBufferPool* pool, const void* buffer) {
+	return (pool->Arena != NULL && (const char*)buffer >= pool->Arena && (const char*)buffer < pool->Arena + pool->ArenaSize);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function allocates buffer with pool's memory interface.
+static void* _Allocate(const HttpBufferPool* pool, size_t size) {
+	return (pool->MemAlloc && pool->MemFree ? pool->MemAlloc(size) : _HttpGlobalAlloc(size));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void _Free(const HttpBufferPool* pool, void* buffer) {
+	if (pool->MemAlloc && pool->MemFree)
+		pool->MemFree(buffer);
+	else
+		_HttpGlobalFree(buffer);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function carves buffer from arena.
+// Returns: Buffer or NULL if arena is exhausted.
+static void* _Carve(HttpBufferPool* pool, size_t size) {
+	char* buffer = NULL;
+
+	if (pool->Arena == NULL || pool->ArenaSize - pool->ArenaUsed < size)
+		return NULL;
+	buffer = pool->Arena + pool->ArenaUsed;
+	pool->ArenaUsed += size;
+	pool->Stats.ArenaCarves++;
+	return buffer;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpBufferPoolInit(HttpBufferPool* pool, void* arena, size_t arenaSize) {
+	unsigned int i = 0;
+	size_t skip = 0;
+
+	if (pool == NULL || (arena == NULL && arenaSize > 0))
+		return -1;
+	memset(pool, 0, sizeof(HttpBufferPool));
+	for (i = 0; i < HTTP_BUFFER_POOL_CLASSES; i++)
+		pool->Caps[i] = HTTP_BUFFER_POOL_CAP;
+	if (arena) {
+		// Class sizes are multiples of alignment, so aligned start keeps all buffers aligned.
+		skip = (HTTP_ARENA_ALIGNMENT - ((size_t)arena % HTTP_ARENA_ALIGNMENT)) % HTTP_ARENA_ALIGNMENT;
+		if (skip < arenaSize) {
+			pool->Arena = (char*)arena + skip;
+			pool->ArenaSize = arenaSize - skip;
+		}
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void* _HttpBufferPoolGet(HttpBufferPool* pool, size_t size) {
+	unsigned int index = _SizeClass(size);
+	void* buffer = NULL;
+
+	if (index == HTTP_NO_SIZE_CLASS) {
+		buffer = _Allocate(pool, size);
+		if (buffer == NULL) {
+			pool->Stats.Failures++;
+			return NULL;
+		}
+		pool->Stats.Oversized++;
+	}
+	else if (pool->FreeLists[index] != NULL) {
+		buffer = pool->FreeLists[index];
+		memcpy(&pool->FreeLists[index], buffer, sizeof(void*));
+		pool->FreeCounts[index]--;
+		pool->Stats.Cached -= _ClassSize(index);
+		pool->Stats.Hits++;
+		size = _ClassSize(index);
+	}
+	else {
+		size = _ClassSize(index);
+		buffer = _Carve(pool, size);
+		if (buffer == NULL)
+			buffer = _Allocate(pool, size);
+		if (buffer == NULL) {
+			pool->Stats.Failures++;
+			return NULL;
+		}
+		pool->Stats.Misses++;
+	}
+	pool->Stats.InUse += size;
+	if (pool->Stats.InUse > pool->Stats.PeakInUse)
+		pool->Stats.PeakInUse = pool->Stats.InUse;
+	return buffer;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpBufferPoolPut(HttpBufferPool* pool, void* buffer, size_t size) {
+	unsigned int index = _SizeClass(size);
+
+	if (buffer == NULL)
+		return;
+	if (index == HTTP_NO_SIZE_CLASS) {
+		pool->Stats.InUse -= size;
+		_Free(pool, buffer);
+		return;
+	}
+	pool->Stats.InUse -= _ClassSize(index);
+	// Arena memory can not go back to heap, it is always kept.
+	if (pool->FreeCounts[index] >= pool->Caps[index] && !_IsArenaBuffer(pool, buffer)) {
+		pool->Stats.Dropped++;
+		_Free(pool, buffer);
+		return;
+	}
+	memcpy(buffer, &pool->FreeLists[index], sizeof(void*));
+	pool->FreeLists[index] = buffer;
+	pool->FreeCounts[index]++;
+	pool->Stats.Cached += _ClassSize(index);
+	if (pool->Stats.Cached > pool->Stats.PeakCached)
+		pool->Stats.PeakCached = pool->Stats.Cached;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpBufferPoolDestroy(HttpBufferPool* pool) {
+	unsigned int i = 0;
+	void* buffer = NULL;
+
+	for (i = 0; i < HTTP_BUFFER_POOL_CLASSES; i++) {
+		while (pool->FreeLists[i] != NULL) {
+			buffer = pool->FreeLists[i];
+			memcpy(&pool->FreeLists[i], buffer, sizeof(void*));
+			if (!_IsArenaBuffer(pool, buffer))
+				_Free(pool, buffer);
+		}
+		pool->FreeCounts[i] = 0;
+	}
+	pool->Stats.Cached = 0;
+	pool->ArenaUsed = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSetBufferPool(HttpContext* ctx, HttpBufferPool* pool) {
+	if (ctx == NULL)
+		return -1;
+	// Current buffer keeps pool it was lent by.
+	ctx->BufferPool = pool;
+	return 0;
+}
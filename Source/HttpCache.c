@@ -0,0 +1,510 @@
+#include "HttpLibPrivate.h"
+#include <HttpCache.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef HTTPLIB_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif	// HTTPLIB_POSIX
+
+///////////////////////////////////////////////////////////////////////////////
+// Entry time (seconds). Wall clock on Linux, so mapped store survives restarts.
+#ifdef HTTPLIB_POSIX
+#define CACHE_NOW()						((unsigned long)time(NULL))
+#else
+#define CACHE_NOW()						(HTTP_TICKS() / 1000)
+#endif	// HTTPLIB_POSIX
+
+///////////////////////////////////////////////////////////////////////////////
+// Request properties sent to revalidate stale entry.
+static const char IfNoneMatchText[] = "If-None-Match";
+static const char IfModifiedSinceText[] = "If-Modified-Since";
+
+///////////////////////////////////////////////////////////////////////////////
+// This function formats empty store.
+static void _FormatStore(HttpCache* cache, unsigned int size) {
+	memset(cache->Store, 0, sizeof(HttpCacheStore));
+	memcpy(cache->Store->Magic, HTTP_CACHE_MAGIC, sizeof(cache->Store->Magic));
+	cache->Store->Version = HTTP_CACHE_VERSION;
+	cache->Store->Size = size;
+}
+
+#ifdef HTTPLIB_POSIX
+///////////////////////////////////////////////////////////////////////////////
+// This function checks if store (mapped file) is formatted and consistent.
+// Returns: Non-zero value if store can be used.
+static int _IsStoreValid(const HttpCacheStore* store, unsigned int size) {
+	unsigned int dataSize = size - sizeof(HttpCacheStore);
+	unsigned int i = 0;
+
+	if (memcmp(store->Magic, HTTP_CACHE_MAGIC, sizeof(store->Magic)) != 0 || store->Version != HTTP_CACHE_VERSION)
+		return 0;
+	if (store->Size != size || store->DataUsed > dataSize)
+		return 0;
+	for (i = 0; i < HTTP_CACHE_MAX_ENTRIES; i++) {
+		if (store->Entries[i].Hash == 0)
+			continue;
+		if (store->Entries[i].Offset > store->DataUsed || store->Entries[i].Length > store->DataUsed - store->Entries[i].Offset)
+			return 0;
+		if (memchr(store->Entries[i].Key, '\0', HTTP_CACHE_MAX_KEY) == NULL)
+			return 0;
+	}
+	return 1;
+}
+#endif	// HTTPLIB_POSIX
+
+///////////////////////////////////////////////////////////////////////////////
+// This function sets up cache over formatted store.
+static void _AttachStore(HttpCache* cache, void* store, unsigned int size, int file) {
+	memset(cache, 0, sizeof(HttpCache));
+	cache->Store = (HttpCacheStore*)store;
+	cache->Data = (char*)store + sizeof(HttpCacheStore);
+	cache->DataSize = size - sizeof(HttpCacheStore);
+	cache->File = file;
+	cache->Entry = -1;
+	cache->Stale = -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function makes cache key of GET request: "host:port/path".
+// Returns: Non-zero value if request cannot be cached.
+static int _MakeKey(HttpCache* cache, const HttpContext* ctx, const HttpRequestBuilder* builder) {
+	const char* path = NULL;
+	const char* pathEnd = NULL;
+	unsigned int hostLength = 0;
+	unsigned int hash = HTTP_HASH_INIT;
+	int length = 0;
+	int i = 0;
+
+	if (builder->Buffer == NULL || builder->Length < 4 || memcmp(builder->Buffer, "GET ", 4) != 0)
+		return -1;
+	path = builder->Buffer + 4;
+	pathEnd = memchr(path, ' ', builder->Length - 4);
+	hostLength = (unsigned int)strlen(ctx->RemoteHost);
+	if (pathEnd == NULL || hostLength == 0)
+		return -1;
+	// Host, colon, port (5 digits at most), path and terminator.
+	if (hostLength + 6 + (unsigned int)(pathEnd - path) + 1 > HTTP_CACHE_MAX_KEY)
+		return -1;
+	memcpy(cache->Key, ctx->RemoteHost, hostLength);
+	length = (int)hostLength + sprintf(cache->Key + hostLength, ":%u", (unsigned int)ctx->RemotePort);
+	memcpy(cache->Key + length, path, (size_t)(pathEnd - path));
+	length += (int)(pathEnd - path);
+	cache->Key[length] = '\0';
+	for (i = 0; i < length; i++)
+		hash = HTTP_HASH_STEP(hash, cache->Key[i]);
+	// Hash 0 marks free entry.
+	cache->KeyHash = (hash != 0 ? hash : 1);
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Returns: Index of entry with cache key, -1 if there is none.
+static int _FindEntry(const HttpCache* cache) {
+	const HttpCacheEntry* entry = NULL;
+	int i = 0;
+
+	for (i = 0; i < HTTP_CACHE_MAX_ENTRIES; i++) {
+		entry = &cache->Store->Entries[i];
+		if (entry->Hash == cache->KeyHash && strcmp(entry->Key, cache->Key) == 0)
+			return i;
+	}
+	return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function drops entry. Bodies behind it (and body being stored) are moved
+// down, so free space stays at data end.
+static void _FreeEntry(HttpCache* cache, int index) {
+	HttpCacheEntry* entry = &cache->Store->Entries[index];
+	unsigned int end = cache->Store->DataUsed + (cache->Storing ? cache->WriteLength : 0);
+	unsigned int i = 0;
+
+	if (entry->Hash == 0)
+		return;
+	memmove(cache->Data + entry->Offset, cache->Data + entry->Offset + entry->Length, end - entry->Offset - entry->Length);
+	for (i = 0; i < HTTP_CACHE_MAX_ENTRIES; i++) {
+		if (cache->Store->Entries[i].Hash != 0 && cache->Store->Entries[i].Offset > entry->Offset)
+			cache->Store->Entries[i].Offset -= entry->Length;
+	}
+	cache->Store->DataUsed -= entry->Length;
+	entry->Hash = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function evicts least recently used entry.
+// Returns: Non-zero value if store is empty.
+static int _EvictEntry(HttpCache* cache) {
+	HttpCacheEntry* entries = cache->Store->Entries;
+	int oldest = -1;
+	int i = 0;
+
+	for (i = 0; i < HTTP_CACHE_MAX_ENTRIES; i++) {
+		if (entries[i].Hash != 0 && (oldest < 0 || entries[i].LastUsed < entries[oldest].LastUsed))
+			oldest = i;
+	}
+	if (oldest < 0)
+		return -1;
+	HTTP_TRACE_INFO(NULL, HTTP_EVENT_CACHE_EVICTED, entries[oldest].Length, 0, 0);
+	_FreeEntry(cache, oldest);
+	cache->Stats.Evicted++;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function checks if Cache-Control directive matches name (case-insensitive).
+static int _IsDirective(const char* directive, unsigned int length, const char* name) {
+	unsigned int i = 0;
+
+	for (i = 0; i < length && name[i] != '\0'; i++) {
+		if (HTTP_TO_LOWER(directive[i]) != name[i])
+			return 0;
+	}
+	return (i == length && name[i] == '\0');
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function reads response freshness lifetime from Cache-Control (max-age less Age).
+// Returns: Non-zero value if response must not be stored ('no-store').
+static int _ReadCacheControl(const HttpContext* ctx, unsigned long* maxAge) {
+	const char* value = NULL;
+	const char* end = NULL;
+	unsigned int length = 0;
+	unsigned int nameLength = 0;
+	unsigned long age = 0;
+	unsigned char noCache = 0;
+
+	*maxAge = 0;
+	if (_HttpGetResponseHeader(ctx, "Cache-Control", &value, &length) != 0)
+		return 0;
+	end = value + length;
+	while (value < end) {
+		while (value < end && (*value == ' ' || *value == ','))
+			value++;
+		for (nameLength = 0; value + nameLength < end && value[nameLength] != ',' && value[nameLength] != '=' && value[nameLength] != ' '; nameLength++)
+			;
+		if (_IsDirective(value, nameLength, "no-store"))
+			return 1;
+		if (_IsDirective(value, nameLength, "no-cache"))
+			noCache = 1;
+		value += nameLength;
+		if (_IsDirective(value - nameLength, nameLength, "max-age") && value < end && *value == '=') {
+			// Lifetimes over 68 years are cut.
+			for (value++; value < end && *value >= '0' && *value <= '9'; value++)
+				*maxAge = (*maxAge < 0x7FFFFFFFul / 10 ? *maxAge * 10 + (unsigned long)(*value - '0') : 0x7FFFFFFFul);
+		}
+		while (value < end && *value != ',')
+			value++;
+	}
+	if (noCache)
+		*maxAge = 0;
+	// Response could wait in other caches already.
+	if (*maxAge > 0 && _HttpGetResponseHeader(ctx, "Age", &value, &length) == 0) {
+		for (end = value + length; value < end && *value >= '0' && *value <= '9'; value++)
+			age = (age < 0x7FFFFFFFul / 10 ? age * 10 + (unsigned long)(*value - '0') : 0x7FFFFFFFul);
+		*maxAge = (age < *maxAge ? *maxAge - age : 0);
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Returns: Non-zero value if response has property.
+static int _HasProperty(const HttpContext* ctx, const char* name) {
+	const char* value = NULL;
+	unsigned int length = 0;
+
+	return (_HttpGetResponseHeader(ctx, name, &value, &length) == 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function copies response property into entry field (empty if there is none or it is too long).
+static void _CopyProperty(const HttpContext* ctx, const char* name, char* destination) {
+	const char* value = NULL;
+	unsigned int length = 0;
+
+	destination[0] = '\0';
+	if (_HttpGetResponseHeader(ctx, name, &value, &length) != 0 || length >= HTTP_CACHE_MAX_VALIDATOR)
+		return;
+	memcpy(destination, value, length);
+	destination[length] = '\0';
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function handles response header: 304 switches to stored body, cacheable
+// 200 response gets entry its body is stored into while it is received.
+static void _OnResponseHeader(HttpCache* cache, HttpContext* ctx) {
+	HttpCacheEntry* entry = NULL;
+	unsigned long maxAge = 0;
+	int index = cache->Entry;
+	int i = 0;
+
+	if (cache->Result == HTTP_CACHE_BYPASS)
+		return;
+	if (ctx->Parser.StatusCode == 304 && index >= 0) {
+		entry = &cache->Store->Entries[index];
+		// 304 updates freshness and validators, missing ones are kept.
+		if (_HasProperty(ctx, "Cache-Control") && !_ReadCacheControl(ctx, &maxAge))
+			entry->MaxAge = maxAge;
+		if (_HasProperty(ctx, "ETag"))
+			_CopyProperty(ctx, "ETag", entry->ETag);
+		entry->StoredAt = CACHE_NOW();
+		entry->LastUsed = ++cache->Store->UseCounter;
+		cache->Result = HTTP_CACHE_REVALIDATED;
+		cache->Stats.Revalidated++;
+		HTTP_TRACE_INFO(ctx, HTTP_EVENT_CACHE_REVALIDATED, entry->Length, 0, 0);
+		return;
+	}
+	cache->Result = HTTP_CACHE_MISS;
+	cache->Stats.Misses++;
+	cache->Entry = -1;
+	if (ctx->Parser.StatusCode != 200)
+		return;
+	// Stored response is outdated by new one (also when request was sent without validators).
+	index = cache->Stale;
+	cache->Stale = -1;
+	if (index >= 0 && cache->Store->Entries[index].Hash == cache->KeyHash && strcmp(cache->Store->Entries[index].Key, cache->Key) == 0)
+		_FreeEntry(cache, index);
+	if (_ReadCacheControl(ctx, &maxAge) != 0
+		|| ((ctx->Flags & CONTENT_LENGTH_KNOWN) && ctx->ContentLength > cache->DataSize)
+		|| (maxAge == 0 && !_HasProperty(ctx, "ETag") && !_HasProperty(ctx, "Last-Modified"))) {
+		cache->Stats.NotStored++;
+		return;
+	}
+	for (i = 0; i < HTTP_CACHE_MAX_ENTRIES && cache->Store->Entries[i].Hash != 0; i++)
+		;
+	if (i == HTTP_CACHE_MAX_ENTRIES) {
+		_EvictEntry(cache);
+		for (i = 0; cache->Store->Entries[i].Hash != 0; i++)
+			;
+	}
+	// Room for known body is made now, other bodies evict entries as they grow.
+	while ((ctx->Flags & CONTENT_LENGTH_KNOWN) && cache->DataSize - cache->Store->DataUsed < ctx->ContentLength)
+		_EvictEntry(cache);
+	// Entry stays free (Hash 0) until body is complete.
+	entry = &cache->Store->Entries[i];
+	strcpy(entry->Key, cache->Key);
+	_CopyProperty(ctx, "ETag", entry->ETag);
+	_CopyProperty(ctx, "Last-Modified", entry->LastModified);
+	entry->StoredAt = CACHE_NOW();
+	entry->MaxAge = maxAge;
+	cache->Entry = i;
+	cache->Storing = 1;
+	cache->WriteLength = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function appends received body part to body being stored.
+static void _StoreBody(HttpCache* cache, const void* data, size_t size) {
+	while (cache->DataSize - cache->Store->DataUsed - cache->WriteLength < size) {
+		if (_EvictEntry(cache) != 0) {
+			cache->Storing = 0;
+			cache->Entry = -1;
+			cache->Stats.NotStored++;
+			return;
+		}
+	}
+	memcpy(cache->Data + cache->Store->DataUsed + cache->WriteLength, data, size);
+	cache->WriteLength += (unsigned int)size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function makes entry of completely stored body visible.
+static void _CommitBody(HttpCache* cache, const HttpContext* ctx) {
+	HttpCacheEntry* entry = &cache->Store->Entries[cache->Entry];
+
+	entry->Offset = cache->Store->DataUsed;
+	entry->Length = cache->WriteLength;
+	entry->LastUsed = ++cache->Store->UseCounter;
+	cache->Store->DataUsed += cache->WriteLength;
+	entry->Hash = cache->KeyHash;
+	cache->Storing = 0;
+	cache->Stats.Stored++;
+	HTTP_TRACE_INFO(ctx, HTTP_EVENT_CACHE_STORED, entry->Length, 0, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function copies next part of stored body.
+static int _ServeBody(HttpCache* cache, void* buffer, size_t bufferSize, size_t* received) {
+	const HttpCacheEntry* entry = &cache->Store->Entries[cache->Entry];
+	size_t size = entry->Length - cache->ReadOffset;
+
+	if (size > bufferSize)
+		size = bufferSize;
+	memcpy(buffer, cache->Data + entry->Offset + cache->ReadOffset, size);
+	cache->ReadOffset += (unsigned int)size;
+	cache->Stats.BytesServed += size;
+	*received = size;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpCacheInit(HttpCache* cache, void* store, unsigned int size) {
+	if (cache == NULL || store == NULL || size <= sizeof(HttpCacheStore))
+		return -1;
+	_AttachStore(cache, store, size, -1);
+	_FormatStore(cache, size);
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpCacheOpenFile(HttpCache* cache, const char* path, unsigned int size) {
+#ifdef HTTPLIB_POSIX
+	struct stat status;
+	void* store = NULL;
+	int file = -1;
+	int reuse = 0;
+
+	if (cache == NULL || path == NULL || size <= sizeof(HttpCacheStore))
+		return -1;
+	file = open(path, O_RDWR | O_CREAT, 0600);
+	if (file < 0)
+		return -1;
+	reuse = (fstat(file, &status) == 0 && status.st_size == (off_t)size);
+	if (!reuse && ftruncate(file, (off_t)size) != 0) {
+		close(file);
+		return -1;
+	}
+	store = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	if (store == MAP_FAILED) {
+		close(file);
+		return -1;
+	}
+	_AttachStore(cache, store, size, file);
+	if (!reuse || !_IsStoreValid(cache->Store, size))
+		_FormatStore(cache, size);
+	return 0;
+#else
+	(void)cache;
+	(void)path;
+	(void)size;
+	LOG_PRINTF(("\tMemory-mapped cache is not supported."));
+	return -1;
+#endif	// HTTPLIB_POSIX
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpCacheClose(HttpCache* cache) {
+	if (cache == NULL || cache->Store == NULL)
+		return;
+#ifdef HTTPLIB_POSIX
+	if (cache->File >= 0) {
+		msync(cache->Store, cache->Store->Size, MS_SYNC);
+		munmap(cache->Store, cache->Store->Size);
+		close(cache->File);
+	}
+#endif	// HTTPLIB_POSIX
+	cache->Store = NULL;
+	cache->Data = NULL;
+	cache->File = -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpCacheSend(HttpCache* cache, HttpContext* ctx, HttpRequestBuilder* builder) {
+	HttpCacheEntry* entry = NULL;
+	int index = -1;
+	int result = 0;
+
+	if (cache == NULL || cache->Store == NULL || ctx == NULL || builder == NULL)
+		return -1;
+	// Body of previous response was not received completely.
+	cache->Storing = 0;
+	cache->Entry = -1;
+	cache->Stale = -1;
+	cache->ReadOffset = 0;
+	cache->Result = HTTP_CACHE_BYPASS;
+	if (_MakeKey(cache, ctx, builder) == 0) {
+		cache->Result = HTTP_CACHE_MISS;
+		index = _FindEntry(cache);
+	}
+	if (index >= 0) {
+		entry = &cache->Store->Entries[index];
+		// Clock going back makes entry stale.
+		if (entry->MaxAge > 0 && CACHE_NOW() - entry->StoredAt < entry->MaxAge) {
+			entry->LastUsed = ++cache->Store->UseCounter;
+			cache->Entry = index;
+			cache->Result = HTTP_CACHE_HIT;
+			cache->Stats.Hits++;
+			HTTP_TRACE_INFO(ctx, HTTP_EVENT_CACHE_HIT, entry->Length, 0, 0);
+			return 0;
+		}
+		cache->Stale = index;
+		if (entry->ETag[0] != '\0')
+			result = _HttpBuilderSetProperty(builder, IfNoneMatchText, entry->ETag);
+		if (result == 0 && entry->LastModified[0] != '\0') {
+			result = _HttpBuilderSetProperty(builder, IfModifiedSinceText, entry->LastModified);
+			// Request is sent without validators then, 304 could not be told apart.
+			if (result != 0 && entry->ETag[0] != '\0')
+				_HttpBuilderRemoveProperty(builder, IfNoneMatchText);
+		}
+		// Request with all validators gets 304 if stored response is still valid.
+		if (result == 0)
+			cache->Entry = index;
+	}
+	result = _HttpBuilderComplete(builder);
+	if (result < 0)
+		return result;
+	return _HttpSend(builder->Buffer, (int)builder->Length, ctx);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpCacheRecv(HttpCache* cache, HttpContext* ctx, void* buffer, size_t bufferSize, size_t* received) {
+	int result = 0;
+
+	if (cache == NULL || ctx == NULL || received == NULL || (buffer == NULL && bufferSize > 0))
+		return -1;
+	*received = 0;
+	if (cache->Result == HTTP_CACHE_HIT || cache->Result == HTTP_CACHE_REVALIDATED)
+		return _ServeBody(cache, buffer, bufferSize, received);
+	if (!(ctx->Flags & HEADER_RECEIVED)) {
+		result = _HttpReceiveHeader(ctx);
+		if (result != 0)
+			return result;
+		_OnResponseHeader(cache, ctx);
+		if (cache->Result == HTTP_CACHE_REVALIDATED)
+			return _ServeBody(cache, buffer, bufferSize, received);
+	}
+	result = _HttpRecvLarge(ctx, buffer, bufferSize, received);
+	if (!cache->Storing)
+		return result;
+	if (*received > 0)
+		_StoreBody(cache, buffer, *received);
+	// Partial body is dropped on error.
+	if (result != 0 && result != HTTP_TRANSPORT_WOULD_BLOCK) {
+		cache->Storing = 0;
+		cache->Entry = -1;
+	}
+	else if (cache->Storing && _HttpIsResponseConsumed(ctx))
+		_CommitBody(cache, ctx);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpCacheIsResponseConsumed(const HttpCache* cache, const HttpContext* ctx) {
+	if (cache->Result == HTTP_CACHE_HIT || cache->Result == HTTP_CACHE_REVALIDATED)
+		return (cache->ReadOffset >= cache->Store->Entries[cache->Entry].Length);
+	return _HttpIsResponseConsumed(ctx);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpCacheGetStatus(const HttpCache* cache, const HttpContext* ctx, unsigned short* statusCode) {
+	if (cache == NULL || statusCode == NULL)
+		return -1;
+	if (cache->Result == HTTP_CACHE_HIT || cache->Result == HTTP_CACHE_REVALIDATED) {
+		*statusCode = 200;
+		return 0;
+	}
+	return _HttpGetResponseStatus(ctx, statusCode, NULL, NULL, NULL);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpCacheClear(HttpCache* cache) {
+	if (cache == NULL || cache->Store == NULL)
+		return;
+	_FormatStore(cache, cache->Store->Size);
+	cache->Storing = 0;
+	cache->Entry = -1;
+	cache->Stale = -1;
+	cache->Result = HTTP_CACHE_BYPASS;
+}
@@ -0,0 +1,304 @@
+#include "HttpLibPrivate.h"
+#include <HttpDeflate.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// This function sends header and body (not copied) with Content-Length.
+// Returns: Non-zero value on error.
+static int _SendWithLength(HttpContext* ctx, HttpRequestBuilder* builder, const void* body, size_t bodySize) {
+	HttpIoVec vectors[2];
+	int result = 0;
+
+	if (bodySize > 0xFFFFFFFFul)
+		return -1;
+	result = _HttpBuilderSetPropertyNumber(builder, "Content-Length", (unsigned long)bodySize);
+	if (result != 0)
+		return result;
+	result = _HttpBuilderComplete(builder);
+	if (result < 0)
+		return result;
+	vectors[0].Data = builder->Buffer;
+	vectors[0].Size = builder->BodyOffset;
+	vectors[1].Data = body;
+	vectors[1].Size = bodySize;
+	return _HttpSendv(ctx, vectors, (bodySize > 0 ? 2 : 1));
+}
+
+#ifdef HTTPLIB_ZLIB
+#include <zlib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Biggest input given to zlib at once (its sizes are 32-bit).
+#define HTTP_DEFLATE_MAX_INPUT			0x40000000u
+
+///////////////////////////////////////////////////////////////////////////////
+#define STREAM(deflater)				((z_stream*)(deflater)->Stream)
+
+///////////////////////////////////////////////////////////////////////////////
+static const char ContentEncodingText[] = "Content-Encoding";
+static const char GzipText[] = "gzip";
+
+///////////////////////////////////////////////////////////////////////////////
+static voidpf _ZAlloc(voidpf opaque, uInt items, uInt size) {
+	(void)opaque;
+	return _HttpGlobalAlloc((size_t)items * size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void _ZFree(voidpf opaque, voidpf address) {
+	(void)opaque;
+	_HttpGlobalFree(address);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function prepares deflater for new body.
+// Returns: Non-zero value on error.
+static int _BeginStream(HttpDeflater* deflater) {
+	deflater->OutputUsed = 0;
+	return (deflateReset(STREAM(deflater)) == Z_OK ? 0 : -1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function compresses input into output window. Full window is sent as chunk
+// (upload has to be started then).
+// Arguments:
+// 1) Context.
+// 2) Input.
+// 3) Input size.
+// 4) zlib flush mode (Z_NO_FLUSH, Z_FINISH).
+// 5) Stop flag: return when output window is full, nothing is sent.
+// Returns: 0 when input is taken (stream ended for Z_FINISH), 1 when window
+// filled up and stop flag is set, negative value on error.
+static int _Compress(HttpContext* ctx, const char* input, size_t inputSize, int flush, unsigned char stop) {
+	HttpDeflater* deflater = ctx->Deflater;
+	z_stream* stream = STREAM(deflater);
+	uInt piece = 0;
+	int result = Z_OK;
+
+	while (1) {
+		piece = (uInt)(inputSize > HTTP_DEFLATE_MAX_INPUT ? HTTP_DEFLATE_MAX_INPUT : inputSize);
+		stream->next_in = (Bytef*)input;
+		stream->avail_in = piece;
+		stream->next_out = (Bytef*)(deflater->Output + deflater->OutputUsed);
+		stream->avail_out = HTTP_DEFLATE_OUTPUT_SIZE - deflater->OutputUsed;
+		result = deflate(stream, (piece == inputSize ? flush : Z_NO_FLUSH));
+		input += piece - stream->avail_in;
+		inputSize -= piece - stream->avail_in;
+		deflater->RawBytes += piece - stream->avail_in;
+		deflater->OutputUsed = HTTP_DEFLATE_OUTPUT_SIZE - stream->avail_out;
+		if (result == Z_STREAM_ERROR)
+			return -1;
+		if (result == Z_STREAM_END || (flush != Z_FINISH && inputSize == 0 && stream->avail_out > 0))
+			return 0;
+		if (deflater->OutputUsed == HTTP_DEFLATE_OUTPUT_SIZE) {
+			if (stop)
+				return 1;
+			result = _HttpWriteChunk(ctx, deflater->Output, deflater->OutputUsed);
+			if (result != 0)
+				return result;
+			deflater->CompressedBytes += deflater->OutputUsed;
+			deflater->OutputUsed = 0;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function sends bytes waiting in output window as chunk.
+// Returns: Non-zero value on error.
+static int _FlushOutput(HttpContext* ctx) {
+	HttpDeflater* deflater = ctx->Deflater;
+	int result = 0;
+
+	if (deflater->OutputUsed == 0)
+		return 0;
+	result = _HttpWriteChunk(ctx, deflater->Output, deflater->OutputUsed);
+	if (result == 0)
+		deflater->CompressedBytes += deflater->OutputUsed;
+	deflater->OutputUsed = 0;
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpDeflaterInit(HttpDeflater* deflater, int level, size_t minSize) {
+	z_stream* stream = NULL;
+
+	if (deflater == NULL || level < 1 || level > 9)
+		return -1;
+	memset(deflater, 0, sizeof(HttpDeflater));
+	stream = (z_stream*)_HttpGlobalAlloc(sizeof(z_stream));
+	deflater->Output = (char*)_HttpGlobalAlloc(HTTP_DEFLATE_OUTPUT_SIZE);
+	if (stream != NULL && deflater->Output != NULL) {
+		memset(stream, 0, sizeof(z_stream));
+		stream->zalloc = _ZAlloc;
+		stream->zfree = _ZFree;
+		// gzip wrapper.
+		if (deflateInit2(stream, level, Z_DEFLATED, HTTP_DEFLATE_WINDOW_BITS + 16, HTTP_DEFLATE_MEM_LEVEL, Z_DEFAULT_STRATEGY) == Z_OK) {
+			deflater->Stream = stream;
+			deflater->MinSize = minSize;
+			return 0;
+		}
+	}
+	if (stream)
+		_HttpGlobalFree(stream);
+	if (deflater->Output)
+		_HttpGlobalFree(deflater->Output);
+	deflater->Output = NULL;
+	return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpDeflaterDestroy(HttpDeflater* deflater) {
+	if (deflater == NULL || deflater->Stream == NULL)
+		return;
+	deflateEnd(STREAM(deflater));
+	_HttpGlobalFree(deflater->Stream);
+	_HttpGlobalFree(deflater->Output);
+	deflater->Stream = NULL;
+	deflater->Output = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSetDeflater(HttpContext* ctx, HttpDeflater* deflater) {
+	if (ctx == NULL || (deflater != NULL && deflater->Stream == NULL))
+		return -1;
+	ctx->Deflater = deflater;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSendCompressed(HttpContext* ctx, HttpRequestBuilder* builder, const void* body, size_t bodySize) {
+	HttpDeflater* deflater = NULL;
+	HttpLength_t taken = 0;
+	int result = 0;
+
+	if (ctx == NULL || builder == NULL || (body == NULL && bodySize > 0))
+		return -1;
+	deflater = ctx->Deflater;
+	HTTP_TRACE_DEBUG(ctx, HTTP_EVENT_DEFLATE_SEND, bodySize, (deflater != NULL && bodySize >= deflater->MinSize), 0);
+	if (deflater == NULL || bodySize < deflater->MinSize) {
+		if (deflater)
+			deflater->Skipped++;
+		return _SendWithLength(ctx, builder, body, bodySize);
+	}
+	result = _BeginStream(deflater);
+	if (result != 0)
+		return result;
+	result = _HttpBuilderSetProperty(builder, ContentEncodingText, GzipText);
+	if (result != 0)
+		return result;
+	// Compressed body which fits in output window is sent in one piece.
+	taken = deflater->RawBytes;
+	result = _Compress(ctx, (const char*)body, bodySize, Z_FINISH, 1);
+	if (result == 0) {
+		deflater->CompressedBytes += deflater->OutputUsed;
+		return _SendWithLength(ctx, builder, deflater->Output, deflater->OutputUsed);
+	}
+	if (result < 0)
+		return result;
+	result = _HttpBeginChunkedUpload(ctx, builder);
+	if (result != 0)
+		return result;
+	// Input is taken from where compression stopped.
+	taken = deflater->RawBytes - taken;
+	result = _Compress(ctx, (const char*)body + taken, bodySize - (size_t)taken, Z_FINISH, 0);
+	if (result == 0)
+		result = _FlushOutput(ctx);
+	if (result != 0)
+		return result;
+	return _HttpEndChunkedUpload(ctx, NULL, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpBeginCompressedUpload(HttpContext* ctx, HttpRequestBuilder* builder) {
+	int result = 0;
+
+	if (ctx == NULL || builder == NULL || ctx->Deflater == NULL)
+		return -1;
+	result = _BeginStream(ctx->Deflater);
+	if (result != 0)
+		return result;
+	result = _HttpBuilderSetProperty(builder, ContentEncodingText, GzipText);
+	if (result != 0)
+		return result;
+	return _HttpBeginChunkedUpload(ctx, builder);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpWriteCompressed(HttpContext* ctx, const void* data, size_t size) {
+	if (ctx == NULL || ctx->Deflater == NULL || !(ctx->Flags & UPLOADING_CHUNKED) || (data == NULL && size > 0))
+		return -1;
+	if (size == 0)
+		return 0;
+	return _Compress(ctx, (const char*)data, size, Z_NO_FLUSH, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpEndCompressedUpload(HttpContext* ctx, const char* const* trailers, unsigned int trailerCount) {
+	int result = 0;
+
+	if (ctx == NULL || ctx->Deflater == NULL || !(ctx->Flags & UPLOADING_CHUNKED))
+		return -1;
+	result = _Compress(ctx, NULL, 0, Z_FINISH, 0);
+	if (result == 0)
+		result = _FlushOutput(ctx);
+	if (result != 0)
+		return result;
+	return _HttpEndChunkedUpload(ctx, trailers, trailerCount);
+}
+
+#else
+
+///////////////////////////////////////////////////////////////////////////////
+// Built without zlib: deflater can not be created, bodies are sent uncompressed.
+int _HttpDeflaterInit(HttpDeflater* deflater, int level, size_t minSize) {
+	(void)level;
+	(void)minSize;
+	if (deflater != NULL)
+		memset(deflater, 0, sizeof(HttpDeflater));
+	LOG_PRINTF(("\tLibrary built without zlib."));
+	return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpDeflaterDestroy(HttpDeflater* deflater) {
+	(void)deflater;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSetDeflater(HttpContext* ctx, HttpDeflater* deflater) {
+	if (ctx == NULL || deflater != NULL)
+		return -1;
+	ctx->Deflater = NULL;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSendCompressed(HttpContext* ctx, HttpRequestBuilder* builder, const void* body, size_t bodySize) {
+	if (ctx == NULL || builder == NULL || (body == NULL && bodySize > 0))
+		return -1;
+	return _SendWithLength(ctx, builder, body, bodySize);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpBeginCompressedUpload(HttpContext* ctx, HttpRequestBuilder* builder) {
+	(void)ctx;
+	(void)builder;
+	return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpWriteCompressed(HttpContext* ctx, const void* data, size_t size) {
+	(void)ctx;
+	(void)data;
+	(void)size;
+	return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpEndCompressedUpload(HttpContext* ctx, const char* const* trailers, unsigned int trailerCount) {
+	(void)ctx;
+	(void)trailers;
+	(void)trailerCount;
+	return -1;
+}
+
+#endif	// HTTPLIB_ZLIB
@@ -0,0 +1,925 @@
+#include "HttpLibPrivate.h"
+#include <HttpDownload.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef HTTPLIB_POSIX
+#include <HttpEpoll.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif	// HTTPLIB_POSIX
+
+///////////////////////////////////////////////////////////////////////////////
+// Output and progress file access.
+#ifdef HTTPLIB_POSIX
+typedef off_t FileOffset_t;
+#define DOWNLOAD_OPEN(path, flags)		open((path), (flags), 0644)
+#define DOWNLOAD_REMOVE(path)			unlink(path)
+#else
+typedef long FileOffset_t;
+#define DOWNLOAD_OPEN(path, flags)		open((path), (flags))
+#define DOWNLOAD_REMOVE(path)			_remove(path)
+#endif	// HTTPLIB_POSIX
+
+///////////////////////////////////////////////////////////////////////////////
+// Request buffer size (path is limited by resource key).
+#define DOWNLOAD_REQUEST_SIZE			512
+// Parallel mode gives up on connections silent for this long if contexts have no receive timeout (miliseconds).
+#define DOWNLOAD_STALL_TIMEOUT			30000
+// Response handling results (besides 0 and errors).
+// Nothing to receive, segment is complete.
+#define DOWNLOAD_SKIP					1
+// Progress was dropped (resource changed), download starts over.
+#define DOWNLOAD_RESTART				2
+// Parallel mode cannot be used, download continues on single connection.
+#define DOWNLOAD_SEQUENTIAL				3
+
+///////////////////////////////////////////////////////////////////////////////
+// Body sink data: segment body is written to.
+typedef struct SegmentWriter {
+	HttpDownload* Download;
+	HttpDownloadSegment* Segment;
+	// Error which made sink abort receiving.
+	int Error;
+} SegmentWriter;
+
+///////////////////////////////////////////////////////////////////////////////
+// This function writes decimal number.
+// Returns: Number of characters written (buffer is null-terminated).
+static int _FormatNumber(char* buffer, HttpLength_t value) {
+	char digits[24];
+	int count = 0;
+	int i = 0;
+
+	do {
+		digits[count++] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value > 0);
+	for (i = 0; i < count; i++)
+		buffer[i] = digits[count - 1 - i];
+	buffer[count] = '\0';
+	return count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function parses decimal number.
+// Returns: Non-zero value if there are no digits or number does not fit.
+static int _ParseNumber(const char** cursor, const char* end, HttpLength_t* value) {
+	const char* position = *cursor;
+
+	*value = 0;
+	for (; position < end && *position >= '0' && *position <= '9'; position++) {
+		if (*value > (HTTP_DOWNLOAD_UNKNOWN - 1 - (HttpLength_t)(*position - '0')) / 10)
+			return -1;
+		*value = *value * 10 + (HttpLength_t)(*position - '0');
+	}
+	if (position == *cursor)
+		return -1;
+	*cursor = position;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function reads Content-Range: 'bytes first-last/total', 'bytes */total'
+// (416 response) or 'bytes first-last/*'. Missing values are HTTP_DOWNLOAD_UNKNOWN.
+// Returns: Non-zero value if there is no Content-Range or it is malformed.
+static int _ParseContentRange(const HttpContext* ctx, HttpLength_t* first, HttpLength_t* last, HttpLength_t* total) {
+	const char* value = NULL;
+	const char* end = NULL;
+	unsigned int length = 0;
+
+	if (_HttpGetResponseHeader(ctx, "Content-Range", &value, &length) != 0 || length < 6 || memcmp(value, "bytes ", 6) != 0)
+		return -1;
+	end = value + length;
+	value += 6;
+	*first = HTTP_DOWNLOAD_UNKNOWN;
+	*last = HTTP_DOWNLOAD_UNKNOWN;
+	*total = HTTP_DOWNLOAD_UNKNOWN;
+	if (value < end && *value == '*')
+		value++;
+	else if (_ParseNumber(&value, end, first) != 0 || value >= end || *value++ != '-' || _ParseNumber(&value, end, last) != 0 || *last < *first)
+		return -1;
+	if (value >= end || *value++ != '/')
+		return -1;
+	if (value < end && *value == '*')
+		return (*first == HTTP_DOWNLOAD_UNKNOWN ? -1 : 0);
+	if (_ParseNumber(&value, end, total) != 0)
+		return -1;
+	return (*last != HTTP_DOWNLOAD_UNKNOWN && *last >= *total ? -1 : 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function keeps validator for If-Range: strong ETag or Last-Modified
+// (weak ETag cannot be used there). Validators which do not fit are not kept.
+static void _CopyValidator(HttpDownload* download, const HttpContext* ctx) {
+	const char* value = NULL;
+	unsigned int length = 0;
+	int result = 0;
+
+	result = _HttpGetResponseHeader(ctx, "ETag", &value, &length);
+	if (result != 0 || (length >= 2 && value[0] == 'W' && value[1] == '/'))
+		result = _HttpGetResponseHeader(ctx, "Last-Modified", &value, &length);
+	download->State.Validator[0] = '\0';
+	if (result != 0 || length >= HTTP_DOWNLOAD_MAX_VALIDATOR)
+		return;
+	memcpy(download->State.Validator, value, length);
+	download->State.Validator[length] = '\0';
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function drops progress: single segment of unknown length, no validator.
+static void _ResetState(HttpDownload* download) {
+	HttpDownloadState* state = &download->State;
+
+	state->Validator[0] = '\0';
+	state->Total = HTTP_DOWNLOAD_UNKNOWN;
+	state->SegmentCount = 1;
+	memset(state->Segments, 0, sizeof(state->Segments));
+	state->Segments[0].Length = HTTP_DOWNLOAD_UNKNOWN;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Returns: Number of bytes written to output file.
+static HttpLength_t _DoneBytes(const HttpDownload* download) {
+	HttpLength_t done = 0;
+	unsigned int i = 0;
+
+	for (i = 0; i < download->State.SegmentCount; i++)
+		done += download->State.Segments[i].Done;
+	return done;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Returns: Non-zero value if segment is complete.
+static int _IsSegmentComplete(const HttpDownloadSegment* segment) {
+	return (segment->Length != HTTP_DOWNLOAD_UNKNOWN && segment->Done == segment->Length);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Returns: First incomplete segment, NULL if download is complete.
+static HttpDownloadSegment* _NextSegment(HttpDownload* download) {
+	unsigned int i = 0;
+
+	for (i = 0; i < download->State.SegmentCount; i++) {
+		if (!_IsSegmentComplete(&download->State.Segments[i]))
+			return &download->State.Segments[i];
+	}
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function writes data at output file offset.
+// Returns: Non-zero value on error.
+static int _WriteAt(HttpDownload* download, HttpLength_t offset, const char* data, unsigned int size) {
+#ifdef HTTPLIB_POSIX
+	ssize_t written = 0;
+
+	if (download->Map != NULL) {
+		memcpy(download->Map + offset, data, size);
+		return 0;
+	}
+	while (size > 0) {
+		written = pwrite(download->File, data, size, (off_t)offset);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return HTTP_DOWNLOAD_ERROR_FILE;
+		data += written;
+		offset += (HttpLength_t)written;
+		size -= (unsigned int)written;
+	}
+	return 0;
+#else
+	if (lseek(download->File, (long)offset, SEEK_SET) < 0 || write(download->File, (char*)data, (int)size) != (int)size)
+		return HTTP_DOWNLOAD_ERROR_FILE;
+	return 0;
+#endif	// HTTPLIB_POSIX
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function empties output file.
+// Returns: Non-zero value on error.
+static int _TruncateOutput(HttpDownload* download) {
+#ifdef HTTPLIB_POSIX
+	return (ftruncate(download->File, 0) != 0 ? HTTP_DOWNLOAD_ERROR_FILE : 0);
+#else
+	// There is no truncate call, file is created again.
+	close(download->File);
+	DOWNLOAD_REMOVE(download->OutputPath);
+	download->File = DOWNLOAD_OPEN(download->OutputPath, O_RDWR | O_CREAT);
+	return (download->File < 0 ? HTTP_DOWNLOAD_ERROR_FILE : 0);
+#endif	// HTTPLIB_POSIX
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function saves progress. Output data is flushed first, so progress file
+// never claims bytes which are not on disk. Progress file is rewritten in place:
+// lengths do not change and done counters only grow, so torn write leaves older
+// progress behind.
+// Returns: Non-zero value on error.
+static int _SaveState(HttpDownload* download) {
+	int file = -1;
+	int written = 0;
+
+	download->Unsaved = 0;
+	if (download->StatePath == NULL)
+		return 0;
+#ifdef HTTPLIB_POSIX
+	if (fdatasync(download->File) != 0)
+		return HTTP_DOWNLOAD_ERROR_FILE;
+#endif	// HTTPLIB_POSIX
+	file = DOWNLOAD_OPEN(download->StatePath, O_WRONLY | O_CREAT);
+	if (file < 0)
+		return HTTP_DOWNLOAD_ERROR_FILE;
+	written = (int)write(file, (char*)&download->State, sizeof(HttpDownloadState));
+	close(file);
+	return (written == (int)sizeof(HttpDownloadState) ? 0 : HTTP_DOWNLOAD_ERROR_FILE);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function loads progress saved for the same resource. Progress is checked
+// against output file, which has to hold all bytes claimed done.
+// Returns: Non-zero value if there is no usable progress.
+static int _LoadState(HttpDownload* download) {
+	HttpDownloadState state;
+	const HttpDownloadSegment* segment = NULL;
+	FileOffset_t size = 0;
+	unsigned int i = 0;
+	int file = -1;
+	int loaded = 0;
+
+	if (download->StatePath == NULL)
+		return -1;
+	file = DOWNLOAD_OPEN(download->StatePath, O_RDONLY);
+	if (file < 0)
+		return -1;
+	loaded = (read(file, (char*)&state, sizeof(state)) == (int)sizeof(state));
+	close(file);
+	size = lseek(download->File, 0, SEEK_END);
+	if (!loaded || size < 0 || memcmp(state.Magic, HTTP_DOWNLOAD_MAGIC, sizeof(state.Magic)) != 0 || state.Version != HTTP_DOWNLOAD_VERSION)
+		return -1;
+	if (memchr(state.Key, '\0', sizeof(state.Key)) == NULL || strcmp(state.Key, download->State.Key) != 0)
+		return -1;
+	if (memchr(state.Validator, '\0', sizeof(state.Validator)) == NULL || state.SegmentCount == 0 || state.SegmentCount > HTTP_DOWNLOAD_MAX_SEGMENTS)
+		return -1;
+	// Segments cover file from its beginning without gaps, only single segment may have unknown length.
+	for (i = 0; i < state.SegmentCount; i++) {
+		segment = &state.Segments[i];
+		if (segment->Start != (i == 0 ? 0 : state.Segments[i - 1].Start + state.Segments[i - 1].Length))
+			return -1;
+		if (segment->Length == HTTP_DOWNLOAD_UNKNOWN ? state.SegmentCount > 1 : segment->Done > segment->Length)
+			return -1;
+		if (segment->Start + segment->Done > (HttpLength_t)size)
+			return -1;
+	}
+	memcpy(&download->State, &state, sizeof(state));
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function opens output file and picks up saved progress (output file is
+// emptied if there is none).
+// Returns: Non-zero value on error (file is closed then).
+static int _OpenOutput(HttpDownload* download) {
+	download->File = DOWNLOAD_OPEN(download->OutputPath, O_RDWR | O_CREAT);
+	if (download->File < 0)
+		return HTTP_DOWNLOAD_ERROR_FILE;
+	download->Map = NULL;
+	download->Unsaved = 0;
+	download->Resumed = 0;
+	if (_LoadState(download) != 0) {
+		_ResetState(download);
+		if (_TruncateOutput(download) != 0) {
+			if (download->File >= 0)
+				close(download->File);
+			download->File = -1;
+			return HTTP_DOWNLOAD_ERROR_FILE;
+		}
+		return 0;
+	}
+	download->Resumed = _DoneBytes(download);
+	HTTP_TRACE_INFO(NULL, HTTP_EVENT_DOWNLOAD_RESUMED, download->Resumed, download->State.SegmentCount, 0);
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function closes output file. Progress of unfinished download is saved,
+// progress file of complete one is removed.
+// Returns: Download result (file error if progress cannot be saved).
+static int _CloseOutput(HttpDownload* download, int result) {
+#ifdef HTTPLIB_POSIX
+	if (download->Map != NULL) {
+		munmap(download->Map, (size_t)download->State.Total);
+		download->Map = NULL;
+	}
+#endif	// HTTPLIB_POSIX
+	if (result == 0 && _NextSegment(download) == NULL) {
+		if (download->StatePath != NULL)
+			DOWNLOAD_REMOVE(download->StatePath);
+	}
+	else if (_SaveState(download) != 0 && result >= 0) {
+		result = HTTP_DOWNLOAD_ERROR_FILE;
+	}
+	close(download->File);
+	download->File = -1;
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function drops progress and output file content.
+// Returns: Non-zero value on error.
+static int _Restart(HttpDownload* download, const HttpContext* ctx) {
+	HTTP_TRACE_INFO(ctx, HTTP_EVENT_DOWNLOAD_RESTART, ctx->Parser.StatusCode, _DoneBytes(download), 0);
+	download->Restarts++;
+	_ResetState(download);
+	return _TruncateOutput(download);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function checks 206 response: Content-Range has to start at requested
+// offset and end with segment (segment of unknown length gets it from response).
+// File size and validator are learned from first response.
+// Returns: Non-zero value if response does not fit (DOWNLOAD_RESTART - file size changed).
+static int _CheckRange(HttpDownload* download, const HttpContext* ctx, HttpDownloadSegment* segment) {
+	HttpLength_t first = 0;
+	HttpLength_t last = 0;
+	HttpLength_t total = 0;
+
+	if (_ParseContentRange(ctx, &first, &last, &total) != 0 || first != segment->Start + segment->Done)
+		return HTTP_DOWNLOAD_ERROR_RESPONSE;
+	if (total != HTTP_DOWNLOAD_UNKNOWN && download->State.Total != HTTP_DOWNLOAD_UNKNOWN && total != download->State.Total)
+		return DOWNLOAD_RESTART;
+	if (segment->Length == HTTP_DOWNLOAD_UNKNOWN)
+		segment->Length = last + 1 - segment->Start;
+	else if (last + 1 != segment->Start + segment->Length)
+		return HTTP_DOWNLOAD_ERROR_RESPONSE;
+	if (download->State.Total == HTTP_DOWNLOAD_UNKNOWN)
+		download->State.Total = total;
+	if (download->State.Validator[0] == '\0')
+		_CopyValidator(download, ctx);
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function handles response header of range request.
+// Arguments:
+// 1) Download.
+// 2) Valid HttpContext pointer (header received).
+// 3) Segment requested (changed to first segment if download starts over).
+// Returns:
+// 0 : Body goes to segment.
+// DOWNLOAD_SKIP : Segment is complete, body is not needed.
+// DOWNLOAD_RESTART : Progress was dropped, body is not needed.
+// < 0 : On error.
+static int _OnResponse(HttpDownload* download, HttpContext* ctx, HttpDownloadSegment** segment) {
+	HttpDownloadSegment* requested = *segment;
+	HttpLength_t first = 0;
+	HttpLength_t last = 0;
+	HttpLength_t total = 0;
+	int result = 0;
+
+	switch (ctx->Parser.StatusCode) {
+	case 206:
+		result = _CheckRange(download, ctx, requested);
+		if (result == DOWNLOAD_RESTART && (result = _Restart(download, ctx)) == 0)
+			result = DOWNLOAD_RESTART;
+		return result;
+	case 200:
+		// Whole resource: server ignores ranges or resource changed (If-Range).
+		if (download->State.SegmentCount > 1 || _DoneBytes(download) > 0)
+			result = _Restart(download, ctx);
+		else
+			_ResetState(download);
+		*segment = &download->State.Segments[0];
+		if (ctx->Flags & CONTENT_LENGTH_KNOWN) {
+			download->State.Total = ctx->ContentLength;
+			(*segment)->Length = ctx->ContentLength;
+		}
+		_CopyValidator(download, ctx);
+		return result;
+	case 416:
+		// Range starts at file end: file is complete if it ends with segment.
+		if (_ParseContentRange(ctx, &first, &last, &total) == 0 && total == requested->Start + requested->Done
+			&& (requested->Length == HTTP_DOWNLOAD_UNKNOWN || requested->Start + requested->Length == total)) {
+			requested->Length = requested->Done;
+			if (download->State.Total == HTTP_DOWNLOAD_UNKNOWN)
+				download->State.Total = total;
+			return DOWNLOAD_SKIP;
+		}
+		result = _Restart(download, ctx);
+		return (result == 0 ? DOWNLOAD_RESTART : result);
+	default:
+		HTTP_TRACE_ERROR(ctx, HTTP_EVENT_DOWNLOAD_STATUS, ctx->Parser.StatusCode, 0, 0);
+		return HTTP_DOWNLOAD_ERROR_RESPONSE;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function is body sink writing body into segment.
+static int _WriteSink(HttpContext* ctx, const char* data, unsigned int size, void* sinkData) {
+	SegmentWriter* writer = (SegmentWriter*)sinkData;
+	HttpDownload* download = writer->Download;
+	HttpDownloadSegment* segment = writer->Segment;
+
+	(void)ctx;
+	if (segment->Length != HTTP_DOWNLOAD_UNKNOWN && size > segment->Length - segment->Done) {
+		writer->Error = HTTP_DOWNLOAD_ERROR_RESPONSE;
+		return HTTP_SINK_ABORT;
+	}
+	writer->Error = _WriteAt(download, segment->Start + segment->Done, data, size);
+	if (writer->Error != 0)
+		return HTTP_SINK_ABORT;
+	segment->Done += size;
+	download->Received += size;
+	download->Unsaved += size;
+	if (download->Unsaved >= HTTP_DOWNLOAD_SAVE_INTERVAL)
+		writer->Error = _SaveState(download);
+	return (writer->Error != 0 ? HTTP_SINK_ABORT : HTTP_SINK_CONTINUE);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function receives response to range request (header already received) into segment.
+// Returns: Non-zero value on error (DOWNLOAD_RESTART - progress was dropped).
+static int _ReceiveResponse(HttpDownload* download, HttpContext* ctx, HttpDownloadSegment* segment) {
+	SegmentWriter writer;
+	int result = 0;
+
+	result = _OnResponse(download, ctx, &segment);
+	if (result == DOWNLOAD_SKIP || result == DOWNLOAD_RESTART) {
+		// Body is not needed, connection is kept if it is short.
+		_HttpSkipBody(ctx, HTTP_SKIP_BODY_LIMIT);
+		return (result == DOWNLOAD_SKIP ? 0 : result);
+	}
+	if (result != 0)
+		return result;
+	writer.Download = download;
+	writer.Segment = segment;
+	writer.Error = 0;
+	result = _HttpRecvToSink(ctx, _WriteSink, &writer);
+	if (result != 0)
+		return (writer.Error != 0 ? writer.Error : result);
+	// Body ended by connection close or last chunk tells length.
+	if (segment->Length == HTTP_DOWNLOAD_UNKNOWN) {
+		segment->Length = segment->Done;
+		download->State.Total = segment->Start + segment->Length;
+	}
+	return (segment->Done == segment->Length ? 0 : HTTP_DOWNLOAD_ERROR_RESPONSE);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function builds GET request of byte range (to file end if last byte is
+// HTTP_DOWNLOAD_UNKNOWN), with If-Range if validator is known.
+// Returns: Request length, negative value on error.
+static int _BuildRequest(const HttpDownload* download, HttpLength_t first, HttpLength_t last, char* buffer, unsigned int size) {
+	HttpRequestBuilder builder;
+	char host[HTTP_DOWNLOAD_MAX_KEY];
+	char range[48];
+	int length = 0;
+	int result = 0;
+
+	if (download->Port == (download->Ssl ? 443 : 80))
+		strcpy(host, download->Host);
+	else
+		sprintf(host, "%s:%u", download->Host, (unsigned int)download->Port);
+	strcpy(range, "bytes=");
+	length = 6 + _FormatNumber(range + 6, first);
+	range[length++] = '-';
+	range[length] = '\0';
+	if (last != HTTP_DOWNLOAD_UNKNOWN)
+		_FormatNumber(range + length, last);
+	result = _HttpBuilderInit(&builder, buffer, size, GET, download->Path, HTTP_11);
+	if (result == 0)
+		result = _HttpBuilderSetProperty(&builder, "Host", host);
+	if (result == 0)
+		result = _HttpBuilderSetProperty(&builder, "Range", range);
+	// Ranges refer to encoded body, compressed one would not match file.
+	if (result == 0)
+		result = _HttpBuilderSetProperty(&builder, "Accept-Encoding", "identity");
+	if (result == 0 && download->State.Validator[0] != '\0')
+		result = _HttpBuilderSetProperty(&builder, "If-Range", download->State.Validator);
+	if (result != 0)
+		return (result < 0 ? result : -1);
+	return _HttpBuilderComplete(&builder);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function requests and receives missing part of segment.
+// Returns: Non-zero value on error (DOWNLOAD_RESTART - progress was dropped).
+static int _FetchSegment(HttpDownload* download, HttpContext* ctx, HttpDownloadSegment* segment) {
+	char request[DOWNLOAD_REQUEST_SIZE];
+	HttpLength_t first = segment->Start + segment->Done;
+	HttpLength_t last = (segment->Length == HTTP_DOWNLOAD_UNKNOWN ? HTTP_DOWNLOAD_UNKNOWN : segment->Start + segment->Length - 1);
+	int result = 0;
+
+	result = _BuildRequest(download, first, last, request, sizeof(request));
+	if (result < 0)
+		return HTTP_DOWNLOAD_ERROR_ARGUMENT;
+	HTTP_TRACE_DEBUG(ctx, HTTP_EVENT_DOWNLOAD_RANGE, first, (last == HTTP_DOWNLOAD_UNKNOWN ? 0 : last + 1 - first), 0);
+	result = _HttpSend(request, result, ctx);
+	if (result == 0)
+		result = _HttpReceiveHeader(ctx);
+	if (result != 0)
+		return result;
+	return _ReceiveResponse(download, ctx, segment);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function downloads missing segments one after another over single connection.
+// Returns: Non-zero value on error.
+static int _RunSequential(HttpDownload* download, HttpContext* ctx) {
+	HttpDownloadSegment* segment = NULL;
+	unsigned int retries = 0;
+	unsigned int restarts = 0;
+	int result = 0;
+
+	while ((segment = _NextSegment(download)) != NULL) {
+		result = 0;
+		if (!(ctx->Flags & CONNECTED))
+			result = _HttpConnect(download->Host, download->Port, download->Ssl, ctx);
+		if (result == 0)
+			result = _FetchSegment(download, ctx, segment);
+		if (result == 0)
+			continue;
+		if (result == DOWNLOAD_RESTART) {
+			// Resource keeps changing.
+			if (restarts++ >= download->MaxRetries) {
+				result = HTTP_DOWNLOAD_ERROR_RESPONSE;
+				break;
+			}
+			result = 0;
+			continue;
+		}
+		if (result == HTTP_DOWNLOAD_ERROR_FILE || result == HTTP_DOWNLOAD_ERROR_RESPONSE)
+			break;
+		HTTP_TRACE_INFO(ctx, HTTP_EVENT_DOWNLOAD_RETRY, result, retries, 0);
+		_HttpDisconnect(ctx, 1);
+		if (retries++ >= download->MaxRetries)
+			break;
+		download->Retries++;
+		// Bytes received so far are not requested again.
+		if (download->Unsaved > 0 && _SaveState(download) != 0)
+			return HTTP_DOWNLOAD_ERROR_FILE;
+	}
+	return result;
+}
+
+#ifdef HTTPLIB_POSIX
+///////////////////////////////////////////////////////////////////////////////
+// Parallel mode: one slot per connection, fetching one segment at a time.
+struct DownloadRound;
+typedef struct DownloadSlot {
+	HttpAsync Async;
+	SegmentWriter Writer;
+	struct DownloadRound* Round;
+	// Response was checked (status, Content-Range).
+	unsigned char Checked;
+	char Request[DOWNLOAD_REQUEST_SIZE];
+} DownloadSlot;
+
+///////////////////////////////////////////////////////////////////////////////
+// Requests run on single epoll instance until they complete or stall.
+typedef struct DownloadRound {
+	HttpDownload* Download;
+	HttpEpoll Loop;
+	DownloadSlot Slots[HTTP_DOWNLOAD_MAX_SEGMENTS];
+	unsigned int SlotCount;
+	// Error ending download (file, response), DOWNLOAD_RESTART if resource changed.
+	int Error;
+	// Requests failed with transport error and last such error.
+	unsigned int Failed;
+	int LastFailure;
+} DownloadRound;
+
+///////////////////////////////////////////////////////////////////////////////
+// This function checks response of parallel range request.
+// Returns: Non-zero value if response cannot be used.
+static int _CheckSlot(DownloadSlot* slot, const HttpContext* ctx) {
+	slot->Checked = 1;
+	if (ctx->Parser.StatusCode == 206)
+		return _CheckRange(slot->Writer.Download, ctx, slot->Writer.Segment);
+	// Whole resource instead of range: resource changed (If-Range).
+	if (ctx->Parser.StatusCode == 200 || ctx->Parser.StatusCode == 416)
+		return DOWNLOAD_RESTART;
+	HTTP_TRACE_ERROR(ctx, HTTP_EVENT_DOWNLOAD_STATUS, ctx->Parser.StatusCode, 0, 0);
+	return HTTP_DOWNLOAD_ERROR_RESPONSE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function is body sink of parallel range request.
+static int _SlotSink(HttpContext* ctx, const char* data, unsigned int size, void* sinkData) {
+	DownloadSlot* slot = (DownloadSlot*)sinkData;
+
+	if (!slot->Checked) {
+		slot->Writer.Error = _CheckSlot(slot, ctx);
+		if (slot->Writer.Error != 0)
+			return HTTP_SINK_ABORT;
+	}
+	return _WriteSink(ctx, data, size, &slot->Writer);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Returns: Non-zero value if some slot fetches segment.
+static int _IsSegmentBusy(const DownloadRound* round, const HttpDownloadSegment* segment) {
+	unsigned int i = 0;
+
+	for (i = 0; i < round->SlotCount; i++) {
+		if (round->Slots[i].Writer.Segment == segment)
+			return 1;
+	}
+	return 0;
+}
+
+static void _OnSlotDone(HttpAsync*, int);
+
+///////////////////////////////////////////////////////////////////////////////
+// This function starts request of next segment nobody fetches (slot stays idle if there is none).
+static void _StartSlot(DownloadRound* round, DownloadSlot* slot) {
+	HttpDownload* download = round->Download;
+	HttpDownloadSegment* segment = NULL;
+	HttpContext* ctx = slot->Async.Context;
+	unsigned int i = 0;
+	int length = 0;
+
+	slot->Writer.Segment = NULL;
+	for (i = 0; i < download->State.SegmentCount && segment == NULL; i++) {
+		if (!_IsSegmentComplete(&download->State.Segments[i]) && !_IsSegmentBusy(round, &download->State.Segments[i]))
+			segment = &download->State.Segments[i];
+	}
+	if (segment == NULL || round->Error != 0)
+		return;
+	length = _BuildRequest(
+		download, segment->Start + segment->Done, segment->Start + segment->Length - 1, slot->Request, sizeof(slot->Request)
+	);
+	if (length < 0 || _HttpAsyncInit(&slot->Async, ctx, download->Host, download->Port, slot->Request, (size_t)length) != 0) {
+		round->Error = HTTP_DOWNLOAD_ERROR_ARGUMENT;
+		return;
+	}
+	HTTP_TRACE_DEBUG(ctx, HTTP_EVENT_DOWNLOAD_RANGE, segment->Start + segment->Done, segment->Length - segment->Done, 0);
+	slot->Writer.Segment = segment;
+	slot->Writer.Error = 0;
+	slot->Checked = 0;
+	slot->Async.Sink = _SlotSink;
+	slot->Async.SinkData = slot;
+	slot->Async.Done = _OnSlotDone;
+	slot->Async.UserData = slot;
+	_HttpEpollStart(&round->Loop, &slot->Async);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function is completion handler of parallel range request: connection
+// takes next segment, failed segment is left for next round.
+static void _OnSlotDone(HttpAsync* async, int result) {
+	DownloadSlot* slot = (DownloadSlot*)async->UserData;
+	DownloadRound* round = slot->Round;
+	const HttpDownloadSegment* segment = slot->Writer.Segment;
+
+	// Response without body was not seen by sink.
+	if (result == 0 && !slot->Checked)
+		slot->Writer.Error = _CheckSlot(slot, async->Context);
+	if (result == 0 && slot->Writer.Error == 0 && !_IsSegmentComplete(segment))
+		slot->Writer.Error = HTTP_DOWNLOAD_ERROR_RESPONSE;
+	slot->Writer.Segment = NULL;
+	if (slot->Writer.Error != 0) {
+		if (round->Error == 0 || slot->Writer.Error == DOWNLOAD_RESTART)
+			round->Error = slot->Writer.Error;
+		return;
+	}
+	if (result != 0) {
+		HTTP_TRACE_INFO(async->Context, HTTP_EVENT_DOWNLOAD_RETRY, result, round->Failed, 0);
+		round->Failed++;
+		round->LastFailure = result;
+		return;
+	}
+	_StartSlot(round, slot);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function fetches incomplete segments over all connections until they are
+// complete or some request fails. Stalled requests are dropped (connections closed).
+// Returns: Non-zero value on error (DOWNLOAD_RESTART - resource changed).
+static int _RunRound(HttpDownload* download, HttpContext* contexts, unsigned int count, int timeout) {
+	DownloadRound round;
+	unsigned int i = 0;
+
+	memset(&round, 0, sizeof(round));
+	round.Download = download;
+	round.SlotCount = count;
+	if (_HttpEpollInit(&round.Loop) != 0)
+		return HTTP_TRANSPORT_ERROR;
+	for (i = 0; i < count; i++) {
+		round.Slots[i].Async.Context = &contexts[i];
+		round.Slots[i].Round = &round;
+		round.Slots[i].Writer.Download = download;
+	}
+	for (i = 0; i < count; i++)
+		_StartSlot(&round, &round.Slots[i]);
+	if (round.Loop.Active > 0 && _HttpEpollRun(&round.Loop, timeout) != 0) {
+		for (i = 0; i < count; i++) {
+			if (round.Slots[i].Writer.Segment == NULL)
+				continue;
+			_HttpDisconnect(&contexts[i], 1);
+			round.Failed++;
+			round.LastFailure = HTTP_TRANSPORT_TIMEOUT;
+		}
+	}
+	_HttpEpollDestroy(&round.Loop);
+	if (round.Error != 0)
+		return round.Error;
+	return (round.Failed > 0 ? round.LastFailure : 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function asks for first byte to learn file size and validator.
+// Response other than 206 with known size is handled as sequential download would.
+// Returns: Non-zero value on error (DOWNLOAD_SEQUENTIAL - file cannot be split).
+static int _Probe(HttpDownload* download, HttpContext* ctx) {
+	char request[DOWNLOAD_REQUEST_SIZE];
+	HttpDownloadSegment* segment = &download->State.Segments[0];
+	HttpLength_t first = 0;
+	HttpLength_t last = 0;
+	int result = 0;
+
+	if (!(ctx->Flags & CONNECTED))
+		result = _HttpConnect(download->Host, download->Port, download->Ssl, ctx);
+	if (result == 0)
+		result = _BuildRequest(download, 0, 0, request, sizeof(request));
+	if (result > 0)
+		result = _HttpSend(request, result, ctx);
+	if (result == 0)
+		result = _HttpReceiveHeader(ctx);
+	if (result != 0)
+		return result;
+	if (ctx->Parser.StatusCode == 206 && _ParseContentRange(ctx, &first, &last, &download->State.Total) == 0 && first == 0) {
+		_CopyValidator(download, ctx);
+		_HttpSkipBody(ctx, HTTP_SKIP_BODY_LIMIT);
+		return (download->State.Total != HTTP_DOWNLOAD_UNKNOWN ? 0 : DOWNLOAD_SEQUENTIAL);
+	}
+	download->State.Total = HTTP_DOWNLOAD_UNKNOWN;
+	result = _ReceiveResponse(download, ctx, segment);
+	return (result == 0 || result == DOWNLOAD_RESTART ? DOWNLOAD_SEQUENTIAL : result);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function splits file into equal segments, at least HTTP_DOWNLOAD_MIN_SEGMENT long.
+static void _Split(HttpDownload* download, unsigned int count) {
+	HttpDownloadState* state = &download->State;
+	HttpLength_t size = 0;
+	unsigned int i = 0;
+
+	if (count > state->Total / HTTP_DOWNLOAD_MIN_SEGMENT)
+		count = (unsigned int)(state->Total / HTTP_DOWNLOAD_MIN_SEGMENT);
+	if (count == 0)
+		count = 1;
+	size = state->Total / count;
+	state->SegmentCount = count;
+	for (i = 0; i < count; i++) {
+		state->Segments[i].Start = size * i;
+		state->Segments[i].Length = (i + 1 < count ? size : state->Total - size * i);
+		state->Segments[i].Done = 0;
+	}
+	HTTP_TRACE_INFO(NULL, HTTP_EVENT_DOWNLOAD_SPLIT, count, size, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function sizes output file to file size and reserves disk space (full disk
+// is found now, not by write or mapped memory access), then maps it if asked to.
+// Returns: Non-zero value on error.
+static int _Preallocate(HttpDownload* download) {
+	HttpLength_t total = download->State.Total;
+	void* map = NULL;
+
+	if (ftruncate(download->File, (off_t)total) != 0)
+		return HTTP_DOWNLOAD_ERROR_FILE;
+	if (total > 0 && posix_fallocate(download->File, 0, (off_t)total) == ENOSPC)
+		return HTTP_DOWNLOAD_ERROR_FILE;
+	if (!download->Mapped || total == 0)
+		return 0;
+	if (total > (HttpLength_t)(size_t)-1)
+		return HTTP_DOWNLOAD_ERROR_FILE;
+	map = mmap(NULL, (size_t)total, PROT_READ | PROT_WRITE, MAP_SHARED, download->File, 0);
+	if (map == MAP_FAILED)
+		return HTTP_DOWNLOAD_ERROR_FILE;
+	download->Map = (char*)map;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function downloads split file over all connections, failed segments are
+// retried (from bytes they miss) in next rounds.
+// Returns: Non-zero value on error (DOWNLOAD_RESTART - resource changed).
+static int _RunParallel(HttpDownload* download, HttpContext* contexts, unsigned int count) {
+	unsigned int retries = 0;
+	int timeout = (contexts[0].RecvTimeout > 0 ? contexts[0].RecvTimeout * 1000 : DOWNLOAD_STALL_TIMEOUT);
+	int result = 0;
+
+	while (_NextSegment(download) != NULL) {
+		result = _RunRound(download, contexts, count, timeout);
+		if (result == 0)
+			continue;
+		if (result == DOWNLOAD_RESTART || result == HTTP_DOWNLOAD_ERROR_FILE || result == HTTP_DOWNLOAD_ERROR_RESPONSE)
+			return result;
+		if (retries++ >= download->MaxRetries)
+			return result;
+		download->Retries++;
+		if (_SaveState(download) != 0)
+			return HTTP_DOWNLOAD_ERROR_FILE;
+	}
+	return 0;
+}
+#endif	// HTTPLIB_POSIX
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpDownloadInit(HttpDownload* download, const char* host, unsigned short port, unsigned char ssl, const char* path, const char* outputPath, const char* statePath) {
+	if (download == NULL || host == NULL || path == NULL || outputPath == NULL)
+		return -1;
+	// Host, colon, port (5 digits at most), path and terminator.
+	if (strlen(host) + 6 + strlen(path) + 1 > HTTP_DOWNLOAD_MAX_KEY)
+		return -1;
+	memset(download, 0, sizeof(HttpDownload));
+	download->Host = host;
+	download->Port = port;
+	download->Ssl = ssl;
+	download->Path = path;
+	download->OutputPath = outputPath;
+	download->StatePath = statePath;
+	download->MaxRetries = HTTP_DOWNLOAD_RETRIES;
+	download->File = -1;
+	memcpy(download->State.Magic, HTTP_DOWNLOAD_MAGIC, sizeof(download->State.Magic));
+	download->State.Version = HTTP_DOWNLOAD_VERSION;
+	sprintf(download->State.Key, "%s:%u%s", host, (unsigned int)port, path);
+	_ResetState(download);
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpDownloadRun(HttpDownload* download, HttpContext* ctx) {
+	int result = 0;
+
+	if (download == NULL || download->Host == NULL || ctx == NULL)
+		return HTTP_DOWNLOAD_ERROR_ARGUMENT;
+	result = _OpenOutput(download);
+	if (result != 0)
+		return result;
+	result = _RunSequential(download, ctx);
+	return _CloseOutput(download, result);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpDownloadRunParallel(HttpDownload* download, HttpContext* contexts, unsigned int count) {
+#ifdef HTTPLIB_POSIX
+	int result = 0;
+
+	if (download == NULL || download->Host == NULL || contexts == NULL || count == 0)
+		return HTTP_DOWNLOAD_ERROR_ARGUMENT;
+	if (count > HTTP_DOWNLOAD_MAX_SEGMENTS)
+		count = HTTP_DOWNLOAD_MAX_SEGMENTS;
+	result = _OpenOutput(download);
+	if (result != 0)
+		return result;
+	// Contexts may be left non-blocking by previous run.
+	contexts[0].NonBlocking = 0;
+	// Fresh download is split once its size is known, resumed one keeps its split.
+	if (download->State.Total == HTTP_DOWNLOAD_UNKNOWN && download->State.SegmentCount == 1 && download->State.Segments[0].Done == 0) {
+		result = _Probe(download, &contexts[0]);
+		if (result == 0)
+			_Split(download, count);
+	}
+	else if (download->State.Total == HTTP_DOWNLOAD_UNKNOWN) {
+		result = DOWNLOAD_SEQUENTIAL;
+	}
+	if (result == 0)
+		result = _Preallocate(download);
+	if (result == 0)
+		result = _RunParallel(download, contexts, count);
+	if (result == DOWNLOAD_RESTART) {
+		if (download->Map != NULL)
+			munmap(download->Map, (size_t)download->State.Total);
+		download->Map = NULL;
+		download->Restarts++;
+		_ResetState(download);
+		result = _TruncateOutput(download);
+		if (result == 0)
+			result = DOWNLOAD_SEQUENTIAL;
+	}
+	if (result == DOWNLOAD_SEQUENTIAL) {
+		contexts[0].NonBlocking = 0;
+		result = _RunSequential(download, &contexts[0]);
+	}
+	return _CloseOutput(download, result);
+#else
+	(void)download;
+	(void)contexts;
+	(void)count;
+	LOG_PRINTF(("\tParallel download is not supported."));
+	return -1;
+#endif	// HTTPLIB_POSIX
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpDownloadGetProgress(const HttpDownload* download, HttpLength_t* done, HttpLength_t* total) {
+	if (done)
+		*done = (download != NULL ? _DoneBytes(download) : 0);
+	if (total)
+		*total = (download != NULL ? download->State.Total : HTTP_DOWNLOAD_UNKNOWN);
+}
@@ -0,0 +1,82 @@
+#include "HttpLibPrivate.h"
+#include <HttpEpoll.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// This function steps request and updates its epoll registration.
+// Completed request is unregistered before its completion handler is called.
+static void _Advance(HttpEpoll* loop, HttpAsync* async) {
+	struct epoll_event event;
+	int result = 0;
+
+	result = _HttpAsyncStep(async);
+	if (result == HTTP_ASYNC_WOULD_BLOCK) {
+		memset(&event, 0, sizeof(event));
+		event.events = ((async->WaitEvents & HTTP_WAIT_READ) ? EPOLLIN : 0) | ((async->WaitEvents & HTTP_WAIT_WRITE) ? EPOLLOUT : 0);
+		event.data.ptr = async;
+		if (event.events == async->DriverEvents)
+			return;
+		if (epoll_ctl(loop->Fd, (async->DriverEvents == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD), async->WaitFd, &event) == 0) {
+			async->DriverEvents = event.events;
+			return;
+		}
+		HTTP_TRACE_ERROR(async->Context, HTTP_EVENT_EPOLL_ERROR, errno, 0, 0);
+		result = HTTP_TRANSPORT_ERROR;
+		async->State = HTTP_ASYNC_FAILED;
+		async->Result = result;
+		_HttpDisconnect(async->Context, 1);
+	}
+	// Failed request has closed its socket already (epoll dropped it then).
+	if (async->DriverEvents != 0 && result == HTTP_ASYNC_DONE)
+		epoll_ctl(loop->Fd, EPOLL_CTL_DEL, async->WaitFd, NULL);
+	async->DriverEvents = 0;
+	loop->Active--;
+	if (async->Done)
+		async->Done(async, result);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpEpollInit(HttpEpoll* loop) {
+	if (loop == NULL)
+		return -1;
+	loop->Active = 0;
+	loop->Fd = epoll_create1(EPOLL_CLOEXEC);
+	return (loop->Fd < 0 ? -1 : 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpEpollStart(HttpEpoll* loop, HttpAsync* async) {
+	async->DriverEvents = 0;
+	loop->Active++;
+	_Advance(loop, async);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpEpollRun(HttpEpoll* loop, int timeout) {
+	struct epoll_event events[HTTP_EPOLL_BATCH];
+	int count = 0;
+	int i = 0;
+
+	while (loop->Active > 0) {
+		count = epoll_wait(loop->Fd, events, HTTP_EPOLL_BATCH, timeout);
+		if (count < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (count == 0)
+			break;
+		for (i = 0; i < count; i++)
+			_Advance(loop, (HttpAsync*)events[i].data.ptr);
+	}
+	return (int)loop->Active;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpEpollDestroy(HttpEpoll* loop) {
+	if (loop->Fd >= 0)
+		close(loop->Fd);
+	loop->Fd = -1;
+}
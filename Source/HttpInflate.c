@@ -0,0 +1,301 @@
+#include "HttpLibPrivate.h"
+#include <HttpInflate.h>
+
+#ifdef HTTPLIB_ZLIB
+#include <zlib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Inflate window size (log2), the biggest one compressors use.
+#define HTTP_INFLATE_WINDOW_BITS		15
+// Biggest output given to zlib at once (its sizes are 32-bit).
+#define HTTP_INFLATE_MAX_OUTPUT			0x40000000u
+
+///////////////////////////////////////////////////////////////////////////////
+#define STREAM(inflater)				((z_stream*)(inflater)->Stream)
+
+///////////////////////////////////////////////////////////////////////////////
+static voidpf _ZAlloc(voidpf opaque, uInt items, uInt size) {
+	(void)opaque;
+	return _HttpGlobalAlloc((size_t)items * size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void _ZFree(voidpf opaque, voidpf address) {
+	(void)opaque;
+	_HttpGlobalFree(address);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function prepares inflater for body of current response.
+// Returns: Non-zero value on error.
+static int _BeginStream(HttpContext* ctx) {
+	HttpInflater* inflater = ctx->Inflater;
+
+	inflater->ResponseIn = 0;
+	inflater->RawDeflate = 0;
+	inflater->Pending = 0;
+	// gzip or zlib wrapper is detected automatically.
+	if (inflateReset2(STREAM(inflater), HTTP_INFLATE_WINDOW_BITS + 32) != Z_OK)
+		return HTTP_INFLATE_ERROR_DATA;
+	ctx->Flags |= INFLATING;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function drops raw body left behind compressed stream (i.e. last chunk),
+// so connection is ready for next response.
+// Returns: Non-zero value on error.
+static int _FinishBody(HttpContext* ctx) {
+	int span = 0;
+
+	while ((span = _HttpReceiveBodySpan(ctx)) > 0)
+		_HttpConsumeBodySpan(ctx, (unsigned int)span);
+	return span;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function inflates compressed body spans (taken in place from DataBuffer) into output.
+// Arguments:
+// 1) Context with inflater set up for current response.
+// 2) Output.
+// 3) Output size.
+// 4) Number of decoded bytes.
+// 5) Fill flag: return only when output is full (or stream ended), otherwise
+//    return as soon as something was decoded.
+// Returns: Non-zero value on error.
+static int _Inflate(HttpContext* ctx, char* output, size_t outputSize, size_t* produced, unsigned char fill) {
+	HttpInflater* inflater = ctx->Inflater;
+	z_stream* stream = STREAM(inflater);
+	uInt given = 0;
+	uInt taken = 0;
+	int span = 0;
+	int result = Z_OK;
+
+	*produced = 0;
+	if (outputSize > HTTP_INFLATE_MAX_OUTPUT)
+		outputSize = HTTP_INFLATE_MAX_OUTPUT;
+	stream->next_out = (Bytef*)output;
+	stream->avail_out = (uInt)outputSize;
+	while (stream->avail_out > 0 && !(ctx->Flags & INFLATE_END)) {
+		if (fill == 0 && stream->avail_out < outputSize)
+			break;
+		// Decoded data left in inflater (output was full) comes before new input is waited for.
+		if (inflater->Pending) {
+			stream->next_in = Z_NULL;
+			stream->avail_in = 0;
+		}
+		else {
+			span = _HttpReceiveBodySpan(ctx);
+			if (span < 0)
+				break;
+			// Raw body ended before compressed stream.
+			if (span == 0) {
+				span = HTTP_INFLATE_ERROR_DATA;
+				break;
+			}
+			stream->next_in = (Bytef*)(ctx->DataBuffer + ctx->DataHead);
+			stream->avail_in = (uInt)span;
+		}
+		given = stream->avail_in;
+		result = inflate(stream, Z_NO_FLUSH);
+		taken = given - stream->avail_in;
+		// Some servers send 'deflate' without zlib wrapper, stream is restarted as raw one.
+		if (result == Z_DATA_ERROR && ctx->Parser.ContentCoding == HTTP_CODING_DEFLATE && !inflater->RawDeflate && inflater->ResponseIn == 0) {
+			HTTP_TRACE_INFO(ctx, HTTP_EVENT_INFLATE_RAW, 0, 0, 0);
+			inflater->RawDeflate = 1;
+			if (inflateReset2(stream, -HTTP_INFLATE_WINDOW_BITS) != Z_OK)
+				break;
+			continue;
+		}
+		if (taken > 0) {
+			_HttpConsumeBodySpan(ctx, taken);
+			inflater->ResponseIn += taken;
+			inflater->CompressedBytes += taken;
+		}
+		inflater->Pending = (stream->avail_out == 0);
+		if (result == Z_STREAM_END) {
+			ctx->Flags |= INFLATE_END;
+			inflater->Pending = 0;
+		}
+		// No progress without more input.
+		else if (result == Z_BUF_ERROR)
+			inflater->Pending = 0;
+		else if (result != Z_OK) {
+			HTTP_TRACE_ERROR(ctx, HTTP_EVENT_INFLATE_ERROR, result, 0, 0);
+			span = HTTP_INFLATE_ERROR_DATA;
+			break;
+		}
+		span = 0;
+	}
+	*produced = outputSize - stream->avail_out;
+	inflater->DecodedBytes += *produced;
+	if (span < 0)
+		return span;
+	if (result != Z_OK && result != Z_BUF_ERROR && result != Z_STREAM_END)
+		return HTTP_INFLATE_ERROR_DATA;
+	if (ctx->Flags & INFLATE_END)
+		return _FinishBody(ctx);
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpInflaterInit(HttpInflater* inflater) {
+	z_stream* stream = NULL;
+
+	if (inflater == NULL)
+		return -1;
+	memset(inflater, 0, sizeof(HttpInflater));
+	stream = (z_stream*)_HttpGlobalAlloc(sizeof(z_stream));
+	inflater->Output = (char*)_HttpGlobalAlloc(HTTP_INFLATE_OUTPUT_SIZE);
+	if (stream == NULL || inflater->Output == NULL) {
+		if (stream)
+			_HttpGlobalFree(stream);
+		if (inflater->Output)
+			_HttpGlobalFree(inflater->Output);
+		inflater->Output = NULL;
+		return -1;
+	}
+	memset(stream, 0, sizeof(z_stream));
+	stream->zalloc = _ZAlloc;
+	stream->zfree = _ZFree;
+	if (inflateInit2(stream, HTTP_INFLATE_WINDOW_BITS + 32) != Z_OK) {
+		_HttpGlobalFree(stream);
+		_HttpGlobalFree(inflater->Output);
+		inflater->Output = NULL;
+		return -1;
+	}
+	inflater->Stream = stream;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpInflaterDestroy(HttpInflater* inflater) {
+	if (inflater == NULL || inflater->Stream == NULL)
+		return;
+	inflateEnd(STREAM(inflater));
+	_HttpGlobalFree(inflater->Stream);
+	_HttpGlobalFree(inflater->Output);
+	inflater->Stream = NULL;
+	inflater->Output = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSetInflater(HttpContext* ctx, HttpInflater* inflater) {
+	if (ctx == NULL || (inflater != NULL && inflater->Stream == NULL))
+		return -1;
+	ctx->Inflater = inflater;
+	// Stream is set up again for current response.
+	ctx->Flags &= ~(INFLATING | INFLATE_END);
+	return 0;
+}
+
+#else
+
+///////////////////////////////////////////////////////////////////////////////
+// Built without zlib: inflater can not be created, bodies are received as they are.
+static int _BeginStream(HttpContext* ctx) {
+	(void)ctx;
+	return HTTP_INFLATE_ERROR_CODING;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _Inflate(HttpContext* ctx, char* output, size_t outputSize, size_t* produced, unsigned char fill) {
+	(void)ctx;
+	(void)output;
+	(void)outputSize;
+	(void)fill;
+	*produced = 0;
+	return HTTP_INFLATE_ERROR_CODING;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpInflaterInit(HttpInflater* inflater) {
+	if (inflater != NULL)
+		memset(inflater, 0, sizeof(HttpInflater));
+	LOG_PRINTF(("\tLibrary built without zlib."));
+	return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpInflaterDestroy(HttpInflater* inflater) {
+	(void)inflater;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSetInflater(HttpContext* ctx, HttpInflater* inflater) {
+	if (ctx == NULL || inflater != NULL)
+		return -1;
+	ctx->Inflater = NULL;
+	return 0;
+}
+
+#endif	// HTTPLIB_ZLIB
+
+///////////////////////////////////////////////////////////////////////////////
+// This function receives header if needed and sets inflater up for current response.
+// Returns: 1 if body is to be decoded, 0 if it is received as it is, negative value on error.
+static int _PrepareDecoding(HttpContext* ctx) {
+	int result = 0;
+
+	if (!(ctx->Flags & HEADER_RECEIVED)) {
+		result = _HttpReceiveHeader(ctx);
+		if (result != 0)
+			return (result < 0 ? result : -1);
+	}
+	if (ctx->Flags & INFLATING)
+		return 1;
+	// Responses without body (HEAD, 204, 304) may name coding as well.
+	if (ctx->Inflater == NULL || ctx->Parser.ContentCoding == HTTP_CODING_IDENTITY || _HttpIsResponseConsumed(ctx))
+		return 0;
+	if (ctx->Parser.ContentCoding == HTTP_CODING_UNKNOWN)
+		return HTTP_INFLATE_ERROR_CODING;
+	result = _BeginStream(ctx);
+	return (result != 0 ? result : 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpRecvDecoded(HttpContext* ctx, void* buffer, size_t bufferSize, size_t* received) {
+	int result = 0;
+
+	if (ctx == NULL || received == NULL || (buffer == NULL && bufferSize > 0))
+		return -1;
+	*received = 0;
+	result = _PrepareDecoding(ctx);
+	if (result < 0)
+		return result;
+	if (result == 0)
+		return _HttpRecvLarge(ctx, buffer, bufferSize, received);
+	if (ctx->Flags & INFLATE_END)
+		return 0;
+	return _Inflate(ctx, (char*)buffer, bufferSize, received, 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpRecvDecodedToSink(HttpContext* ctx, HttpBodySink_t sink, void* sinkData) {
+	size_t produced = 0;
+	int action = 0;
+	int result = 0;
+
+	if (ctx == NULL || sink == NULL)
+		return -1;
+	result = _PrepareDecoding(ctx);
+	if (result < 0)
+		return result;
+	if (result == 0)
+		return _HttpRecvToSink(ctx, sink, sinkData);
+	while (!(ctx->Flags & INFLATE_END)) {
+		result = _Inflate(ctx, ctx->Inflater->Output, HTTP_INFLATE_OUTPUT_SIZE, &produced, 0);
+		if (produced > 0) {
+			action = sink(ctx, ctx->Inflater->Output, (unsigned int)produced, sinkData);
+			if (action == HTTP_SINK_PAUSE)
+				return 1;
+			if (action != HTTP_SINK_CONTINUE) {
+				HTTP_TRACE_INFO(ctx, HTTP_EVENT_SINK_ABORT, action, 0, 0);
+				return -2;
+			}
+		}
+		if (result != 0)
+			return result;
+	}
+	return 0;
+}
@@ -1,152 +1,95 @@
-#include <HttpLib.h>
+#include "HttpLibPrivate.h"
+#include <HttpBufferPool.h>
 #include <string.h>
 #include <stdio.h>
-#include <VCSLib.h>
 #include <stdlib.h>
-#include <logsys.h>
 
 ///////////////////////////////////////////////////////////////////////////////
-// Allocator used in code (default).
+// Global allocator, used by contexts without their own (default).
+// It is the only mutable global state of library, see _HttpSetMemoryInterface.
 static Allocator_t MemAlloc = malloc;
-// Deallocator used in code (default).
+// Global deallocator (default).
 static Deallocator_t MemFree = free;
 
 ///////////////////////////////////////////////////////////////////////////////
-static const char* MethodsText[] = {
-	"GET",
-	"HEAD",
-	"POST",
-	"PUT"
-};
+// Unread data is compacted to DataBuffer's beginning only when less than this
+// number of bytes is free behind write cursor.
+#define HTTP_BUFFER_MIN_FREE			64
+// Size of staging buffer small send segments are coalesced in (when transport has no Sendv).
+#define HTTP_SEND_COALESCE_SIZE			512
+// Free space DataBuffer is grown to (up to its limit) for body received in place (skipped or passed to sink).
+#define HTTP_BULK_READ_SIZE				2048
+// Property added to requests of contexts which decode compressed bodies.
+#define HTTP_ACCEPT_ENCODING_NAME		"accept-encoding:"
+#define HTTP_ACCEPT_ENCODING_LINE		"Accept-Encoding: gzip, deflate\r\n"
 
 ///////////////////////////////////////////////////////////////////////////////
-static const char* VersionsText[] = {
-	"1.0",
-	"1.1"
-};
+// Number of unread bytes in DataBuffer (between read and write cursor).
+#define DATA_IN_BUFFER(ctx)				((ctx)->DataTail - (ctx)->DataHead)
+// Pointer to first unread byte in DataBuffer.
+#define DATA_HEAD(ctx)					((ctx)->DataBuffer + (ctx)->DataHead)
+// Offset where unread data may start. Response header is kept in front of it.
+#define DATA_BASE(ctx)					((ctx)->Flags & HEADER_RECEIVED ? (ctx)->Parser.HeaderLength : 0)
 
 ///////////////////////////////////////////////////////////////////////////////
-// Prototypes.
-static int _ReceiveChunkedTransfer(char*, int, HttpContext*, unsigned short*);
-
-///////////////////////////////////////////////////////////////////////////////
-// Function for internal usage.
-// Sets passes pointer to method string name.
-inline static void _GetHttpMethodString(HttpMethod method, const char** methodText) {
-	*methodText = MethodsText[method];
-}
+// Chunked body decoder states (HttpContext::ChunkState).
+typedef enum HttpChunkState {
+	// Hex digits of chunk size.
+	CHUNK_SIZE,
+	// Chunk extension (or whitespace) up to end of size line.
+	CHUNK_EXTENSION,
+	// Chunk payload.
+	CHUNK_DATA,
+	// CRLF behind chunk payload.
+	CHUNK_DATA_END,
+	// Trailer section (properties up to empty line).
+	CHUNK_TRAILER,
+	// Whole body received.
+	CHUNK_DONE
+} HttpChunkState;
 
 ///////////////////////////////////////////////////////////////////////////////
-inline static void _GetHttpVersionString(HttpVersion version, const char** versionText) {
-	*versionText = VersionsText[version];
-}
+// Prototypes.
+static int _ReceiveChunkedTransfer(char*, size_t, HttpContext*, size_t*);
 
 ///////////////////////////////////////////////////////////////////////////////
+// Legacy request functions operate on null-terminated request. They attach
+// request builder to it (single scan) and let it do the work.
 int _HttpInitRequest(HttpMethod method, const char* site, HttpVersion version, char* request, int requestSize) {
-	// Selected method.
-	const char* methodString = NULL;
-	// Selected version.
-	const char* versionString = NULL;
-
-	// Check request buffer validity.
-	if (request && requestSize > 0) {
-		// Reset buffer.
-		memset(request, 0, requestSize);
-		// Resolve method.
-		_GetHttpMethodString(method, &methodString);
-		// Resolve version.
-		_GetHttpVersionString(version, &versionString);
-		// Format request.
-		sprintf(
-			request,
-			"%s %s HTTP/%s\r\n",
-			methodString,
-			site,
-			versionString
-		);
-		// Return success.
-		return 0;
-	}
-	// Return invalid buffer.
-	else
+	HttpRequestBuilder builder;
+
+	if (request == NULL || requestSize <= 0)
 		return -1;
+	return _HttpBuilderInit(&builder, request, (unsigned int)requestSize, method, site, version);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 int _HttpCompleteRequest(char* request, int requestBufferSize) {
-	size_t length = 0;
-
-	if (request && requestBufferSize > 0) {
-		// Search for \r\n\r\n.
-		if (strstr(request, "\r\n\r\n") == NULL) {
-			// Check if last 2 characters are \r\n. If yes append 1 more pair.
-			length = strlen(request);
-			if (request[length - 2] == '\r' && request[length - 1] == '\n') {
-				// Check if we can append.
-				if (length + 2 <= requestBufferSize) {
-					strcpy((request + length), "\r\n");
-					return length + 2;
-				}
-			}
-			// If not check if we can append 2x\r\n.
-			else {
-				if ((length + 4) <= requestBufferSize) {
-					strcpy((request + length), "\r\n\r\n");
-					return length + 4;
-				}
-			}
-		}
-		// Found. Probably header is terminated by 2xCRLF.
+	HttpRequestBuilder builder;
+
+	if (request == NULL || requestBufferSize <= 0)
 		return 0;
-	}
-	else
+	if (_HttpBuilderAttach(&builder, request, (unsigned int)requestBufferSize) != 0)
+		return 0;
+	// Header is already terminated.
+	if (builder.Complete)
 		return 0;
+	if (_HttpBuilderComplete(&builder) < 0)
+		return 0;
+	return (int)builder.Length;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 int _HttpSetProperty(const char* key, const char* value, char* request, int requestSize) {
-	// Current request length.
-	int requestLength = 0;
-	// Length of new property.
-	int propertyLength = 0;
-	// Pointer to substring found in request.
-	char* oldProperty = NULL;
-	// Pointer to substring tail (part that comes after old property).
-	char* propertyTail = NULL;
-
-	if (request && requestSize > 0) {
-		// Check if in request there is no such as property already set.
-		oldProperty = strstr(request, key);
-		if (oldProperty != NULL) {
-			// We have replace old property with new one.
-			// Search for tail (properties that will be kept).
-			propertyTail = strstr(oldProperty, "\r\n") + 2;
-			// Move tail.
-			strcpy(oldProperty, propertyTail);
-		}
-		// Get request length.
-		requestLength = strlen(request);
-		// 'PropertyName: Value\r\n'.
-		propertyLength = strlen(key) + 2 + strlen(value) + 2;
-		// Check if there is enough free space in buffer to add new property.
-		// We have to consider that request ends with 2x\r\n (4 bytes).
-		if ((requestSize - requestLength - propertyLength) >= 2) {
-			// Add new property.
-			sprintf(
-				(request + requestLength),
-				"%s: %s\r\n",
-				key,
-				value
-			);
-			// Return success.
-			return 0;
-		}
-		else
-			// There is no free space to add property.
-			return -2;
-	}
-	else
+	HttpRequestBuilder builder;
+	int result = 0;
+
+	if (request == NULL || requestSize <= 0)
 		return -1;
+	result = _HttpBuilderAttach(&builder, request, (unsigned int)requestSize);
+	if (result != 0)
+		return result;
+	return _HttpBuilderSetProperty(&builder, key, value);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -168,6 +111,8 @@ int _HttpGetProperty(const char* key, char* buffer, int bufferSize, const char*
 		else {
 			// Check if buffer is big enough to store property's value (1 is :).
 			valueSize = (int)(propertyTerm - propertyFound - strlen(key) - 1);
+			if (valueSize < 0 || valueSize >= bufferSize)
+				return -3;
 			strncpy(buffer, (propertyFound + strlen(key) + 1), valueSize);
 			// Set string terminator.
 			buffer[valueSize] = '\0';
@@ -181,57 +126,251 @@ int _HttpGetProperty(const char* key, char* buffer, int bufferSize, const char*
 
 ///////////////////////////////////////////////////////////////////////////////
 int _HttpSetRequestBody(const char* body, char* request, int requestSize) {
-	int requestLength = 0;
-	int bodyLength = strlen(body);
-	// Result buffer.
+	HttpRequestBuilder builder;
 	int result = 0;
-	// Text buffer.
-	char textBuffer[16] = { 0 };
-
-	// Check parameter validity.
-	if (request && requestSize > 0) {
-		// Before adding body to request, we have to check if Content-Length property is present.
-		if (strstr(request, "Content-Length") == NULL) {
-			// Add that field.
-			sprintf(textBuffer, "%d", bodyLength);
-			result = _HttpSetProperty("Content-Length", textBuffer, request, requestSize);
-			if (result != 0)
-				return result;
-		}
-		// Request length.
-		requestLength = strlen(request);
-		// Cehck if buffer is big enough to store body (2 bytes for header termination).
-		if ((requestSize - requestLength - bodyLength - 2) >= 0) {
-			// Set request body.
-			sprintf(
-				(request + requestLength),
-				"\r\n%s",
-				body
-			);
-			// Return request lenght.
-			return strlen(request);
-		}
-		else
-			return -2;
+
+	if (request == NULL || requestSize <= 0 || body == NULL)
+		return -1;
+	result = _HttpBuilderAttach(&builder, request, (unsigned int)requestSize);
+	if (result != 0)
+		return result;
+	return _HttpBuilderSetBody(&builder, body, strlen(body));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSetRequestBodyRaw(const void* bodyRaw, int bodySize, char* request, int requestSize) {
+	HttpRequestBuilder builder;
+	int result = 0;
+
+	if (request == NULL || requestSize <= 0 || bodySize < 0)
+		return -1;
+	result = _HttpBuilderAttach(&builder, request, (unsigned int)requestSize);
+	if (result != 0)
+		return result;
+	return _HttpBuilderSetBody(&builder, bodyRaw, (unsigned int)bodySize);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function returns transport assigned to context or platform default one.
+const HttpTransport* _HttpGetTransport(const HttpContext* ctx) {
+	if (ctx->Transport)
+		return ctx->Transport;
+#ifdef HTTPLIB_POSIX
+	return _HttpGetPosixTransport();
+#else
+	return _HttpGetVcsTransport();
+#endif	// HTTPLIB_POSIX
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function receives raw data using context's transport.
+static int _TransportRecv(HttpContext* ctx, void* buffer, size_t size, size_t* received) {
+	int result = 0;
+
+	*received = 0;
+	result = _HttpGetTransport(ctx)->Recv(ctx, buffer, size, received);
+	HTTP_STATS_RECEIVED(ctx, *received);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function sends raw data using given transport.
+static int _TransportSend(HttpContext* ctx, const HttpTransport* transport, const void* data, size_t size) {
+	HTTP_STATS_SENT(ctx, size);
+	return transport->Send(ctx, data, size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function marks response body end for stats (once per response).
+static void _StatsBodyEnd(HttpContext* ctx) {
+	if (ctx->Stats && !(ctx->Stats->Marked & (1u << HTTP_PHASE_BODY)) && _HttpIsResponseConsumed(ctx))
+		_HttpStatsMark(ctx, HTTP_PHASE_BODY);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function drops given number of bytes from the front of DataBuffer.
+// Only read cursor is moved, data is never shifted here.
+static void _ConsumeData(HttpContext* ctx, unsigned int size) {
+	ctx->DataHead += size;
+	// Buffer drained, both cursors can go back to the beginning for free.
+	if (ctx->DataHead == ctx->DataTail) {
+		ctx->DataHead = DATA_BASE(ctx);
+		ctx->DataTail = ctx->DataHead;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function moves unread data to the beginning of data area (behind response header).
+static void _CompactDataBuffer(HttpContext* ctx) {
+	unsigned int base = DATA_BASE(ctx);
+	unsigned int dataInBuffer = DATA_IN_BUFFER(ctx);
+
+	if (ctx->DataHead > base) {
+		memmove((ctx->DataBuffer + base), DATA_HEAD(ctx), dataInBuffer);
+		ctx->BufferStats.BytesMoved += dataInBuffer;
+		HTTP_STATS_ADD(ctx, BytesMoved, dataInBuffer);
+		ctx->BufferStats.Compactions++;
+		ctx->DataHead = base;
+		ctx->DataTail = base + dataInBuffer;
 	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void* _HttpGlobalAlloc(size_t size) {
+	return MemAlloc(size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpGlobalFree(void* memory) {
+	MemFree(memory);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function allocates DataBuffer memory from context's buffer pool or with
+// its allocator (global one if neither is set). Origin of memory is stored
+// under last two arguments (pool or deallocator).
+static char* _AllocDataMemory(const HttpContext* ctx, unsigned int size, HttpBufferPool** pool, Deallocator_t* dealloc) {
+	*pool = ctx->BufferPool;
+	*dealloc = NULL;
+	if (ctx->BufferPool)
+		return _HttpBufferPoolGet(ctx->BufferPool, size);
+	if (ctx->MemAlloc && ctx->MemFree) {
+		*dealloc = ctx->MemFree;
+		return ctx->MemAlloc(size);
+	}
+	*dealloc = MemFree;
+	return MemAlloc(size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function returns DataBuffer memory where it came from (pool or deallocator).
+static void _FreeDataMemory(char* memory, unsigned int size, HttpBufferPool* pool, Deallocator_t dealloc) {
+	if (pool)
+		_HttpBufferPoolPut(pool, memory, size);
 	else
+		(dealloc ? dealloc : MemFree)(memory);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function returns DataBuffer where it came from (DataBufferSize is still its size).
+static void _FreeDataBuffer(HttpContext* ctx) {
+	_FreeDataMemory(ctx->DataBuffer, ctx->DataBufferSize, ctx->DataBufferPool, ctx->DataBufferFree);
+	ctx->DataBuffer = NULL;
+	ctx->DataBufferFree = NULL;
+	ctx->DataBufferPool = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function releases DataBuffer replaced while response body was received.
+static void _FreeRetiredBuffer(HttpContext* ctx) {
+	if (ctx->RetiredBuffer == NULL)
+		return;
+	_FreeDataMemory(ctx->RetiredBuffer, ctx->RetiredBufferSize, ctx->RetiredBufferPool, ctx->RetiredBufferFree);
+	ctx->RetiredBuffer = NULL;
+	ctx->RetiredBufferSize = 0;
+	ctx->RetiredBufferFree = NULL;
+	ctx->RetiredBufferPool = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function replaces DataBuffer with new one of given size.
+// Response header and unread data are copied to new buffer. Once header is
+// received, old buffer is kept until next request (property values handed out
+// point into it).
+// Returns: Non-zero value on error (old buffer is kept then).
+static int _ResizeDataBuffer(HttpContext* ctx, unsigned int newSize) {
+	char* newBuffer = NULL;
+	HttpBufferPool* newPool = NULL;
+	Deallocator_t newFree = NULL;
+	unsigned int base = DATA_BASE(ctx);
+	unsigned int dataInBuffer = DATA_IN_BUFFER(ctx);
+
+	newBuffer = _AllocDataMemory(ctx, newSize, &newPool, &newFree);
+	if (newBuffer == NULL) {
+		HTTP_TRACE_ERROR(ctx, HTTP_EVENT_BUFFER_ERROR, newSize, 0, 0);
 		return -1;
+	}
+	memcpy(newBuffer, ctx->DataBuffer, base);
+	memcpy((newBuffer + base), DATA_HEAD(ctx), dataInBuffer);
+	ctx->BufferStats.BytesMoved += base + dataInBuffer;
+	HTTP_STATS_ADD(ctx, BytesMoved, base + dataInBuffer);
+	if (ctx->Flags & HEADER_RECEIVED) {
+		ctx->RetiredBuffer = ctx->DataBuffer;
+		ctx->RetiredBufferSize = ctx->DataBufferSize;
+		ctx->RetiredBufferFree = ctx->DataBufferFree;
+		ctx->RetiredBufferPool = ctx->DataBufferPool;
+	}
+	else {
+		_FreeDataBuffer(ctx);
+	}
+	ctx->DataBuffer = newBuffer;
+	ctx->DataBufferPool = newPool;
+	ctx->DataBufferFree = newFree;
+	ctx->DataBufferSize = newSize;
+	ctx->DataHead = base;
+	ctx->DataTail = base + dataInBuffer;
+	return 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-int _HttpSetRequestBodyRaw(const void* bodyRaw, int bodySize, char* request, int requestSize) {
-	// Generic text buffer.
-	char buffer[16] = { 0 };
-	// Request header length.
-	int headerLength = 0;
+// This function grows DataBuffer (doubling its size, up to context's limit) until
+// given number of bytes is free behind unread data. Buffer is replaced in single
+// step and once per response body (see _ResizeDataBuffer).
+// Returns: Non-zero value if buffer cannot grow.
+static int _GrowDataBuffer(HttpContext* ctx, unsigned int required) {
+	unsigned int limit = (ctx->DataBufferLimit > 0 ? ctx->DataBufferLimit : HTTP_BUFFER_LIMIT);
+	unsigned int used = DATA_BASE(ctx) + DATA_IN_BUFFER(ctx);
+	unsigned int newSize = ctx->DataBufferSize * 2;
+
+	if (ctx->DataBufferSize >= limit || ctx->RetiredBuffer != NULL)
+		return -1;
+	while (newSize < limit && (newSize - used) < required)
+		newSize *= 2;
+	newSize = (newSize > limit ? limit : newSize);
+	if (_ResizeDataBuffer(ctx, newSize) != 0)
+		return -1;
+	HTTP_TRACE_DEBUG(ctx, HTTP_EVENT_BUFFER_GROWN, newSize, 0, 0);
+	ctx->BufferStats.Grows++;
+	HTTP_STATS_ADD(ctx, BufferGrows, 1);
+	if (newSize > ctx->BufferStats.PeakSize)
+		ctx->BufferStats.PeakSize = newSize;
+	return 0;
+}
 
-	sprintf(buffer, "%d", bodySize);
-	_HttpSetProperty("Content-Length", buffer, request, requestSize);
-	_HttpCompleteRequest(request, requestSize);
-	headerLength = strlen(request);
-	memcpy(request + headerLength, bodyRaw, bodySize);
-	// Return complete request length.
-	return (headerLength + bodySize);
+///////////////////////////////////////////////////////////////////////////////
+// This function makes sure there are at least 'required' free bytes behind write cursor.
+// Unread data is compacted only when there is not enough space left,
+// if that does not help buffer grows (up to its limit).
+// Returns: number of free bytes behind write cursor.
+static unsigned int _ReserveDataSpace(HttpContext* ctx, unsigned int required) {
+	if ((ctx->DataBufferSize - ctx->DataTail) < required)
+		_CompactDataBuffer(ctx);
+	if ((ctx->DataBufferSize - ctx->DataTail) < required)
+		_GrowDataBuffer(ctx, required);
+	return (ctx->DataBufferSize - ctx->DataTail);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function releases grown DataBuffer, so next response starts with default size.
+// Buffer is kept as long as responses need it (last header did not fit in default size).
+// It is used between requests only (no data kept in buffer).
+static void _ShrinkDataBuffer(HttpContext* ctx) {
+	if (ctx->DataBuffer && ctx->DataBufferSize > HTTP_BUFFER_SIZE
+		&& ctx->Parser.HeaderLength + HTTP_BUFFER_MIN_FREE <= HTTP_BUFFER_SIZE) {
+		_FreeDataBuffer(ctx);
+		ctx->DataBufferSize = 0;
+		ctx->BufferStats.Shrinks++;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSetTransport(HttpContext* ctx, const HttpTransport* transport, void* transportData) {
+	// Transport cannot be changed on established connection.
+	if (ctx == NULL || (ctx->Flags & CONNECTED))
+		return -1;
+	ctx->Transport = transport;
+	ctx->TransportData = transportData;
+	return 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -239,18 +378,32 @@ int _HttpConnect(const char* url, unsigned short port, unsigned char ssl, HttpCo
 	// Result buffer.
 	int result = 0;
 
-	LOG_PRINTF(("_HttpConnect() ->"));
+	HTTP_TRACE_INFO(httpContext, HTTP_EVENT_CONNECT, port, ssl, 0);
 
-	// Intialize session with VCS.
-	result = VCS_InitializeSession(&httpContext->VCSSessionHandle, httpContext->Timeout);
-	// Check for error.
-	if (result != 0)
-		return result;
+	// Host name is kept for reconnection, connection pool and cache keys.
+	if (url == NULL || strlen(url) >= sizeof(httpContext->RemoteHost))
+		return -1;
+	// Non-blocking connect keeps its start time.
+	if (!(httpContext->Flags & CONNECTING))
+		HTTP_STATS_MARK(httpContext, HTTP_PHASE_CONNECT_START);
 	// Connect to remote host.
-	result = VCS_Connect(httpContext->VCSSessionHandle, url, port, ssl, httpContext->ConnectTimeout);
+	result = _HttpGetTransport(httpContext)->Connect(httpContext, url, port, ssl);
+	// Non-blocking connect continues with next call.
+	if (result == HTTP_TRANSPORT_WOULD_BLOCK) {
+		httpContext->Flags |= CONNECTING;
+		return result;
+	}
+	httpContext->Flags &= ~CONNECTING;
+	HTTP_TRACE_INFO(httpContext, HTTP_EVENT_CONNECT_RESULT, result, 0, 0);
 	// Check for error.
 	if (result != 0)
 		return result;
+	httpContext->Flags |= CONNECTED;
+	HTTP_STATS_MARK(httpContext, HTTP_PHASE_CONNECTED);
+	// Remember remote host (connection pool key, reconnection).
+	strcpy(httpContext->RemoteHost, url);
+	httpContext->RemotePort = port;
+	httpContext->RemoteSsl = ssl;
 	// Return success.
 	return 0;
 }
@@ -260,9 +413,19 @@ int _HttpConnect(const char* url, unsigned short port, unsigned char ssl, HttpCo
 // By state we understand flags and other request-response specific data.
 static void _ResetConnectionContext(HttpContext* ctx) {
 	ctx->ContentLength = 0;
-	ctx->Flags = 0;
-	ctx->DataInBuffer = 0;
+	// Connection state outlives single request.
+	ctx->Flags &= (CONNECTED | CONNECTING);
+	ctx->DataHead = 0;
+	ctx->DataTail = 0;
+	ctx->ChunkSize = 0;
 	ctx->ChunkRead = 0;
+	ctx->ChunkDigits = 0;
+	ctx->ChunkState = CHUNK_SIZE;
+	ctx->ContentRead = 0;
+	// Memory taken by long response header or big body reads is returned.
+	_FreeRetiredBuffer(ctx);
+	_ShrinkDataBuffer(ctx);
+	_HttpParserReset(ctx);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -270,21 +433,17 @@ int _HttpDisconnect(HttpContext* httpContext, unsigned char force) {
 	// Result buffer.
 	int result = 0;
 
-	LOG_PRINTF(("_HttpDisconnect() ->"));
+	HTTP_TRACE_INFO(httpContext, HTTP_EVENT_DISCONNECT, force, 0, 0);
 
 	// Drop data buffer.
 	if (httpContext->DataBuffer && httpContext->DataBufferSize > 0) {
-		MemFree(httpContext->DataBuffer);
-		httpContext->DataBuffer = NULL;
+		_FreeDataBuffer(httpContext);
 		httpContext->DataBufferSize = 0;
 	}
 	_ResetConnectionContext(httpContext);
 	// Disconnect from remote host.
-	result = VCS_Disconnect(httpContext->VCSSessionHandle, httpContext->Timeout);
-	if (!force && result != 0)
-		return result;
-	// End session with VCS.
-	result = VCS_DropSession(&httpContext->VCSSessionHandle, httpContext->Timeout);
+	result = _HttpGetTransport(httpContext)->Disconnect(httpContext, force);
+	httpContext->Flags &= ~(CONNECTED | CONNECTING);
 	if (!force && result != 0)
 		return result;
 	// Return success.
@@ -292,434 +451,938 @@ int _HttpDisconnect(HttpContext* httpContext, unsigned char force) {
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-int _HttpSend(const void* request, int requestSize, HttpContext* httpContext) {
-	char buffer[64] = { 0 };
-	int res = 0;
-	unsigned short dataRecv = 0;
+int _HttpReconnect(HttpContext* ctx) {
+	char host[HTTP_MAX_HOST_SIZE];
 
-	LOG_PRINTF(("_HttpSend() ->"));
+	if (ctx->RemoteHost[0] == '\0')
+		return -1;
+	// _HttpConnect stores host name in context again.
+	strcpy(host, ctx->RemoteHost);
+	HTTP_STATS_ADD(ctx, Retries, 1);
+	_HttpDisconnect(ctx, 1);
+	return _HttpConnect(host, ctx->RemotePort, ctx->RemoteSsl, ctx);
+}
 
-	while (httpContext->Flags & ENDING_CHUNK_REQUIRED && res == 0) {
-		res = _ReceiveChunkedTransfer(buffer, sizeof(buffer), httpContext, &dataRecv);
-	}
+///////////////////////////////////////////////////////////////////////////////
+int _HttpPrepareSend(HttpContext* httpContext) {
+	int result = 0;
 
+	// Rest of previous response must not be taken as next response.
+	result = _HttpSkipBody(httpContext, HTTP_SKIP_BODY_LIMIT);
+	if (result != 0) {
+		HTTP_TRACE_INFO(httpContext, HTTP_EVENT_RECONNECT, 0, 0, 0);
+		result = _HttpReconnect(httpContext);
+	}
+	// Data behind complete response belongs to next one.
+	if (result == 0 && DATA_IN_BUFFER(httpContext) > 0)
+		_HttpNextResponse(httpContext);
 	// We have to reset connection context to get rid of trash data.
-	_ResetConnectionContext(httpContext);
-	return VCS_TransmitRawData(httpContext->VCSSessionHandle, request, requestSize, httpContext->Timeout);
+	else
+		_ResetConnectionContext(httpContext);
+	if (result == 0)
+		HTTP_STATS_MARK(httpContext, HTTP_PHASE_REQUEST_START);
+	return result;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// This function converts hex string to integer value.
-// As parameters it takes: string pointer and its length (path of big buffer).
-// Returns converted value.
-static int _HexToInt(const char* hexString, unsigned int hexStringLength) {
-	// Null-terminated copy of hexString.
-	char* hexZeroString = NULL;
-	// Result buffer.
+// This function finds where Accept-Encoding property goes in serialized request:
+// behind last header property line.
+// Returns: Offset or 0 if request has the property already (or its header is not complete).
+static unsigned int _AcceptEncodingOffset(const char* request, unsigned int size) {
+	unsigned int nameLength = sizeof(HTTP_ACCEPT_ENCODING_NAME) - 1;
+	unsigned int line = 0;
+	unsigned int i = 0;
+	unsigned int j = 0;
+
+	for (i = 0; i + 3 < size; i++) {
+		if (request[i] != '\r' || request[i + 1] != '\n')
+			continue;
+		line = i + 2;
+		// Empty line terminates header.
+		if (request[line] == '\r' && request[line + 1] == '\n')
+			return line;
+		for (j = 0; j < nameLength && line + j < size && HTTP_TO_LOWER(request[line + j]) == HTTP_ACCEPT_ENCODING_NAME[j]; j++)
+			;
+		if (j == nameLength)
+			return 0;
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSend(const void* request, int requestSize, HttpContext* httpContext) {
+	HttpIoVec vectors[3];
+	unsigned int offset = 0;
 	int result = 0;
 
-	// Allocate buffer for copy of hexString (null-terminated).
-	hexZeroString = MemAlloc(hexStringLength + 1);
-	// Check for errors.
-	if (hexZeroString == NULL)
-		// Return error.
-		return -1;
-	// Set string terminator.
-	hexZeroString[hexStringLength] = '\0';
-	// Copy string.
-	strncpy(hexZeroString, hexString, hexStringLength);
-	// Convert value.
-	result = strtol(hexZeroString, NULL, 16);
-	// Free buffer.
-	MemFree(hexZeroString);
+	HTTP_TRACE_INFO(httpContext, HTTP_EVENT_SEND, requestSize, 0, 0);
+
+	result = _HttpPrepareSend(httpContext);
+	if (result != 0)
+		return result;
+	if (_HttpIsHeadRequest(request, requestSize))
+		httpContext->Flags |= HEAD_REQUEST;
+	if (httpContext->Inflater)
+		offset = _AcceptEncodingOffset((const char*)request, (unsigned int)requestSize);
+	if (offset > 0) {
+		vectors[0].Data = request;
+		vectors[0].Size = offset;
+		vectors[1].Data = HTTP_ACCEPT_ENCODING_LINE;
+		vectors[1].Size = sizeof(HTTP_ACCEPT_ENCODING_LINE) - 1;
+		vectors[2].Data = (const char*)request + offset;
+		vectors[2].Size = (size_t)requestSize - offset;
+		result = _HttpSendSegments(httpContext, vectors, 3);
+	}
+	else
+		result = _TransportSend(httpContext, _HttpGetTransport(httpContext), request, (size_t)requestSize);
+	if (result == 0) {
+		httpContext->Flags |= RESPONSE_PENDING;
+		HTTP_STATS_MARK(httpContext, HTTP_PHASE_REQUEST_SENT);
+	}
 	return result;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// This function extracts properties values from response's header.
-// If any additional property's value is needed, code should be added here.
-static void _ExtractResponseProperties(const char* buffer, HttpContext* ctx) {
-	// Buffer for property's value.
-	char propertyValue[128] = { 0 };
-	// Result buffer.
+// This function sends segments using transport's Send only.
+// Small segments are copied into staging buffer and sent together, segments
+// not smaller than staging buffer are sent directly. So every write is bounded
+// by max(HTTP_SEND_COALESCE_SIZE, segment size) and nothing big is copied.
+static int _SendCoalesced(HttpContext* ctx, const HttpTransport* transport, const HttpIoVec* vectors, unsigned int count) {
+	char staging[HTTP_SEND_COALESCE_SIZE];
+	size_t staged = 0;
+	size_t toCopy = 0;
+	size_t offset = 0;
+	unsigned int i = 0;
 	int result = 0;
 
-	// Get Content-Length.
-	result = _HttpGetProperty("Content-Length", propertyValue, sizeof(propertyValue), buffer);
-	if (result == 0)
-		ctx->ContentLength = (size_t)atoi(propertyValue);
-	// Get Transfer-Encoding.
-	result = _HttpGetProperty("Transfer-Encoding", propertyValue, sizeof(propertyValue), buffer);
-	// If we have chunked transfer, set all flags.
-	if (strstr(propertyValue, "chunked") != NULL)
-		//ctx->Flags |= TRANSFER_CHUNKED;
-		ctx->Flags |= TRANSFER_CHUNKED | ENDING_CHUNK_REQUIRED;
+	for (i = 0; i < count; i++) {
+		if (vectors[i].Size >= sizeof(staging)) {
+			if (staged > 0) {
+				result = _TransportSend(ctx, transport, staging, staged);
+				if (result != 0)
+					return result;
+				staged = 0;
+			}
+			result = _TransportSend(ctx, transport, vectors[i].Data, vectors[i].Size);
+			if (result != 0)
+				return result;
+			continue;
+		}
+		for (offset = 0; offset < vectors[i].Size; offset += toCopy) {
+			toCopy = vectors[i].Size - offset;
+			toCopy = (toCopy > sizeof(staging) - staged ? sizeof(staging) - staged : toCopy);
+			memcpy(staging + staged, (const char*)vectors[i].Data + offset, toCopy);
+			staged += toCopy;
+			// Staging buffer full.
+			if (staged == sizeof(staging)) {
+				result = _TransportSend(ctx, transport, staging, staged);
+				if (result != 0)
+					return result;
+				staged = 0;
+			}
+		}
+	}
+	if (staged > 0)
+		return _TransportSend(ctx, transport, staging, staged);
+	return 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// This function finds last occurence of given value.
-static const char* _FindLast(const char* source, const char* value) {
-	const char* last = NULL;
-	const char* current = NULL;
+int _HttpIsHeadRequest(const void* request, unsigned int size) {
+	return (size >= 5 && memcmp(request, "HEAD ", 5) == 0);
+}
 
-	for (;;) {
-		current = strstr(source, value);
-		if (current == NULL)
-			return last;
-		else {
-			source = current + 2;
-			last = current;
+///////////////////////////////////////////////////////////////////////////////
+// This function sends segments with transport (vectored if supported).
+int _HttpSendSegments(HttpContext* ctx, const HttpIoVec* vectors, unsigned int count) {
+	const HttpTransport* transport = _HttpGetTransport(ctx);
+	unsigned int i = 0;
+
+	if (transport->Sendv) {
+		if (ctx->Stats) {
+			ctx->Stats->SendCalls++;
+			for (i = 0; i < count; i++)
+				ctx->Stats->BytesSent += vectors[i].Size;
 		}
+		return transport->Sendv(ctx, vectors, count);
+	}
+	return _SendCoalesced(ctx, transport, vectors, count);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSendv(HttpContext* ctx, const HttpIoVec* vectors, unsigned int count) {
+	int result = 0;
+
+	HTTP_TRACE_INFO(ctx, HTTP_EVENT_SENDV, count, 0, 0);
+
+	if (ctx == NULL || (vectors == NULL && count > 0))
+		return -1;
+	result = _HttpPrepareSend(ctx);
+	if (result != 0)
+		return result;
+	if (count > 0 && _HttpIsHeadRequest(vectors[0].Data, vectors[0].Size))
+		ctx->Flags |= HEAD_REQUEST;
+	result = _HttpSendSegments(ctx, vectors, count);
+	if (result == 0) {
+		ctx->Flags |= RESPONSE_PENDING;
+		HTTP_STATS_MARK(ctx, HTTP_PHASE_REQUEST_SENT);
 	}
+	return result;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-static void _HandleEndOfHttpHeader(const char* headerEnd, HttpContext* ctx) {
-    size_t offset = 0;
+int _HttpBeginChunkedUpload(HttpContext* ctx, HttpRequestBuilder* builder) {
+	HttpIoVec header;
+	int result = 0;
+
+	if (ctx == NULL || builder == NULL)
+		return -1;
+	// Message length is given by chunked framing only.
+	_HttpBuilderRemoveProperty(builder, "Content-Length");
+	result = _HttpBuilderSetProperty(builder, "Transfer-Encoding", "chunked");
+	if (result != 0)
+		return result;
+	result = _HttpBuilderComplete(builder);
+	if (result < 0)
+		return result;
+	header.Data = builder->Buffer;
+	header.Size = builder->BodyOffset;
+	HTTP_TRACE_INFO(ctx, HTTP_EVENT_UPLOAD_BEGIN, header.Size, 0, 0);
+	result = _HttpPrepareSend(ctx);
+	if (result != 0)
+		return result;
+	result = _HttpSendSegments(ctx, &header, 1);
+	if (result == 0)
+		ctx->Flags |= UPLOADING_CHUNKED | RESPONSE_PENDING;
+	return result;
+}
 
-    // We set complete header flag.
-    ctx->Flags |= HEADER_RECEIVED;
-    // We calculate how much data is body.
-    offset = (headerEnd + 4/*\r\n\r\n*/ - ctx->DataBuffer);
-    // Update how much data left in buffer.
-    ctx->DataInBuffer -= offset;
-    // Now we shift data that belongs to body at buffer's beginning.
-    memmove(ctx->DataBuffer, (headerEnd + 4), ctx->DataInBuffer);
+///////////////////////////////////////////////////////////////////////////////
+int _HttpWriteChunk(HttpContext* ctx, const void* data, unsigned int size) {
+	static const char hexDigits[] = "0123456789ABCDEF";
+	// Chunk size line: up to 8 hex digits and CRLF.
+	char sizeLine[10];
+	unsigned int length = 0;
+	unsigned int shift = 0;
+	HttpIoVec vectors[3];
+
+	if (ctx == NULL || !(ctx->Flags & UPLOADING_CHUNKED) || (data == NULL && size > 0))
+		return -1;
+	if (size == 0)
+		return 0;
+	// Skip leading zero digits.
+	for (shift = 28; shift > 0 && ((size >> shift) & 0xF) == 0; shift -= 4)
+		;
+	for (;; shift -= 4) {
+		sizeLine[length++] = hexDigits[(size >> shift) & 0xF];
+		if (shift == 0)
+			break;
+	}
+	sizeLine[length++] = '\r';
+	sizeLine[length++] = '\n';
+	vectors[0].Data = sizeLine;
+	vectors[0].Size = length;
+	vectors[1].Data = data;
+	vectors[1].Size = size;
+	vectors[2].Data = "\r\n";
+	vectors[2].Size = 2;
+	return _HttpSendSegments(ctx, vectors, 3);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-static void _HandleLastCompleteProperty(const char* lastFullProperty, HttpContext* ctx) {
-    size_t offset = 0;
+int _HttpEndChunkedUpload(HttpContext* ctx, const char* const* trailers, unsigned int trailerCount) {
+	// Last chunk, 4 segments per trailer and terminating empty line.
+	HttpIoVec vectors[1 + 4 * HTTP_MAX_TRAILERS + 1];
+	unsigned int count = 0;
+	unsigned int i = 0;
+	int result = 0;
+
+	HTTP_TRACE_INFO(ctx, HTTP_EVENT_UPLOAD_END, trailerCount, 0, 0);
 
-    // Last full property offset.
-    offset = lastFullProperty - ctx->DataBuffer;
-    // Update how much data left in buffer.
-    ctx->DataInBuffer -= offset;
-    // Shift incomplete property at the beginning.
-    memmove(ctx->DataBuffer, lastFullProperty, ctx->DataInBuffer);
+	if (ctx == NULL || !(ctx->Flags & UPLOADING_CHUNKED) || trailerCount > HTTP_MAX_TRAILERS || (trailers == NULL && trailerCount > 0))
+		return -1;
+	vectors[count].Data = "0\r\n";
+	vectors[count++].Size = 3;
+	for (i = 0; i < trailerCount; i++) {
+		vectors[count].Data = trailers[2 * i];
+		vectors[count++].Size = strlen(trailers[2 * i]);
+		vectors[count].Data = ": ";
+		vectors[count++].Size = 2;
+		vectors[count].Data = trailers[2 * i + 1];
+		vectors[count++].Size = strlen(trailers[2 * i + 1]);
+		vectors[count].Data = "\r\n";
+		vectors[count++].Size = 2;
+	}
+	vectors[count].Data = "\r\n";
+	vectors[count++].Size = 2;
+	result = _HttpSendSegments(ctx, vectors, count);
+	ctx->Flags &= ~UPLOADING_CHUNKED;
+	if (result == 0)
+		HTTP_STATS_MARK(ctx, HTTP_PHASE_REQUEST_SENT);
+	return result;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // This function is responsible for receiving complete response header.
-// It parses properties and modifies HttpContext configuration.
+// Header is parsed as it arrives (each byte once) and modifies HttpContext configuration.
+// Complete header is kept at DataBuffer's beginning, body data follows it.
 // Returns: non-zero value on error.
 static int _ReadHttpHeader(HttpContext* ctx) {
-    int result = 0;
-    unsigned short dataReceived = 0;
-    const char* headerEnd = NULL;
-    const char* lastCompleteProperty = NULL;
-
-    LOG_PRINTF(("_ReadHttpHeader() ->"));
-
-    do {
-        // Receive data from server.
-        result = VCS_RecieveRawData(
-            ctx->VCSSessionHandle,
-            (unsigned char*)(ctx->DataBuffer + ctx->DataInBuffer),
-            // Receive bufferSize - 1 to provide slot for \0.
-            (ctx->DataBufferSize - ctx->DataInBuffer - 1),
-            &dataReceived,
-            ctx->RecvTimeout
-        );
-
-        LOG_PRINTF(("\t@@ dataReceived: %d", dataReceived));
-        // Check if we received any data.
-        if (dataReceived > 0) {
-            // Update data amount in buffer.
-            ctx->DataInBuffer += dataReceived;
-            // Set string-zero terminator.
-            ctx->DataBuffer[ctx->DataInBuffer] = 0;
-
-            LOG_PRINTF(("\t@@ ctx->DataInBuffer: '%s'", ctx->DataBuffer));
-
-            // Try to extract all required response's properties.
-            _ExtractResponseProperties(ctx->DataBuffer, ctx);
-            // Search for HTTP header terminator.
-            headerEnd = strstr(ctx->DataBuffer, HTTP_HEADER_TERMINATOR);
-            // If we received complete http header.
-            if (headerEnd != NULL) {
-                LOG_PRINTF(("\tFound header terminator."));
-                _HandleEndOfHttpHeader(headerEnd, ctx);
-            }
-            // We received another header part.
-            else {
-                // Try to locate last complete property in this part.
-                // Next property (which is not complete) will be moved to buffer's beginning.
-                lastCompleteProperty = _FindLast(ctx->DataBuffer, HTTP_PROPERTY_DELIMITER);
-                // If we found last complete property, we shift remaining data to the buffer's beginning.
-                if (lastCompleteProperty) {
-                    LOG_PRINTF(("\t@@ lastCompleteProperty: '%s'", lastCompleteProperty));
-                    _HandleLastCompleteProperty(lastCompleteProperty, ctx);
-                }
-                // If we could not locate last complete property that means out buffer is too small.
-                else {
-                    // TODO #1
-                    LOG_PRINTF(("\tBuffer too small to receive response header. Buffer does not contain header terminator '\\r\\n\\r\\n' neither 1 complete header property."));
-                    // Buffer too small.
-                    return -1;
-                }
-            }
-        }
-        // Transmission error.
-        else {
-            LOG_PRINTF(("\tNo data read from TCP socket. Result: %d.", result));
-            // Header could not be read.
-            return -1;
-        }
-    } while (!(ctx->Flags & HEADER_RECEIVED));
-
-    // Return success.
-    return 0;
-}
-
-///////////////////////////////////////////////////////////////////////////////
-static int _ReceiveChunkedTransfer(char* buffer, int bufferSize, HttpContext* ctx, unsigned short* dataReceived) {
-	// Result buffer.
 	int result = 0;
-	// Chunk size terminator pointer.
-	char* chunkTerminator = NULL;
-	unsigned int toRecv = 0;
-	// Number of bytes recieved in current call.
-	unsigned int dataRecvTotal = 0;
-	// Size of data received by VCS_RecieveRawData.
-	*dataReceived = 0;
-
-    LOG_PRINTF(("_ReceiveChunkedTransfer() ->"));
-
-	// Check if we are reading chunk right now.
-	// If not we have to find chunk size first.
-	if (!(ctx->Flags & READING_CHUNK)) {
-		// If we have no data in DataBuffer we have to fill it up.
-		// [Value]\r\n.
-		if (ctx->DataInBuffer < 3) {
-			result = VCS_RecieveRawData(
-				ctx->VCSSessionHandle,
-				(unsigned char*)(ctx->DataBuffer + ctx->DataInBuffer),
-				(ctx->DataBufferSize - ctx->DataInBuffer),
-				dataReceived,
-				ctx->RecvTimeout
-			);
-			// Check for error.
-			if (result != 0) {
-				LOG_PRINTF(("Data receiving error: %d", result));
-				return result;
-			}
-			// Increase DataInBuffer by dataReceived.
-			ctx->DataInBuffer += *dataReceived;
+	size_t dataReceived = 0;
+
+	// Header has to start at buffer's beginning.
+	_CompactDataBuffer(ctx);
+	HTTP_TRACE_DEBUG(ctx, HTTP_EVENT_HEADER_READ, DATA_IN_BUFFER(ctx), 0, 0);
+	// Response may be buffered already (pipelining).
+	if (DATA_IN_BUFFER(ctx) > 0)
+		HTTP_STATS_MARK(ctx, HTTP_PHASE_FIRST_BYTE);
+	// Parse data which is already in buffer first.
+	while ((result = _HttpParseResponse(ctx)) == HTTP_PARSE_INCOMPLETE) {
+		// Make room for next header part. Buffer grows if needed.
+		if (_ReserveDataSpace(ctx, HTTP_BUFFER_MIN_FREE) == 0) {
+			HTTP_TRACE_ERROR(ctx, HTTP_EVENT_HEADER_LIMIT, ctx->DataBufferSize, 0, 0);
+			return -1;
 		}
-		// It could happen that first 2 characters will be \r\n, so we have to omit them.
-		if (ctx->DataBuffer[0] == '\r' && ctx->DataBuffer[1] == '\n') {
-			memmove(ctx->DataBuffer, (ctx->DataBuffer + 2), (ctx->DataInBuffer - 2));
-			ctx->DataInBuffer -= 2;
+		// Receive data from server.
+		result = _TransportRecv(
+			ctx,
+			(ctx->DataBuffer + ctx->DataTail),
+			(ctx->DataBufferSize - ctx->DataTail),
+			&dataReceived
+		);
+		// Transmission error.
+		if (dataReceived == 0) {
+			if (result != HTTP_TRANSPORT_WOULD_BLOCK)
+				HTTP_TRACE_ERROR(ctx, HTTP_EVENT_HEADER_RECV_ERROR, result, 0, 0);
+			// Non-blocking context, parsing resumes with next call.
+			if (result == HTTP_TRANSPORT_WOULD_BLOCK)
+				return result;
+			// Header could not be read.
+			return -1;
 		}
-		// Here we have buffer filled up with data.
-		// Find chunk size terminator (\r\n).
-		chunkTerminator = strstr(ctx->DataBuffer, "\r\n");
-		// Check if we found terminator.
-		if (chunkTerminator == NULL) {
-			LOG_PRINTF(("\tDid not find chunk terminator in buffer."));
+		// Move write cursor.
+		ctx->DataTail += (unsigned int)dataReceived;
+		HTTP_TRACE_DEBUG(ctx, HTTP_EVENT_HEADER_SEGMENT, dataReceived, DATA_IN_BUFFER(ctx), 0);
+		HTTP_STATS_MARK(ctx, HTTP_PHASE_FIRST_BYTE);
+		// Track buffer high-water mark.
+		if (DATA_IN_BUFFER(ctx) > ctx->BufferStats.PeakUsage)
+			ctx->BufferStats.PeakUsage = DATA_IN_BUFFER(ctx);
+	}
+	if (result == HTTP_PARSE_ERROR) {
+		HTTP_TRACE_ERROR(ctx, HTTP_EVENT_HEADER_MALFORMED, 0, 0, 0);
+		return -1;
+	}
+	// We set complete header flag, data behind header belongs to body.
+	ctx->Flags |= HEADER_RECEIVED;
+	ctx->DataHead = ctx->Parser.HeaderLength;
+	HTTP_TRACE_INFO(ctx, HTTP_EVENT_HEADER, ctx->Parser.StatusCode, ctx->ContentLength, DATA_IN_BUFFER(ctx));
+	HTTP_STATS_MARK(ctx, HTTP_PHASE_HEADER);
+	// Responses without body end here.
+	_StatsBodyEnd(ctx);
+	// Return success.
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpReceiveHeader(HttpContext* ctx) {
+	// Check if we have data buffer already created.
+	if (ctx->DataBuffer == NULL) {
+		// Create buffer.
+		ctx->DataBuffer = _AllocDataMemory(ctx, HTTP_BUFFER_SIZE, &ctx->DataBufferPool, &ctx->DataBufferFree);
+		// Check for error.
+		if (ctx->DataBuffer == NULL) {
+			HTTP_TRACE_ERROR(ctx, HTTP_EVENT_BUFFER_ERROR, HTTP_BUFFER_SIZE, 0, 0);
 			return -1;
 		}
-		// Save new chunk size.
-		ctx->ChunkSize = _HexToInt(ctx->DataBuffer, (chunkTerminator - ctx->DataBuffer));
-		// Throw out chunk size from DataBuffer.
-		ctx->DataInBuffer = (ctx->DataInBuffer - (chunkTerminator - ctx->DataBuffer) - 2);
-		memmove(ctx->DataBuffer, (chunkTerminator + 2), ctx->DataInBuffer);
-
-		// If chunk size is 0, then we received ending chunk.
-		if (ctx->ChunkSize == 0) {
-			// Reset flag that ending chunk is required.
-			ctx->Flags &= ~ENDING_CHUNK_REQUIRED;
-			LOG_PRINTF(("\tGot ending chunk."));
-			*dataReceived = 0;
+		// Save buffer size.
+		ctx->DataBufferSize = HTTP_BUFFER_SIZE;
+		if (ctx->BufferStats.PeakSize < HTTP_BUFFER_SIZE)
+			ctx->BufferStats.PeakSize = HTTP_BUFFER_SIZE;
+	}
+	return _ReadHttpHeader(ctx);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpNextResponse(HttpContext* ctx) {
+	ctx->ContentLength = 0;
+	ctx->Flags &= (CONNECTED | CONNECTING);
+	ctx->ChunkSize = 0;
+	ctx->ChunkRead = 0;
+	ctx->ChunkDigits = 0;
+	ctx->ChunkState = CHUNK_SIZE;
+	ctx->ContentRead = 0;
+	_FreeRetiredBuffer(ctx);
+	// Unread data is kept, header is parsed from it.
+	_HttpParserReset(ctx);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function returns value of hex digit or -1 if character is not hex digit.
+static int _HexDigit(unsigned char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	c = (unsigned char)HTTP_TO_LOWER(c);
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function starts chunk after its size line was parsed.
+static void _EndChunkSizeLine(HttpContext* ctx) {
+	ctx->ChunkRead = 0;
+	if (ctx->ChunkSize == 0) {
+		HTTP_TRACE_DEBUG(ctx, HTTP_EVENT_CHUNK_LAST, 0, 0, 0);
+		ctx->ChunkState = CHUNK_TRAILER;
+	}
+	else {
+		HTTP_TRACE_DEBUG(ctx, HTTP_EVENT_CHUNK, ctx->ChunkSize, 0, 0);
+		ctx->ChunkState = CHUNK_DATA;
+		ctx->Flags |= READING_CHUNK;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function parses chunk framing (size line with extensions, CRLF behind payload)
+// from DataBuffer. It stops at chunk payload, at trailer section or when buffered data ends.
+// Returns: non-zero value on malformed framing.
+static int _ParseChunkFraming(HttpContext* ctx) {
+	const unsigned char* data = (const unsigned char*)DATA_HEAD(ctx);
+	unsigned int available = DATA_IN_BUFFER(ctx);
+	unsigned int position = 0;
+	int digit = 0;
+
+	for (; position < available; position++) {
+		switch (ctx->ChunkState) {
+		case CHUNK_SIZE:
+			digit = _HexDigit(data[position]);
+			if (digit >= 0) {
+				// Chunk size has to fit in HttpLength_t.
+				if (ctx->ChunkSize > ((HttpLength_t)-1 >> 4))
+					return -1;
+				ctx->ChunkSize = (ctx->ChunkSize << 4) | (HttpLength_t)digit;
+				ctx->ChunkDigits++;
+			}
+			else if (ctx->ChunkDigits == 0)
+				return -1;
+			else if (data[position] == '\n')
+				_EndChunkSizeLine(ctx);
+			// Extension (';'), whitespace or CR, ignored up to end of line.
+			else
+				ctx->ChunkState = CHUNK_EXTENSION;
+			break;
+		case CHUNK_EXTENSION:
+			if (data[position] == '\n')
+				_EndChunkSizeLine(ctx);
+			break;
+		case CHUNK_DATA_END:
+			if (data[position] == '\n') {
+				ctx->ChunkState = CHUNK_SIZE;
+				ctx->ChunkSize = 0;
+				ctx->ChunkDigits = 0;
+			}
+			else if (data[position] != '\r')
+				return -1;
+			break;
+		default:
+			// Payload or trailer, parsed elsewhere.
+			_ConsumeData(ctx, position);
 			return 0;
 		}
-		else {
-			LOG_PRINTF(("\tNew chunk of size: %d.", ctx->ChunkSize));
-			// Set flags.
-			ctx->Flags |= /*ENDING_CHUNK_REQUIRED |*/ READING_CHUNK;
+	}
+	_ConsumeData(ctx, position);
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function parses complete trailer lines from DataBuffer. Trailer properties
+// are passed to trailer handler. Empty line ends message.
+static void _ParseChunkTrailer(HttpContext* ctx) {
+	const char* line = NULL;
+	const char* lineEnd = NULL;
+	const char* colon = NULL;
+	const char* value = NULL;
+	unsigned int lineLength = 0;
+	unsigned int valueLength = 0;
+
+	while (ctx->ChunkState == CHUNK_TRAILER) {
+		line = DATA_HEAD(ctx);
+		lineEnd = (const char*)memchr(line, '\n', DATA_IN_BUFFER(ctx));
+		if (lineEnd == NULL)
+			return;
+		// Line without CRLF.
+		lineLength = (unsigned int)(lineEnd - line);
+		if (lineLength > 0 && line[lineLength - 1] == '\r')
+			lineLength--;
+		if (lineLength == 0)
+			ctx->ChunkState = CHUNK_DONE;
+		else if (ctx->TrailerHandler && (colon = (const char*)memchr(line, ':', lineLength)) != NULL) {
+			value = colon + 1;
+			valueLength = (unsigned int)(line + lineLength - value);
+			while (valueLength > 0 && (*value == ' ' || *value == '\t')) {
+				value++;
+				valueLength--;
+			}
+			while (valueLength > 0 && (value[valueLength - 1] == ' ' || value[valueLength - 1] == '\t'))
+				valueLength--;
+			ctx->TrailerHandler(ctx, line, (unsigned int)(colon - line), value, valueLength, ctx->TrailerHandlerData);
 		}
+		_ConsumeData(ctx, (unsigned int)(lineEnd + 1 - line));
 	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function decodes chunked body. Decoder is resumable: framing may be split
+// anywhere between reads. Payload is copied from DataBuffer, or if it is empty,
+// received straight into caller's buffer. Chunks are joined while buffered data lasts.
+// Returns: non-zero value on error.
+static int _ReceiveChunkedTransfer(char* buffer, size_t bufferSize, HttpContext* ctx, size_t* dataReceived) {
+	size_t delivered = 0;
+	size_t toCopy = 0;
+	size_t received = 0;
+	int result = 0;
 
-	// Calculate how much data we should receive in this call (what left for current chunk).
-	toRecv = (ctx->ChunkSize - ctx->ChunkRead);
-	// If it is more than we can store in output buffer then we limit use bufferSize as limit.
-	toRecv = (toRecv > bufferSize ? bufferSize : toRecv);
-
-	// If we have anything in buffer we have to receive it first.
-	if (ctx->DataInBuffer > toRecv) {
-		// We receive toRecv.
-		memcpy(buffer, ctx->DataBuffer, toRecv);
-		// Shift data in buffer.
-		memmove(ctx->DataBuffer, (ctx->DataBuffer + toRecv), (ctx->DataInBuffer - toRecv));
-		// Decrease DataInBuffer size.
-		ctx->DataInBuffer -= toRecv;
-		// Set dataReceived.
-		dataRecvTotal = toRecv;
-		// Increase ChunkRead.
-		ctx->ChunkRead += toRecv;
-		// Reset toRecv as we already received all allowed bytes.
-		toRecv = 0;
-	}
-	else if (ctx->DataInBuffer > 0 && ctx->DataInBuffer < toRecv) {
-		// Get everything from DataBuffer.
-		memcpy(buffer, ctx->DataBuffer, ctx->DataInBuffer);
-		// Decrease toRecv by DataInBuffer value.
-		toRecv -= ctx->DataInBuffer;
-		// Set dataReceived.
-		dataRecvTotal = ctx->DataInBuffer;
-		// Increase ChunkRead.
-		ctx->ChunkRead += ctx->DataInBuffer;
-		// Reset data in buffer.
-		ctx->DataInBuffer = 0;
-	}
-
-	// Use VCS_Recv to receive all left toRecv bytes.
-	result = VCS_RecieveRawData(
-		ctx->VCSSessionHandle,
-		(unsigned char*)(buffer + dataRecvTotal),
-		toRecv,
-		dataReceived,
-		ctx->RecvTimeout
-	);
-	// Increase dataRecvTotal by dataReceived (in current call).
-	dataRecvTotal += *dataReceived;
-	// Increase ChunkRead as global state variable.
-	ctx->ChunkRead += *dataReceived;
-
-	// Check if we completly read current chunk.
-	if (ctx->ChunkRead == ctx->ChunkSize) {
-		LOG_PRINTF(("\tChunk of size: %d received completely.", ctx->ChunkSize));
-		// Reset receiving flag.
-		ctx->Flags &= ~READING_CHUNK;
-		// Reset chunk read.
-		ctx->ChunkRead = 0;
-	}
-
-	// Save datReceived.
-	*dataReceived = dataRecvTotal;
+	*dataReceived = 0;
+	while (ctx->ChunkState != CHUNK_DONE) {
+		if (_ParseChunkFraming(ctx) != 0) {
+			HTTP_TRACE_ERROR(ctx, HTTP_EVENT_CHUNK_MALFORMED, 0, 0, 0);
+			return -1;
+		}
+		// Framing may end with last chunk, trailer can be already buffered.
+		if (ctx->ChunkState == CHUNK_TRAILER)
+			_ParseChunkTrailer(ctx);
+		if (ctx->ChunkState == CHUNK_DATA) {
+			if (delivered == bufferSize)
+				break;
+			toCopy = bufferSize - delivered;
+			if (ctx->ChunkSize - ctx->ChunkRead < toCopy)
+				toCopy = (size_t)(ctx->ChunkSize - ctx->ChunkRead);
+			if (DATA_IN_BUFFER(ctx) > 0) {
+				toCopy = (toCopy > DATA_IN_BUFFER(ctx) ? DATA_IN_BUFFER(ctx) : toCopy);
+				memcpy(buffer + delivered, DATA_HEAD(ctx), toCopy);
+				_ConsumeData(ctx, (unsigned int)toCopy);
+			}
+			// Do not wait for more data when we have something to return.
+			else if (delivered > 0)
+				break;
+			else {
+				result = _TransportRecv(ctx, buffer, toCopy, &received);
+				if (received == 0)
+					return (result != 0 ? result : -1);
+				toCopy = received;
+			}
+			delivered += toCopy;
+			ctx->ChunkRead += toCopy;
+			if (ctx->ChunkRead == ctx->ChunkSize) {
+				ctx->ChunkState = CHUNK_DATA_END;
+				ctx->Flags &= ~READING_CHUNK;
+			}
+			continue;
+		}
+		if (ctx->ChunkState == CHUNK_DONE || delivered > 0)
+			break;
+		// Framing continues in data not received yet.
+		if (_ReserveDataSpace(ctx, HTTP_BUFFER_MIN_FREE) == 0) {
+			HTTP_TRACE_ERROR(ctx, HTTP_EVENT_CHUNK_NO_SPACE, 0, 0, 0);
+			return -1;
+		}
+		result = _TransportRecv(
+			ctx,
+			(ctx->DataBuffer + ctx->DataTail),
+			(ctx->DataBufferSize - ctx->DataTail),
+			&received
+		);
+		if (received == 0) {
+			if (result != HTTP_TRANSPORT_WOULD_BLOCK)
+				HTTP_TRACE_ERROR(ctx, HTTP_EVENT_RECV_ERROR, result, 0, 0);
+			return (result != 0 ? result : -1);
+		}
+		ctx->DataTail += (unsigned int)received;
+	}
+	// Message ends with trailer, data behind it belongs to next response.
+	if (ctx->ChunkState == CHUNK_DONE) {
+		ctx->Flags &= ~ENDING_CHUNK_REQUIRED;
+		_StatsBodyEnd(ctx);
+	}
+	*dataReceived = delivered;
 	return 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // This function receives http data in plain encoding.
 // Returns: non-zero value on error.
-static int _ReceivePlainTransfer(char* buffer, int bufferSize, HttpContext* ctx, unsigned short* dataRecieved) {
+static int _ReceivePlainTransfer(char* buffer, size_t bufferSize, HttpContext* ctx, size_t* dataRecieved) {
 	int result = 0;
-	int dataToBeCopied = 0;
+	size_t dataToBeCopied = 0;
+
+	// Body ends after Content-Length bytes, data behind it belongs to next response.
+	if ((ctx->Flags & CONTENT_LENGTH_KNOWN) && bufferSize > ctx->ContentLength - ctx->ContentRead)
+		bufferSize = (size_t)(ctx->ContentLength - ctx->ContentRead);
 
 	// If we have data in DataBuffer, we receive it first.
-	if (ctx->DataInBuffer > 0) {
+	if (DATA_IN_BUFFER(ctx) > 0) {
 		// Calculate how much data we can recieve at once.
-		dataToBeCopied = (ctx->DataInBuffer > bufferSize ? bufferSize : ctx->DataInBuffer);
+		dataToBeCopied = (DATA_IN_BUFFER(ctx) > bufferSize ? bufferSize : DATA_IN_BUFFER(ctx));
 		// Copy to output buffer.
-		memcpy(buffer, ctx->DataBuffer, dataToBeCopied);
-		// Decrease DataInBuffer value by dataToBeCopied, as it is already received.
-		ctx->DataInBuffer -= dataToBeCopied;
-		// Shift data in buffer by those we received.
-		memmove(ctx->DataBuffer, (ctx->DataBuffer + dataToBeCopied), ctx->DataInBuffer);
+		memcpy(buffer, DATA_HEAD(ctx), dataToBeCopied);
+		// Move read cursor by data we received.
+		_ConsumeData(ctx, (unsigned int)dataToBeCopied);
 		// Set how much data we already copied.
 		*dataRecieved = dataToBeCopied;
-		// If dataToBeCopied is less than buffer size, we get additional data from VCS.
+		// If dataToBeCopied is less than buffer size, we get additional data from transport.
 		if (dataToBeCopied < bufferSize) {
-			result = VCS_RecieveRawData(
-				ctx->VCSSessionHandle,
-				(unsigned char*)(buffer + dataToBeCopied),
+			result = _TransportRecv(
+				ctx,
+				(buffer + dataToBeCopied),
 				(bufferSize - dataToBeCopied),
-				dataRecieved,
-				ctx->RecvTimeout
+				dataRecieved
 			);
 			// We have to add dataToBeCopied value, as we are completing buffer.
 			*dataRecieved += dataToBeCopied;
 		}
 	}
-	// There is no data in DataBuffer, so we simply receive new data from VCS.
+	// There is no data in DataBuffer, so we simply receive new data from transport.
 	else
-		result = VCS_RecieveRawData(ctx->VCSSessionHandle, (unsigned char*)buffer, bufferSize, dataRecieved, ctx->RecvTimeout);
+		result = _TransportRecv(ctx, buffer, bufferSize, dataRecieved);
+	ctx->ContentRead += *dataRecieved;
+	// Without Content-Length this is regular body end.
+	if (result == HTTP_TRANSPORT_CLOSED)
+		ctx->Flags |= CONNECTION_CLOSED;
+	_StatsBodyEnd(ctx);
+	// Data already copied is returned, error shows up on next call.
+	if (*dataRecieved > 0)
+		result = 0;
 
 	// Return result.
 	return result;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// This function receives body data with transfer type specific function.
+// Returns: non-zero value on error.
+static int _ReceiveBody(char* buffer, size_t bufferSize, HttpContext* ctx, size_t* dataReceived) {
+	*dataReceived = 0;
+	if (ctx->Flags & TRANSFER_CHUNKED) {
+		if (ctx->Flags & ENDING_CHUNK_REQUIRED)
+			return _ReceiveChunkedTransfer(buffer, bufferSize, ctx, dataReceived);
+		// Break immediately if ending chunk was recived.
+		return 0;
+	}
+	return _ReceivePlainTransfer(buffer, bufferSize, ctx, dataReceived);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Here we specify how much data we can recieve.
 int _HttpRecv(char* buffer, int bufferSize, HttpContext* ctx) {
 	// Result buffer.
 	int result = 0;
 	// How much data has been received.
-	unsigned short dataReceived = 0;
-
-    LOG_PRINTF(("_HttpRecv() ->"));
+	size_t dataReceived = 0;
 
-	// Check if we have data buffer already created.
-	if (ctx->DataBuffer == NULL) {
-		// Create buffer.
-		ctx->DataBuffer = MemAlloc(HTTP_BUFFER_SIZE);
-		// Check for error.
-		if (ctx->DataBuffer == NULL) {
-			LOG_PRINTF(("\tCould not create DataBuffer of size: %d", HTTP_BUFFER_SIZE));
-			return 0;
-		}
-		// Save buffer size.
-		ctx->DataBufferSize = HTTP_BUFFER_SIZE;
-	}
+	if (bufferSize <= 0)
+		return 0;
 
 	// Check if we already received response header.
 	if (!(ctx->Flags & HEADER_RECEIVED)) {
 		// We receive header.
-        result = _ReadHttpHeader(ctx);
+        result = _HttpReceiveHeader(ctx);
 		// Check for error.
 		if (result < 0) {
-			LOG_PRINTF(("\tHttp header receiving error: %d", result));
 			// For safety we return 0, as no data were received.
 			return 0;
 		}
-		LOG_PRINTF(("\tHeader received successfully. Data left: %d", ctx->DataInBuffer));
 	}
+	// Whole body received (or there is none), data behind it belongs to next response.
+	if (_HttpIsResponseConsumed(ctx))
+		return 0;
 
 	// Here we are sure that response header has been received.
-	// Depending on transfer type (chunked or not) we use specific function.
-	if (ctx->Flags & TRANSFER_CHUNKED) {
-        if (ctx->Flags & ENDING_CHUNK_REQUIRED)
-            result = _ReceiveChunkedTransfer(buffer, bufferSize, ctx, &dataReceived);
-        // Break immediately if ending chunk was recived.
-        else
-            result = 0;
-	}
-	else
-		result = _ReceivePlainTransfer(buffer, bufferSize, ctx, &dataReceived);
+	result = _ReceiveBody(buffer, (size_t)bufferSize, ctx, &dataReceived);
 
     // On success.
     if (result == 0) {
-        LOG_PRINTF(("\t@@ dataReceived: %d", dataReceived));
+        HTTP_TRACE_DEBUG(ctx, HTTP_EVENT_RECV, dataReceived, bufferSize, 0);
         // And we return dataRecieved.
         return (int)dataReceived;
     }
     // Error occured.
     else {
-        LOG_PRINTF(("\tData receiving error: %d", result));
+        HTTP_TRACE_ERROR(ctx, HTTP_EVENT_RECV_ERROR, result, 0, 0);
         return 0;
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-int _HttpIsConnected(const HttpContext* ctx) {
-	unsigned short socketStatus = 0;
+int _HttpRecvLarge(HttpContext* ctx, void* buffer, size_t bufferSize, size_t* received) {
+	size_t delivered = 0;
+	size_t dataReceived = 0;
 	int result = 0;
 
-	// Check if session handle is correct.
-	if (ctx->VCSSessionHandle < 15) {
-		result = VCS_GetSocketStatus(ctx->VCSSessionHandle, &socketStatus, ctx->Timeout);
-		// Check for error.
+	if (ctx == NULL || received == NULL || (buffer == NULL && bufferSize > 0))
+		return -1;
+	*received = 0;
+	if (!(ctx->Flags & HEADER_RECEIVED)) {
+		result = _HttpReceiveHeader(ctx);
 		if (result != 0)
+			return result;
+	}
+	// Every transport call asks for all bytes still missing in buffer (up to body end).
+	while (delivered < bufferSize && !_HttpIsResponseConsumed(ctx)) {
+		result = _ReceiveBody((char*)buffer + delivered, bufferSize - delivered, ctx, &dataReceived);
+		delivered += dataReceived;
+		if (result != 0 || dataReceived == 0)
+			break;
+	}
+	*received = delivered;
+	HTTP_TRACE_DEBUG(ctx, HTTP_EVENT_RECV, delivered, bufferSize, 0);
+	if (result != 0) {
+		if (result != HTTP_TRANSPORT_WOULD_BLOCK)
+			HTTP_TRACE_ERROR(ctx, HTTP_EVENT_RECV_ERROR, result, 0, 0);
+		return result;
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function returns number of body bytes which follow for sure: rest of current
+// chunk or Content-Length body (unlimited for body ended by connection close).
+// Valid for plain body or when chunk payload is being read.
+static HttpLength_t _BodySpanLimit(const HttpContext* ctx) {
+	if (ctx->Flags & TRANSFER_CHUNKED)
+		return ctx->ChunkSize - ctx->ChunkRead;
+	if (ctx->Flags & CONTENT_LENGTH_KNOWN)
+		return ctx->ContentLength - ctx->ContentRead;
+	return (HttpLength_t)-1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpReceiveBodySpan(HttpContext* ctx) {
+	HttpLength_t limit = 0;
+	unsigned int size = 0;
+	size_t received = 0;
+	int result = 0;
+
+	while (!_HttpIsResponseConsumed(ctx)) {
+		if ((ctx->Flags & TRANSFER_CHUNKED) && ctx->ChunkState != CHUNK_DATA) {
+			// Decoder stops at chunk payload when it has no buffer to fill.
+			result = _ReceiveChunkedTransfer(NULL, 0, ctx, &received);
+			if (result != 0)
+				return (result < 0 ? result : -1);
+			continue;
+		}
+		limit = _BodySpanLimit(ctx);
+		if (DATA_IN_BUFFER(ctx) > 0)
+			return (int)(DATA_IN_BUFFER(ctx) > limit ? limit : DATA_IN_BUFFER(ctx));
+		// Read as much as buffer takes, but not past body end.
+		size = _ReserveDataSpace(ctx, HTTP_BULK_READ_SIZE);
+		if (size > limit)
+			size = (unsigned int)limit;
+		result = _TransportRecv(ctx, (ctx->DataBuffer + ctx->DataTail), size, &received);
+		if (received == 0) {
+			// Without Content-Length this is regular body end.
+			if (result == HTTP_TRANSPORT_CLOSED)
+				ctx->Flags |= CONNECTION_CLOSED;
+			if (_HttpIsResponseConsumed(ctx)) {
+				_StatsBodyEnd(ctx);
+				return 0;
+			}
+			if (result != HTTP_TRANSPORT_WOULD_BLOCK)
+				HTTP_TRACE_ERROR(ctx, HTTP_EVENT_RECV_ERROR, result, 0, 0);
+			return (result < 0 ? result : -1);
+		}
+		ctx->DataTail += (unsigned int)received;
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpConsumeBodySpan(HttpContext* ctx, unsigned int size) {
+	_ConsumeData(ctx, size);
+	if (ctx->Flags & TRANSFER_CHUNKED) {
+		ctx->ChunkRead += size;
+		if (ctx->ChunkRead == ctx->ChunkSize) {
+			ctx->ChunkState = CHUNK_DATA_END;
+			ctx->Flags &= ~READING_CHUNK;
+		}
+	}
+	else
+		ctx->ContentRead += size;
+	_StatsBodyEnd(ctx);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSkipBody(HttpContext* ctx, HttpLength_t maxBytes) {
+	HttpLength_t skipped = 0;
+	int result = 0;
+
+	if (ctx == NULL)
+		return -1;
+	// Request was not completed, remote host still waits for its body.
+	if (ctx->Flags & UPLOADING_CHUNKED) {
+		_HttpDisconnect(ctx, 1);
+		return 1;
+	}
+	if (!(ctx->Flags & HEADER_RECEIVED)) {
+		// No response expected.
+		if (!(ctx->Flags & RESPONSE_PENDING))
 			return 0;
-		// If there was no error, we return actual socket status.
-		return (int)socketStatus;
+		result = _HttpReceiveHeader(ctx);
+	}
+	while (result == 0 && !_HttpIsResponseConsumed(ctx)) {
+		// Reconnecting is cheaper than receiving the rest.
+		if (maxBytes != HTTP_SKIP_BODY_ALL && (!(ctx->Flags & TRANSFER_CHUNKED) || ctx->ChunkState == CHUNK_DATA)
+			&& _BodySpanLimit(ctx) > maxBytes - skipped) {
+			HTTP_TRACE_INFO(ctx, HTTP_EVENT_SKIP_TOO_BIG, _BodySpanLimit(ctx), 0, 0);
+			_HttpDisconnect(ctx, 1);
+			return 1;
+		}
+		result = _HttpReceiveBodySpan(ctx);
+		if (result > 0) {
+			skipped += (unsigned int)result;
+			_HttpConsumeBodySpan(ctx, (unsigned int)result);
+			result = 0;
+		}
+	}
+	if (result != 0) {
+		HTTP_TRACE_ERROR(ctx, HTTP_EVENT_SKIP_ERROR, result, 0, 0);
+		_HttpDisconnect(ctx, 1);
+		return (result < 0 ? result : -1);
+	}
+	// Body was ended by connection close or remote host closes connection after
+	// response (Connection: close, HTTP/1.0), connection cannot be reused.
+	if (ctx->Flags & (CONNECTION_CLOSED | CONNECTION_CLOSE)) {
+		_HttpDisconnect(ctx, 1);
+		return 1;
 	}
-	// Invalid handle.
 	return 0;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+int _HttpRecvToSink(HttpContext* ctx, HttpBodySink_t sink, void* sinkData) {
+	int span = 0;
+	int result = 0;
+
+	if (ctx == NULL || sink == NULL)
+		return -1;
+	if (!(ctx->Flags & HEADER_RECEIVED)) {
+		result = _HttpReceiveHeader(ctx);
+		if (result != 0)
+			return result;
+	}
+	while ((span = _HttpReceiveBodySpan(ctx)) > 0) {
+		// Sink reads body in place, span is dropped afterwards whatever sink returns.
+		result = sink(ctx, DATA_HEAD(ctx), (unsigned int)span, sinkData);
+		_HttpConsumeBodySpan(ctx, (unsigned int)span);
+		if (result == HTTP_SINK_PAUSE)
+			return 1;
+		if (result != HTTP_SINK_CONTINUE) {
+			HTTP_TRACE_INFO(ctx, HTTP_EVENT_SINK_ABORT, result, 0, 0);
+			return -2;
+		}
+	}
+	return span;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpGetResponseStatus(const HttpContext* ctx, unsigned short* statusCode, HttpVersion* version, const char** reason, unsigned int* reasonLength) {
+	if (!(ctx->Flags & HEADER_RECEIVED))
+		return -1;
+	if (statusCode)
+		*statusCode = ctx->Parser.StatusCode;
+	if (version)
+		*version = (ctx->Parser.VersionMajor == 1 && ctx->Parser.VersionMinor == 0 ? HTTP_10 : HTTP_11);
+	if (reason)
+		*reason = ctx->DataBuffer + ctx->Parser.ReasonOffset;
+	if (reasonLength)
+		*reasonLength = ctx->Parser.ReasonLength;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function compares property names (case-insensitive).
+static int _NameEquals(const char* name, const char* other, unsigned int length) {
+	unsigned int i = 0;
+
+	for (i = 0; i < length; i++) {
+		if (HTTP_TO_LOWER(name[i]) != HTTP_TO_LOWER(other[i]))
+			return 0;
+	}
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpGetResponseHeader(const HttpContext* ctx, const char* name, const char** value, unsigned int* valueLength) {
+	const HttpHeaderEntry* entry = NULL;
+	unsigned int hash = HTTP_HASH_INIT;
+	unsigned int length = 0;
+	unsigned int slot = 0;
+
+	if (!(ctx->Flags & HEADER_RECEIVED))
+		return -1;
+	for (length = 0; name[length] != '\0'; length++)
+		hash = HTTP_HASH_STEP(hash, HTTP_TO_LOWER(name[length]));
+	// Probe index until empty slot. Entries are inserted in order, so first match is first occurence.
+	for (slot = hash & (HTTP_HEADER_INDEX_SIZE - 1); ctx->Headers.Index[slot] != 0; slot = (slot + 1) & (HTTP_HEADER_INDEX_SIZE - 1)) {
+		entry = &ctx->Headers.Entries[ctx->Headers.Index[slot] - 1];
+		if (entry->Hash == hash && entry->NameLength == length && _NameEquals(ctx->DataBuffer + entry->NameOffset, name, length)) {
+			*value = ctx->DataBuffer + entry->ValueOffset;
+			*valueLength = entry->ValueLength;
+			return 0;
+		}
+	}
+	return -2;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpGetResponseHeaderAt(const HttpContext* ctx, unsigned int index, const char** name, unsigned int* nameLength, const char** value, unsigned int* valueLength) {
+	const HttpHeaderEntry* entry = NULL;
+
+	if (!(ctx->Flags & HEADER_RECEIVED) || index >= ctx->Headers.Count)
+		return -1;
+	entry = &ctx->Headers.Entries[index];
+	if (name)
+		*name = ctx->DataBuffer + entry->NameOffset;
+	if (nameLength)
+		*nameLength = entry->NameLength;
+	if (value)
+		*value = ctx->DataBuffer + entry->ValueOffset;
+	if (valueLength)
+		*valueLength = entry->ValueLength;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpIsResponseConsumed(const HttpContext* ctx) {
+	unsigned short status = ctx->Parser.StatusCode;
+
+	if (!(ctx->Flags & HEADER_RECEIVED))
+		return 0;
+	// Responses without body.
+	if ((ctx->Flags & HEAD_REQUEST) || (status >= 100 && status < 200) || status == 204 || status == 304)
+		return 1;
+	if (ctx->Flags & TRANSFER_CHUNKED)
+		return !(ctx->Flags & ENDING_CHUNK_REQUIRED);
+	if (ctx->Flags & CONTENT_LENGTH_KNOWN)
+		return (ctx->ContentRead >= ctx->ContentLength);
+	// Body is delimited by connection close.
+	return ((ctx->Flags & CONNECTION_CLOSED) != 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSetTrailerHandler(HttpContext* ctx, HttpTrailerHandler_t handler, void* handlerData) {
+	if (ctx == NULL)
+		return -1;
+	ctx->TrailerHandler = handler;
+	ctx->TrailerHandlerData = handlerData;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpIsConnected(const HttpContext* ctx) {
+	return _HttpGetTransport(ctx)->IsConnected(ctx);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 int _HttpSetMemoryInterface(Allocator_t alloc, Deallocator_t free) {
 	// Both arguments must be valid pointers.
@@ -731,3 +1394,14 @@ int _HttpSetMemoryInterface(Allocator_t alloc, Deallocator_t free) {
 	// Invalid arguments, return error.
 	return -1;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSetContextMemoryInterface(HttpContext* ctx, Allocator_t alloc, Deallocator_t free) {
+	// Both pointers are set or both are NULL (global interface).
+	if (ctx == NULL || (alloc == NULL) != (free == NULL))
+		return -1;
+	// Current buffer keeps deallocator it was allocated for.
+	ctx->MemAlloc = alloc;
+	ctx->MemFree = free;
+	return 0;
+}
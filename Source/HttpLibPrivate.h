@@ -0,0 +1,157 @@
+#ifndef HTTPLIBPRIVATE_H
+#define HTTPLIBPRIVATE_H
+
+/*
+	Definitions shared by HttpLib source files only.
+	Not part of library interface.
+*/
+
+#include <HttpLib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Logging. On terminal we use logsys, on Linux (HTTPLIB_POSIX) stdout.
+#ifdef HTTPLIB_POSIX
+#ifdef LOGSYS_FLAG
+#include <stdio.h>
+#define LOG_PRINTF(args) (printf args, printf("\n"))
+#else
+#define LOG_PRINTF(args)
+#endif	// LOGSYS_FLAG
+#else
+#include <logsys.h>
+#endif	// HTTPLIB_POSIX
+
+///////////////////////////////////////////////////////////////////////////////
+// Response header properties recognized by parser while parsing.
+typedef enum HttpKnownProperty {
+	PROPERTY_CONTENT_LENGTH,
+	PROPERTY_TRANSFER_ENCODING,
+	PROPERTY_CONNECTION,
+	PROPERTY_CONTENT_ENCODING,
+	// Number of known properties.
+	PROPERTY_COUNT,
+	// Property parsed is not known one.
+	PROPERTY_UNKNOWN = 0xFF
+} HttpKnownProperty;
+
+///////////////////////////////////////////////////////////////////////////////
+// Header property name hash (FNV-1a over lowercase characters).
+#define HTTP_HASH_INIT					2166136261u
+#define HTTP_HASH_STEP(hash, c)			(((hash) ^ (unsigned char)(c)) * 16777619u)
+#define HTTP_TO_LOWER(c)				((c) >= 'A' && (c) <= 'Z' ? (c) + ('a' - 'A') : (c))
+
+///////////////////////////////////////////////////////////////////////////////
+// Millisecond tick counter (monotonic, may wrap).
+#ifdef HTTPLIB_POSIX
+#include <time.h>
+static inline unsigned long _HttpTicks(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long)now.tv_sec * 1000ul + (unsigned long)(now.tv_nsec / 1000000);
+}
+#define HTTP_TICKS()					_HttpTicks()
+#else
+#include <svc.h>
+#define HTTP_TICKS()					((unsigned long)read_ticks())
+#endif	// HTTPLIB_POSIX
+
+///////////////////////////////////////////////////////////////////////////////
+// Stats hooks (see HttpStats.h), contexts without stats only test the pointer.
+#include <HttpStats.h>
+extern void _HttpStatsMark(HttpContext*, HttpPhase);
+#define HTTP_STATS_MARK(ctx, phase)			do { if ((ctx)->Stats) _HttpStatsMark((ctx), (phase)); } while (0)
+#define HTTP_STATS_ADD(ctx, counter, value)	do { if ((ctx)->Stats) (ctx)->Stats->counter += (value); } while (0)
+#define HTTP_STATS_SENT(ctx, size)			do { if ((ctx)->Stats) { (ctx)->Stats->SendCalls++; (ctx)->Stats->BytesSent += (size); } } while (0)
+#define HTTP_STATS_RECEIVED(ctx, size)		do { if ((ctx)->Stats) { (ctx)->Stats->RecvCalls++; (ctx)->Stats->BytesReceived += (size); } } while (0)
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace hooks (see HttpTrace.h). Events above HTTP_TRACE_LEVEL leave no code,
+// arguments are not evaluated either.
+#include <HttpTrace.h>
+#ifndef HTTP_TRACE_LEVEL
+#if defined(HTTPLIB_TRACE_BINARY)
+#define HTTP_TRACE_LEVEL				HTTP_TRACE_LEVEL_DEBUG
+#elif defined(LOGSYS_FLAG)
+#define HTTP_TRACE_LEVEL				HTTP_TRACE_LEVEL_INFO
+#else
+#define HTTP_TRACE_LEVEL				HTTP_TRACE_LEVEL_OFF
+#endif
+#endif	// HTTP_TRACE_LEVEL
+#ifdef HTTPLIB_TRACE_BINARY
+extern void _HttpTraceWrite(const HttpContext*, unsigned int, unsigned int, unsigned int, unsigned int);
+#define HTTP_TRACE(ctx, event, a, b, c)	_HttpTraceWrite((ctx), (event), (unsigned int)(a), (unsigned int)(b), (unsigned int)(c))
+#else
+extern void _HttpTraceText(const HttpContext*, unsigned int, unsigned int, unsigned int, unsigned int);
+#define HTTP_TRACE(ctx, event, a, b, c)	_HttpTraceText((ctx), (event), (unsigned int)(a), (unsigned int)(b), (unsigned int)(c))
+#endif	// HTTPLIB_TRACE_BINARY
+#if HTTP_TRACE_LEVEL >= HTTP_TRACE_LEVEL_ERROR
+#define HTTP_TRACE_ERROR(ctx, event, a, b, c)	HTTP_TRACE(ctx, event, a, b, c)
+#else
+#define HTTP_TRACE_ERROR(ctx, event, a, b, c)	((void)0)
+#endif
+#if HTTP_TRACE_LEVEL >= HTTP_TRACE_LEVEL_INFO
+#define HTTP_TRACE_INFO(ctx, event, a, b, c)	HTTP_TRACE(ctx, event, a, b, c)
+#else
+#define HTTP_TRACE_INFO(ctx, event, a, b, c)	((void)0)
+#endif
+#if HTTP_TRACE_LEVEL >= HTTP_TRACE_LEVEL_DEBUG
+#define HTTP_TRACE_DEBUG(ctx, event, a, b, c)	HTTP_TRACE(ctx, event, a, b, c)
+#else
+#define HTTP_TRACE_DEBUG(ctx, event, a, b, c)	((void)0)
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Response parser results.
+#define HTTP_PARSE_INCOMPLETE			0
+#define HTTP_PARSE_COMPLETE				1
+#define HTTP_PARSE_ERROR				-1
+
+///////////////////////////////////////////////////////////////////////////////
+// This function resets parser to wait for new response.
+extern void _HttpParserReset(HttpContext*);
+
+///////////////////////////////////////////////////////////////////////////////
+// This function parses response header bytes received into DataBuffer since last call.
+// Header must start at DataBuffer's beginning. Parsed values are stored in context
+// (ContentLength, Flags, Parser).
+// Returns: HTTP_PARSE_* value.
+extern int _HttpParseResponse(HttpContext*);
+
+///////////////////////////////////////////////////////////////////////////////
+// These functions allocate and free memory with global memory interface.
+extern void* _HttpGlobalAlloc(size_t);
+extern void _HttpGlobalFree(void*);
+
+///////////////////////////////////////////////////////////////////////////////
+// This function returns transport assigned to context or platform default one.
+extern const HttpTransport* _HttpGetTransport(const HttpContext*);
+
+///////////////////////////////////////////////////////////////////////////////
+// This function receives response header (DataBuffer is created if needed).
+// Returns: non-zero value on error.
+extern int _HttpReceiveHeader(HttpContext*);
+// This function prepares context for next response on the same connection.
+// Unread data in DataBuffer is kept (it is beginning of next response).
+extern void _HttpNextResponse(HttpContext*);
+// This function prepares context for new request. Rest of pending response is
+// skipped (connection is reopened if it had to be closed), response state is reset.
+// Returns: non-zero value on error.
+extern int _HttpPrepareSend(HttpContext*);
+// This function closes connection and opens it again to the same remote host.
+// Returns: non-zero value on error.
+extern int _HttpReconnect(HttpContext*);
+// This function sends segments without resetting context.
+// Returns: non-zero value on error.
+extern int _HttpSendSegments(HttpContext*, const HttpIoVec*, unsigned int);
+// This function checks if serialized request uses HEAD method (response has no body).
+extern int _HttpIsHeadRequest(const void*, unsigned int);
+// This function makes next part of body available at DataBuffer's read cursor.
+// Chunk framing is parsed on the way, body is received straight into DataBuffer
+// (which is grown for big reads up to its limit). Header has to be received.
+// Returns: size of body span at read cursor (0 at response end) or negative value on error.
+extern int _HttpReceiveBodySpan(HttpContext*);
+// This function drops (part of) body span from DataBuffer's read cursor.
+extern void _HttpConsumeBodySpan(HttpContext*, unsigned int);
+
+#endif	// HTTPLIBPRIVATE_H
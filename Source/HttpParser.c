@@ -0,0 +1,373 @@
+#include "HttpLibPrivate.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Parser states.
+typedef enum HttpParserState {
+	// Status line: "HTTP/" literal, version, status code and reason phrase.
+	PARSE_PROTOCOL,
+	PARSE_VERSION_MAJOR,
+	PARSE_VERSION_MINOR,
+	PARSE_STATUS_CODE,
+	PARSE_REASON,
+	// Beginning of header property line (or empty line terminating header).
+	PARSE_LINE_START,
+	// Property name (up to ':').
+	PARSE_NAME,
+	// Property value (up to end of line).
+	PARSE_VALUE,
+	// Header received completely.
+	PARSE_DONE
+} HttpParserState;
+
+///////////////////////////////////////////////////////////////////////////////
+// Lowercase names of properties parser understands (indexed by HttpKnownProperty).
+static const char* KnownProperties[PROPERTY_COUNT] = {
+	"content-length",
+	"transfer-encoding",
+	"connection",
+	"content-encoding"
+};
+
+///////////////////////////////////////////////////////////////////////////////
+static const char ProtocolText[] = "HTTP/";
+static const char ChunkedText[] = "chunked";
+static const char CloseText[] = "close";
+static const char KeepAliveText[] = "keep-alive";
+static const char IdentityText[] = "identity";
+static const char GzipText[] = "gzip";
+static const char LegacyGzipText[] = "x-gzip";
+static const char DeflateText[] = "deflate";
+
+///////////////////////////////////////////////////////////////////////////////
+// Value of Match meaning that value being parsed is not valid (ignored).
+#define MATCH_INVALID					0xFF
+
+///////////////////////////////////////////////////////////////////////////////
+#define IS_DIGIT(c)						((c) >= '0' && (c) <= '9')
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpParserReset(HttpContext* ctx) {
+	memset(&ctx->Parser, 0, sizeof(HttpResponseParser));
+	// Entries are overwritten as they come, only index has to be cleared.
+	memset(ctx->Headers.Index, 0, sizeof(ctx->Headers.Index));
+	ctx->Headers.Count = 0;
+	ctx->Headers.Dropped = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function adds complete property to header table.
+static void _IndexProperty(HttpContext* ctx) {
+	HttpResponseParser* parser = &ctx->Parser;
+	HttpHeaderTable* table = &ctx->Headers;
+	HttpHeaderEntry* entry = NULL;
+	unsigned int slot = 0;
+
+	// Table offsets are 16-bit.
+	if (table->Count >= HTTP_MAX_HEADERS || parser->ValueEnd > 0xFFFF) {
+		table->Dropped++;
+		return;
+	}
+	entry = &table->Entries[table->Count];
+	entry->Hash = parser->NameHash;
+	entry->NameOffset = (unsigned short)parser->LineOffset;
+	entry->NameLength = (unsigned short)parser->NameLength;
+	entry->ValueOffset = (unsigned short)parser->ValueOffset;
+	entry->ValueLength = (unsigned short)(parser->ValueEnd - parser->ValueOffset);
+	// Linear probing, index is always bigger than table so free slot exists.
+	slot = parser->NameHash & (HTTP_HEADER_INDEX_SIZE - 1);
+	while (table->Index[slot] != 0)
+		slot = (slot + 1) & (HTTP_HEADER_INDEX_SIZE - 1);
+	table->Count++;
+	table->Index[slot] = table->Count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function drops known property candidates not matching given name character.
+static void _MatchPropertyName(HttpResponseParser* parser, unsigned char c) {
+	unsigned int candidates = parser->Candidates;
+	unsigned int id = 0;
+
+	c = HTTP_TO_LOWER(c);
+	for (id = 0; candidates != 0; id++, candidates >>= 1) {
+		// Mismatch (also on name's terminator) removes candidate.
+		if ((candidates & 1) && KnownProperties[id][parser->NameLength] != (char)c)
+			parser->Candidates &= ~(1u << id);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function resolves which known property was matched by complete name.
+static unsigned char _ResolvePropertyName(const HttpResponseParser* parser) {
+	unsigned int id = 0;
+
+	for (id = 0; id < PROPERTY_COUNT; id++) {
+		if ((parser->Candidates & (1u << id)) && KnownProperties[id][parser->NameLength] == '\0')
+			return (unsigned char)id;
+	}
+	return PROPERTY_UNKNOWN;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void _BeginValue(HttpContext* ctx) {
+	ctx->Parser.PropertyId = _ResolvePropertyName(&ctx->Parser);
+	ctx->Parser.Match = 0;
+	if (ctx->Parser.PropertyId == PROPERTY_CONTENT_LENGTH)
+		ctx->ContentLength = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function consumes single value character of known property.
+static void _ParseValue(HttpContext* ctx, unsigned char c) {
+	HttpResponseParser* parser = &ctx->Parser;
+
+	if (c == ' ' || c == '\t')
+		return;
+	switch (parser->PropertyId) {
+	case PROPERTY_CONTENT_LENGTH:
+		// Decimal number, on overflow or garbage value is dropped.
+		if (parser->Match == MATCH_INVALID)
+			break;
+		if (IS_DIGIT(c) && ctx->ContentLength <= ((HttpLength_t)-1 - 9) / 10) {
+			ctx->ContentLength = ctx->ContentLength * 10 + (c - '0');
+			// At least one digit.
+			parser->Match = 1;
+		}
+		else {
+			ctx->ContentLength = 0;
+			parser->Match = MATCH_INVALID;
+		}
+		break;
+	case PROPERTY_TRANSFER_ENCODING:
+		// We look for "chunked" as last transfer coding in list.
+		if (c == ',')
+			parser->Match = 0;
+		else if (parser->Match != MATCH_INVALID && parser->Match < sizeof(ChunkedText) - 1 && HTTP_TO_LOWER(c) == ChunkedText[parser->Match])
+			parser->Match++;
+		else
+			parser->Match = MATCH_INVALID;
+		break;
+	default:
+		break;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function compares token with lowercase literal (case-insensitive).
+static int _TokenEquals(const char* token, unsigned int length, const char* literal, unsigned int literalLength) {
+	unsigned int i = 0;
+
+	if (length != literalLength)
+		return 0;
+	for (i = 0; i < length; i++) {
+		if (HTTP_TO_LOWER(token[i]) != literal[i])
+			return 0;
+	}
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function parses Connection property tokens (value is complete in DataBuffer).
+static void _ParseConnection(HttpContext* ctx) {
+	const char* value = ctx->DataBuffer + ctx->Parser.ValueOffset;
+	unsigned int length = ctx->Parser.ValueEnd - ctx->Parser.ValueOffset;
+	unsigned int start = 0;
+	unsigned int end = 0;
+	unsigned int i = 0;
+
+	for (i = 0; i <= length; i++) {
+		if (i < length && value[i] != ',')
+			continue;
+		// Trim token.
+		for (end = i; end > start && (value[end - 1] == ' ' || value[end - 1] == '\t'); end--)
+			;
+		while (start < end && (value[start] == ' ' || value[start] == '\t'))
+			start++;
+		if (_TokenEquals(value + start, end - start, CloseText, sizeof(CloseText) - 1))
+			ctx->Flags |= CONNECTION_CLOSE;
+		else if (_TokenEquals(value + start, end - start, KeepAliveText, sizeof(KeepAliveText) - 1))
+			ctx->Parser.KeepAlive = 1;
+		start = i + 1;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function parses Content-Encoding property tokens (value is complete in DataBuffer).
+// Only single coding is supported, list of codings is taken as unknown one.
+static void _ParseContentEncoding(HttpContext* ctx) {
+	const char* value = ctx->DataBuffer + ctx->Parser.ValueOffset;
+	unsigned int length = ctx->Parser.ValueEnd - ctx->Parser.ValueOffset;
+	unsigned char coding = HTTP_CODING_IDENTITY;
+	unsigned char token = HTTP_CODING_IDENTITY;
+	unsigned int start = 0;
+	unsigned int end = 0;
+	unsigned int i = 0;
+
+	for (i = 0; i <= length; i++) {
+		if (i < length && value[i] != ',')
+			continue;
+		for (end = i; end > start && (value[end - 1] == ' ' || value[end - 1] == '\t'); end--)
+			;
+		while (start < end && (value[start] == ' ' || value[start] == '\t'))
+			start++;
+		if (end == start || _TokenEquals(value + start, end - start, IdentityText, sizeof(IdentityText) - 1))
+			token = HTTP_CODING_IDENTITY;
+		else if (_TokenEquals(value + start, end - start, GzipText, sizeof(GzipText) - 1) ||
+			_TokenEquals(value + start, end - start, LegacyGzipText, sizeof(LegacyGzipText) - 1))
+			token = HTTP_CODING_GZIP;
+		else if (_TokenEquals(value + start, end - start, DeflateText, sizeof(DeflateText) - 1))
+			token = HTTP_CODING_DEFLATE;
+		else
+			token = HTTP_CODING_UNKNOWN;
+		if (token != HTTP_CODING_IDENTITY)
+			coding = (coding == HTTP_CODING_IDENTITY ? token : HTTP_CODING_UNKNOWN);
+		start = i + 1;
+	}
+	ctx->Parser.ContentCoding = coding;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void _EndValue(HttpContext* ctx) {
+	HttpResponseParser* parser = &ctx->Parser;
+
+	if (parser->PropertyId == PROPERTY_CONTENT_LENGTH) {
+		if (parser->Match == 1)
+			ctx->Flags |= CONTENT_LENGTH_KNOWN;
+		else
+			ctx->Flags &= ~CONTENT_LENGTH_KNOWN;
+	}
+	if (parser->PropertyId == PROPERTY_CONNECTION)
+		_ParseConnection(ctx);
+	if (parser->PropertyId == PROPERTY_CONTENT_ENCODING)
+		_ParseContentEncoding(ctx);
+
+	if (parser->PropertyId == PROPERTY_TRANSFER_ENCODING) {
+		if (parser->Match == sizeof(ChunkedText) - 1)
+			ctx->Flags |= TRANSFER_CHUNKED | ENDING_CHUNK_REQUIRED;
+		else
+			ctx->Flags &= ~(TRANSFER_CHUNKED | ENDING_CHUNK_REQUIRED);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpParseResponse(HttpContext* ctx) {
+	HttpResponseParser* parser = &ctx->Parser;
+	const unsigned char* buffer = (const unsigned char*)ctx->DataBuffer;
+	unsigned int position = parser->Position;
+	unsigned char c = 0;
+
+	for (; position < ctx->DataTail; position++) {
+		c = buffer[position];
+		switch (parser->State) {
+		case PARSE_PROTOCOL:
+			if (c != (unsigned char)ProtocolText[parser->Match])
+				return HTTP_PARSE_ERROR;
+			if (++parser->Match == sizeof(ProtocolText) - 1) {
+				parser->State = PARSE_VERSION_MAJOR;
+				parser->Match = 0;
+			}
+			break;
+		case PARSE_VERSION_MAJOR:
+			if (IS_DIGIT(c) && parser->Match < 3) {
+				parser->VersionMajor = parser->VersionMajor * 10 + (c - '0');
+				parser->Match++;
+			}
+			else if (c == '.' && parser->Match > 0) {
+				parser->State = PARSE_VERSION_MINOR;
+				parser->Match = 0;
+			}
+			else
+				return HTTP_PARSE_ERROR;
+			break;
+		case PARSE_VERSION_MINOR:
+			if (IS_DIGIT(c) && parser->Match < 3) {
+				parser->VersionMinor = parser->VersionMinor * 10 + (c - '0');
+				parser->Match++;
+			}
+			else if (c == ' ' && parser->Match > 0) {
+				parser->State = PARSE_STATUS_CODE;
+				parser->Match = 0;
+			}
+			else
+				return HTTP_PARSE_ERROR;
+			break;
+		case PARSE_STATUS_CODE:
+			if (IS_DIGIT(c) && parser->Match < 3) {
+				parser->StatusCode = parser->StatusCode * 10 + (c - '0');
+				parser->Match++;
+			}
+			else if (parser->Match == 3 && (c == ' ' || c == '\r' || c == '\n')) {
+				// Reason phrase is optional.
+				parser->ReasonOffset = position + (c == ' ' ? 1 : 0);
+				parser->State = (c == '\n' ? PARSE_LINE_START : PARSE_REASON);
+			}
+			else
+				return HTTP_PARSE_ERROR;
+			break;
+		case PARSE_REASON:
+			if (c == '\n')
+				parser->State = PARSE_LINE_START;
+			else if (c != '\r')
+				parser->ReasonLength = position + 1 - parser->ReasonOffset;
+			break;
+		case PARSE_LINE_START:
+			// Empty line terminates header.
+			if (c == '\n') {
+				// HTTP/1.0 connection is persistent only on request.
+				if (parser->VersionMajor == 1 && parser->VersionMinor == 0 && !parser->KeepAlive)
+					ctx->Flags |= CONNECTION_CLOSE;
+				parser->State = PARSE_DONE;
+				parser->Position = position + 1;
+				parser->HeaderLength = position + 1;
+				return HTTP_PARSE_COMPLETE;
+			}
+			if (c == '\r')
+				break;
+			// New property, its first character is parsed as a name below.
+			parser->State = PARSE_NAME;
+			parser->Candidates = (1u << PROPERTY_COUNT) - 1;
+			parser->NameLength = 0;
+			parser->NameHash = HTTP_HASH_INIT;
+			parser->LineOffset = position;
+			/* fall through */
+		case PARSE_NAME:
+			if (c == ':') {
+				_BeginValue(ctx);
+				parser->ValueOffset = position + 1;
+				parser->ValueEnd = position + 1;
+				parser->State = PARSE_VALUE;
+			}
+			// Line without colon is ignored.
+			else if (c == '\n')
+				parser->State = PARSE_LINE_START;
+			else if (c != '\r') {
+				_MatchPropertyName(parser, c);
+				parser->NameHash = HTTP_HASH_STEP(parser->NameHash, HTTP_TO_LOWER(c));
+				parser->NameLength++;
+			}
+			break;
+		case PARSE_VALUE:
+			if (c == '\n') {
+				_EndValue(ctx);
+				_IndexProperty(ctx);
+				parser->State = PARSE_LINE_START;
+				break;
+			}
+			if (c == ' ' || c == '\t') {
+				// Leading spaces are not part of value.
+				if (parser->ValueEnd == parser->ValueOffset) {
+					parser->ValueOffset = position + 1;
+					parser->ValueEnd = position + 1;
+				}
+			}
+			else if (c != '\r')
+				parser->ValueEnd = position + 1;
+			if (c != '\r' && parser->PropertyId != PROPERTY_UNKNOWN)
+				_ParseValue(ctx, c);
+			break;
+		default:
+			return HTTP_PARSE_COMPLETE;
+		}
+	}
+	parser->Position = position;
+	return HTTP_PARSE_INCOMPLETE;
+}
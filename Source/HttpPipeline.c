@@ -0,0 +1,144 @@
+#include "HttpLibPrivate.h"
+#include <HttpPipeline.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Methods which can be repeated safely (RFC 7230, 6.3.1).
+static const char* IdempotentMethods[] = {
+	"GET ",
+	"HEAD ",
+	"PUT ",
+	"DELETE ",
+	"OPTIONS ",
+	"TRACE "
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// This function checks if request can be sent again.
+static int _IsIdempotent(const HttpIoVec* request) {
+	unsigned int length = 0;
+	unsigned int i = 0;
+
+	for (i = 0; i < sizeof(IdempotentMethods) / sizeof(IdempotentMethods[0]); i++) {
+		length = strlen(IdempotentMethods[i]);
+		if (request->Size >= length && memcmp(request->Data, IdempotentMethods[i], length) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function reopens connection and sends unanswered requests again.
+// Returns: Non-zero value on error.
+static int _Reconnect(HttpPipeline* pipeline) {
+	HttpContext* ctx = pipeline->Context;
+	unsigned int i = 0;
+	int result = 0;
+
+	if (pipeline->Retries >= pipeline->MaxRetries || ctx->RemoteHost[0] == '\0')
+		return -1;
+	for (i = pipeline->Current; i < pipeline->Sent; i++) {
+		if (!_IsIdempotent(&pipeline->Requests[i]))
+			return -1;
+	}
+	HTTP_TRACE_INFO(ctx, HTTP_EVENT_PIPELINE_RECONNECT, pipeline->Sent - pipeline->Current, 0, 0);
+	pipeline->Retries++;
+	result = _HttpReconnect(ctx);
+	if (result != 0)
+		return result;
+	// Requests not sent yet are flushed as usual.
+	return _HttpSendSegments(ctx, pipeline->Requests + pipeline->Current, pipeline->Sent - pipeline->Current);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpPipelineInit(HttpPipeline* pipeline, HttpContext* ctx) {
+	if (pipeline == NULL || ctx == NULL)
+		return -1;
+	memset(pipeline, 0, sizeof(HttpPipeline));
+	pipeline->Context = ctx;
+	pipeline->MaxRetries = 1;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpPipelineQueue(HttpPipeline* pipeline, const void* request, unsigned int requestSize) {
+	if (pipeline == NULL || request == NULL || requestSize == 0)
+		return -1;
+	if (pipeline->Count >= HTTP_PIPELINE_DEPTH)
+		return -2;
+	pipeline->Requests[pipeline->Count].Data = request;
+	pipeline->Requests[pipeline->Count].Size = requestSize;
+	pipeline->Count++;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpPipelineFlush(HttpPipeline* pipeline) {
+	int result = 0;
+
+	if (pipeline == NULL)
+		return -1;
+	if (pipeline->Sent == pipeline->Count)
+		return 0;
+	HTTP_TRACE_DEBUG(pipeline->Context, HTTP_EVENT_PIPELINE_FLUSH, pipeline->Count, pipeline->Sent, 0);
+	// Nothing was sent on connection yet, previous response can be dropped.
+	if (pipeline->Sent == 0 && pipeline->Current == 0) {
+		result = _HttpPrepareSend(pipeline->Context);
+		if (result != 0)
+			return result;
+	}
+	result = _HttpSendSegments(pipeline->Context, pipeline->Requests + pipeline->Sent, pipeline->Count - pipeline->Sent);
+	if (result == 0) {
+		pipeline->Sent = pipeline->Count;
+		HTTP_STATS_MARK(pipeline->Context, HTTP_PHASE_REQUEST_SENT);
+	}
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpPipelineNext(HttpPipeline* pipeline) {
+	HttpContext* ctx = NULL;
+	int result = 0;
+
+	if (pipeline == NULL)
+		return -1;
+	ctx = pipeline->Context;
+	HTTP_TRACE_DEBUG(ctx, HTTP_EVENT_PIPELINE_NEXT, pipeline->Current + pipeline->Started, pipeline->Count, 0);
+	if (pipeline->Started) {
+		// Skip rest of current response body. Responses behind it can not be dropped, so it is drained whole.
+		result = _HttpSkipBody(ctx, HTTP_SKIP_BODY_ALL);
+		pipeline->Current++;
+		pipeline->Started = 0;
+		// Remote host will not answer on this connection anymore (or connection was lost while draining).
+		if ((result != 0 || (ctx->Flags & CONNECTION_CLOSE)) && pipeline->Current < pipeline->Count) {
+			result = _Reconnect(pipeline);
+			if (result != 0)
+				return -2;
+		}
+		else
+			_HttpNextResponse(ctx);
+	}
+	if (pipeline->Current >= pipeline->Count)
+		return 1;
+	while (1) {
+		result = _HttpPipelineFlush(pipeline);
+		if (result == 0) {
+			if (_HttpIsHeadRequest(pipeline->Requests[pipeline->Current].Data, pipeline->Requests[pipeline->Current].Size))
+				ctx->Flags |= HEAD_REQUEST;
+			result = _HttpReceiveHeader(ctx);
+			if (result == 0)
+				break;
+			// Part of response was received, request can not be repeated.
+			if (ctx->DataTail != 0)
+				return -2;
+		}
+		if (_Reconnect(pipeline) != 0)
+			return -2;
+	}
+	pipeline->Started = 1;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+unsigned int _HttpPipelineCurrent(const HttpPipeline* pipeline) {
+	return pipeline->Current;
+}
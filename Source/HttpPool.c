@@ -0,0 +1,151 @@
+#include "HttpLibPrivate.h"
+#include <HttpPool.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// This function checks if entry's connection goes to given remote host.
+static int _EntryMatches(const HttpPoolEntry* entry, const char* host, unsigned short port, unsigned char ssl) {
+	return (entry->Context.RemotePort == port && entry->Context.RemoteSsl == ssl && strcmp(entry->Context.RemoteHost, host) == 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function closes entry's connection and frees entry.
+static void _CloseEntry(HttpPoolEntry* entry) {
+	_HttpDisconnect(&entry->Context, 1);
+	entry->State = POOL_ENTRY_FREE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function prepares free entry's context for new connection.
+static void _InitEntry(const HttpPool* pool, HttpPoolEntry* entry) {
+	memset(&entry->Context, 0, sizeof(HttpContext));
+	entry->Context.Timeout = pool->Template.Timeout;
+	entry->Context.RecvTimeout = pool->Template.RecvTimeout;
+	entry->Context.ConnectTimeout = pool->Template.ConnectTimeout;
+	entry->Context.DataBufferLimit = pool->Template.DataBufferLimit;
+	entry->Context.MemAlloc = pool->Template.MemAlloc;
+	entry->Context.MemFree = pool->Template.MemFree;
+	entry->Context.BufferPool = pool->Template.BufferPool;
+	_HttpSetTransport(&entry->Context, pool->Template.Transport, pool->Template.TransportData);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpPoolInit(HttpPool* pool, HttpPoolEntry* entries, unsigned int entryCount, const HttpContext* settings) {
+	if (pool == NULL || entries == NULL || entryCount == 0)
+		return -1;
+	memset(pool, 0, sizeof(HttpPool));
+	memset(entries, 0, entryCount * sizeof(HttpPoolEntry));
+	pool->Entries = entries;
+	pool->EntryCount = entryCount;
+	pool->IdleTimeout = HTTP_POOL_IDLE_TIMEOUT;
+	pool->MaxPerHost = HTTP_POOL_MAX_PER_HOST;
+	if (settings)
+		memcpy(&pool->Template, settings, sizeof(HttpContext));
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpPoolPrune(HttpPool* pool) {
+	unsigned long now = HTTP_TICKS();
+	unsigned int i = 0;
+
+	if (pool->IdleTimeout == 0)
+		return;
+	for (i = 0; i < pool->EntryCount; i++) {
+		if (pool->Entries[i].State == POOL_ENTRY_IDLE && now - pool->Entries[i].IdleSince >= pool->IdleTimeout) {
+			_CloseEntry(&pool->Entries[i]);
+			pool->Stats.Expired++;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpPoolAcquire(HttpPool* pool, const char* host, unsigned short port, unsigned char ssl, HttpContext** ctx) {
+	HttpPoolEntry* entry = NULL;
+	HttpPoolEntry* freeEntry = NULL;
+	HttpPoolEntry* oldestIdle = NULL;
+	unsigned long now = 0;
+	unsigned int hostConnections = 0;
+	unsigned int i = 0;
+	int result = 0;
+
+	if (pool == NULL || host == NULL || ctx == NULL || strlen(host) >= HTTP_MAX_HOST_SIZE)
+		return -1;
+	*ctx = NULL;
+	_HttpPoolPrune(pool);
+	now = HTTP_TICKS();
+	for (i = 0; i < pool->EntryCount; i++) {
+		entry = &pool->Entries[i];
+		if (entry->State == POOL_ENTRY_FREE) {
+			if (freeEntry == NULL)
+				freeEntry = entry;
+			continue;
+		}
+		if (!_EntryMatches(entry, host, port, ssl)) {
+			if (entry->State == POOL_ENTRY_IDLE && (oldestIdle == NULL || now - entry->IdleSince > now - oldestIdle->IdleSince))
+				oldestIdle = entry;
+			continue;
+		}
+		if (entry->State == POOL_ENTRY_IDLE) {
+			// Remote host could close idle connection.
+			if (_HttpIsConnected(&entry->Context)) {
+				entry->State = POOL_ENTRY_BUSY;
+				pool->Stats.Hits++;
+				*ctx = &entry->Context;
+				return 0;
+			}
+			_CloseEntry(entry);
+			pool->Stats.Dead++;
+			if (freeEntry == NULL)
+				freeEntry = entry;
+			continue;
+		}
+		hostConnections++;
+	}
+	if (hostConnections >= pool->MaxPerHost)
+		return -2;
+	// Make room by closing connection idle for the longest time.
+	if (freeEntry == NULL) {
+		if (oldestIdle == NULL)
+			return -3;
+		_CloseEntry(oldestIdle);
+		pool->Stats.Evicted++;
+		freeEntry = oldestIdle;
+	}
+	_InitEntry(pool, freeEntry);
+	result = _HttpConnect(host, port, ssl, &freeEntry->Context);
+	if (result != 0) {
+		_CloseEntry(freeEntry);
+		return result;
+	}
+	freeEntry->State = POOL_ENTRY_BUSY;
+	pool->Stats.Misses++;
+	*ctx = &freeEntry->Context;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpPoolRelease(HttpPool* pool, HttpContext* ctx) {
+	HttpPoolEntry* entry = (HttpPoolEntry*)ctx;
+
+	if (pool == NULL || entry < pool->Entries || entry >= pool->Entries + pool->EntryCount || entry->State != POOL_ENTRY_BUSY)
+		return -1;
+	// Connection can be reused only if nothing of response is left on it (small rest is drained).
+	if (_HttpSkipBody(ctx, HTTP_SKIP_BODY_LIMIT) != 0 || (ctx->Flags & CONNECTION_CLOSE) || !_HttpIsConnected(ctx)) {
+		_CloseEntry(entry);
+		pool->Stats.NotReusable++;
+		return 0;
+	}
+	entry->State = POOL_ENTRY_IDLE;
+	entry->IdleSince = HTTP_TICKS();
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpPoolDestroy(HttpPool* pool) {
+	unsigned int i = 0;
+
+	for (i = 0; i < pool->EntryCount; i++) {
+		if (pool->Entries[i].State != POOL_ENTRY_FREE)
+			_CloseEntry(&pool->Entries[i]);
+	}
+}
@@ -0,0 +1,289 @@
+#include "HttpLibPrivate.h"
+
+///////////////////////////////////////////////////////////////////////////////
+static const char* MethodsText[] = {
+	"GET",
+	"HEAD",
+	"POST",
+	"PUT"
+};
+
+///////////////////////////////////////////////////////////////////////////////
+static const char* VersionsText[] = {
+	"1.0",
+	"1.1"
+};
+
+///////////////////////////////////////////////////////////////////////////////
+static const char ContentLengthText[] = "Content-Length";
+
+///////////////////////////////////////////////////////////////////////////////
+// This function writes decimal representation of number (not null-terminated).
+// Returns: Number of characters written (at most 20).
+static unsigned int _FormatNumber(char* text, unsigned long number) {
+	char digits[20];
+	unsigned int count = 0;
+	unsigned int i = 0;
+
+	do {
+		digits[count++] = (char)('0' + number % 10);
+		number /= 10;
+	} while (number != 0);
+	// Digits were produced from least significant one.
+	for (i = 0; i < count; i++)
+		text[i] = digits[count - 1 - i];
+	return count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function replaces removeLength bytes at offset with insertLength bytes of space.
+// Tail of request is moved and offsets behind replaced range are adjusted.
+// Returns: Pointer to space to be filled or NULL if request would not fit in buffer.
+static char* _Splice(HttpRequestBuilder* builder, unsigned int offset, unsigned int removeLength, unsigned int insertLength) {
+	unsigned int tail = offset + removeLength;
+	unsigned int newLength = builder->Length - removeLength + insertLength;
+	unsigned int i = 0;
+
+	// One byte is kept for null-terminator.
+	if (newLength < builder->Length - removeLength || newLength >= builder->Size)
+		return NULL;
+	if (insertLength != removeLength) {
+		memmove(builder->Buffer + offset + insertLength, builder->Buffer + tail, builder->Length - tail);
+		builder->BytesMoved += builder->Length - tail;
+		for (i = 0; i < builder->PropertyCount; i++) {
+			if (builder->PropertyOffsets[i] >= tail)
+				builder->PropertyOffsets[i] = (unsigned short)(builder->PropertyOffsets[i] + insertLength - removeLength);
+		}
+		if (builder->HeaderEnd >= tail)
+			builder->HeaderEnd = builder->HeaderEnd + insertLength - removeLength;
+		if (builder->Complete && builder->BodyOffset >= tail)
+			builder->BodyOffset = builder->BodyOffset + insertLength - removeLength;
+	}
+	builder->Length = newLength;
+	builder->Buffer[newLength] = '\0';
+	return builder->Buffer + offset;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function returns length of property line with given index (including CRLF).
+static unsigned int _PropertyLineLength(const HttpRequestBuilder* builder, unsigned int index) {
+	unsigned int end = (index + 1 < builder->PropertyCount ? builder->PropertyOffsets[index + 1] : builder->HeaderEnd);
+
+	return end - builder->PropertyOffsets[index];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function looks for property with given name (case-insensitive).
+// Returns: Property index or -1 if not found.
+static int _FindProperty(const HttpRequestBuilder* builder, const char* key, unsigned int keyLength) {
+	const char* line = NULL;
+	unsigned int i = 0;
+	unsigned int j = 0;
+
+	for (i = 0; i < builder->PropertyCount; i++) {
+		if (_PropertyLineLength(builder, i) <= keyLength)
+			continue;
+		line = builder->Buffer + builder->PropertyOffsets[i];
+		for (j = 0; j < keyLength && HTTP_TO_LOWER(line[j]) == HTTP_TO_LOWER(key[j]); j++)
+			;
+		if (j == keyLength && line[j] == ':')
+			return (int)i;
+	}
+	return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function makes room for property line of given length.
+// Existing property is replaced in place, new one is appended behind last property.
+// Returns: Pointer to line space or NULL on error.
+static char* _ReservePropertyLine(HttpRequestBuilder* builder, const char* key, unsigned int keyLength, unsigned int lineLength) {
+	unsigned int offset = builder->HeaderEnd;
+	int index = _FindProperty(builder, key, keyLength);
+
+	if (index >= 0)
+		return _Splice(builder, builder->PropertyOffsets[index], _PropertyLineLength(builder, (unsigned int)index), lineLength);
+	// Offsets are 16-bit.
+	if (builder->PropertyCount >= HTTP_MAX_REQUEST_PROPERTIES || offset > 0xFFFF)
+		return NULL;
+	if (_Splice(builder, offset, 0, lineLength) == NULL)
+		return NULL;
+	builder->PropertyOffsets[builder->PropertyCount++] = (unsigned short)offset;
+	return builder->Buffer + offset;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function writes 'Key: Value\r\n' line.
+static int _SetPropertyValue(HttpRequestBuilder* builder, const char* key, const char* value, unsigned int valueLength) {
+	unsigned int keyLength = 0;
+	char* line = NULL;
+
+	if (builder == NULL || builder->Buffer == NULL || key == NULL)
+		return -1;
+	keyLength = strlen(key);
+	line = _ReservePropertyLine(builder, key, keyLength, keyLength + 2 + valueLength + 2);
+	if (line == NULL)
+		return -2;
+	memcpy(line, key, keyLength);
+	line += keyLength;
+	*line++ = ':';
+	*line++ = ' ';
+	memcpy(line, value, valueLength);
+	line += valueLength;
+	*line++ = '\r';
+	*line = '\n';
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpBuilderInit(HttpRequestBuilder* builder, char* buffer, unsigned int size, HttpMethod method, const char* site, HttpVersion version) {
+	const char* methodText = NULL;
+	unsigned int methodLength = 0;
+	unsigned int siteLength = 0;
+	char* position = NULL;
+
+	if (builder == NULL || buffer == NULL || size == 0 || site == NULL)
+		return -1;
+	memset(builder, 0, sizeof(HttpRequestBuilder));
+	builder->Buffer = buffer;
+	builder->Size = size;
+	buffer[0] = '\0';
+	methodText = MethodsText[method];
+	methodLength = strlen(methodText);
+	siteLength = strlen(site);
+	// 'METHOD site HTTP/x.y\r\n'.
+	position = _Splice(builder, 0, 0, methodLength + 1 + siteLength + 6 + 3 + 2);
+	if (position == NULL)
+		return -2;
+	memcpy(position, methodText, methodLength);
+	position += methodLength;
+	*position++ = ' ';
+	memcpy(position, site, siteLength);
+	position += siteLength;
+	memcpy(position, " HTTP/", 6);
+	memcpy(position + 6, VersionsText[version], 3);
+	memcpy(position + 9, "\r\n", 2);
+	builder->HeaderEnd = builder->Length;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpBuilderAttach(HttpRequestBuilder* builder, char* buffer, unsigned int size) {
+	const char* end = NULL;
+	unsigned int lineStart = 0;
+	unsigned int position = 0;
+
+	if (builder == NULL || buffer == NULL || size == 0)
+		return -1;
+	// Request must be null-terminated within buffer.
+	end = (const char*)memchr(buffer, '\0', size);
+	if (end == NULL)
+		return -1;
+	memset(builder, 0, sizeof(HttpRequestBuilder));
+	builder->Buffer = buffer;
+	builder->Size = size;
+	builder->Length = (unsigned int)(end - buffer);
+	// Single pass over lines. First one is request line.
+	for (position = 0; position + 1 < builder->Length; position++) {
+		if (buffer[position] != '\r' || buffer[position + 1] != '\n')
+			continue;
+		if (position == lineStart && lineStart > 0) {
+			builder->Complete = 1;
+			builder->HeaderEnd = lineStart;
+			builder->BodyOffset = lineStart + 2;
+			return 0;
+		}
+		if (lineStart > 0) {
+			if (builder->PropertyCount >= HTTP_MAX_REQUEST_PROPERTIES || lineStart > 0xFFFF)
+				return -2;
+			builder->PropertyOffsets[builder->PropertyCount++] = (unsigned short)lineStart;
+		}
+		position++;
+		lineStart = position + 1;
+	}
+	builder->HeaderEnd = lineStart;
+	// Unterminated last line is terminated, so properties can be appended behind it.
+	if (lineStart < builder->Length) {
+		if (lineStart > 0) {
+			if (builder->PropertyCount >= HTTP_MAX_REQUEST_PROPERTIES || lineStart > 0xFFFF)
+				return -2;
+			builder->PropertyOffsets[builder->PropertyCount++] = (unsigned short)lineStart;
+		}
+		builder->HeaderEnd = builder->Length;
+		if (_Splice(builder, builder->Length, 0, 2) == NULL)
+			return -2;
+		memcpy(builder->Buffer + builder->HeaderEnd, "\r\n", 2);
+		builder->HeaderEnd = builder->Length;
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpBuilderSetProperty(HttpRequestBuilder* builder, const char* key, const char* value) {
+	if (value == NULL)
+		return -1;
+	return _SetPropertyValue(builder, key, value, strlen(value));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpBuilderSetPropertyNumber(HttpRequestBuilder* builder, const char* key, unsigned long value) {
+	char text[20];
+
+	return _SetPropertyValue(builder, key, text, _FormatNumber(text, value));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpBuilderRemoveProperty(HttpRequestBuilder* builder, const char* key) {
+	unsigned int i = 0;
+	int index = 0;
+
+	if (builder == NULL || builder->Buffer == NULL || key == NULL)
+		return -1;
+	index = _FindProperty(builder, key, strlen(key));
+	if (index < 0)
+		return -2;
+	_Splice(builder, builder->PropertyOffsets[index], _PropertyLineLength(builder, (unsigned int)index), 0);
+	for (i = (unsigned int)index; i + 1 < builder->PropertyCount; i++)
+		builder->PropertyOffsets[i] = builder->PropertyOffsets[i + 1];
+	builder->PropertyCount--;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpBuilderComplete(HttpRequestBuilder* builder) {
+	unsigned int headerEnd = 0;
+
+	if (builder == NULL || builder->Buffer == NULL)
+		return -1;
+	if (!builder->Complete) {
+		// Empty line goes behind last property, but next properties still go in front of it.
+		headerEnd = builder->HeaderEnd;
+		if (_Splice(builder, headerEnd, 0, 2) == NULL)
+			return -2;
+		memcpy(builder->Buffer + headerEnd, "\r\n", 2);
+		builder->HeaderEnd = headerEnd;
+		builder->BodyOffset = headerEnd + 2;
+		builder->Complete = 1;
+	}
+	return (int)builder->Length;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpBuilderSetBody(HttpRequestBuilder* builder, const void* body, unsigned int bodySize) {
+	char* position = NULL;
+	int result = 0;
+
+	if (body == NULL && bodySize > 0)
+		return -1;
+	result = _HttpBuilderSetPropertyNumber(builder, ContentLengthText, bodySize);
+	if (result != 0)
+		return result;
+	result = _HttpBuilderComplete(builder);
+	if (result < 0)
+		return result;
+	// Previous body (if any) is replaced.
+	position = _Splice(builder, builder->BodyOffset, builder->Length - builder->BodyOffset, bodySize);
+	if (position == NULL)
+		return -2;
+	memcpy(position, body, bodySize);
+	return (int)builder->Length;
+}
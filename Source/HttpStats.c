@@ -0,0 +1,148 @@
+#include "HttpLibPrivate.h"
+
+///////////////////////////////////////////////////////////////////////////////
+#define PHASE_BIT(phase)				(1u << (phase))
+// Phases cleared when connection (request) starts again.
+#define CONNECTION_PHASES				(PHASE_BIT(HTTP_PHASE_CONNECT_START) | PHASE_BIT(HTTP_PHASE_SESSION) | PHASE_BIT(HTTP_PHASE_CONNECTED))
+#define REQUEST_PHASES					(~CONNECTION_PHASES)
+
+///////////////////////////////////////////////////////////////////////////////
+// This function adds latency sample to aggregator.
+static void _Record(HttpStatsAggregator* aggregator, HttpLatency latency, unsigned long ms) {
+	unsigned int bucket = 0;
+	unsigned long bound = 0;
+
+	// Bucket i holds [2^(i-1), 2^i).
+	for (bound = ms; bound > 0 && bucket < HTTP_STATS_BUCKETS - 1; bound >>= 1)
+		bucket++;
+	aggregator->Histograms[latency][bucket]++;
+	aggregator->Count[latency]++;
+	aggregator->Sum[latency] += ms;
+	if (ms > aggregator->Max[latency])
+		aggregator->Max[latency] = ms;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function records latency between phases if both were marked.
+static void _RecordBetween(HttpStats* stats, HttpLatency latency, HttpPhase from, HttpPhase to) {
+	unsigned long ms = 0;
+
+	if (_HttpStatsPhaseTime(stats, from, to, &ms) == 0)
+		_Record(stats->Aggregator, latency, ms);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function marks phase (first time only, starting phases restart their cycle).
+// Completed connection and response latencies go to aggregator.
+void _HttpStatsMark(HttpContext* ctx, HttpPhase phase) {
+	HttpStats* stats = ctx->Stats;
+
+	if (phase == HTTP_PHASE_CONNECT_START) {
+		stats->Marked &= ~CONNECTION_PHASES;
+		stats->Connects++;
+	}
+	else if (phase == HTTP_PHASE_REQUEST_START) {
+		stats->Marked &= ~REQUEST_PHASES;
+		stats->Requests++;
+	}
+	else if (stats->Marked & PHASE_BIT(phase))
+		return;
+	stats->Timestamps[phase] = HTTP_TICKS();
+	stats->Marked |= PHASE_BIT(phase);
+	if (phase == HTTP_PHASE_BODY)
+		stats->Responses++;
+	if (stats->Aggregator == NULL)
+		return;
+	if (phase == HTTP_PHASE_CONNECTED) {
+		_RecordBetween(stats, HTTP_LATENCY_SESSION, HTTP_PHASE_CONNECT_START, HTTP_PHASE_SESSION);
+		if (stats->Marked & PHASE_BIT(HTTP_PHASE_SESSION))
+			_RecordBetween(stats, HTTP_LATENCY_CONNECT, HTTP_PHASE_SESSION, HTTP_PHASE_CONNECTED);
+		else
+			_RecordBetween(stats, HTTP_LATENCY_CONNECT, HTTP_PHASE_CONNECT_START, HTTP_PHASE_CONNECTED);
+	}
+	else if (phase == HTTP_PHASE_BODY) {
+		_RecordBetween(stats, HTTP_LATENCY_SEND, HTTP_PHASE_REQUEST_START, HTTP_PHASE_REQUEST_SENT);
+		_RecordBetween(stats, HTTP_LATENCY_FIRST_BYTE, HTTP_PHASE_REQUEST_SENT, HTTP_PHASE_FIRST_BYTE);
+		_RecordBetween(stats, HTTP_LATENCY_HEADER, HTTP_PHASE_FIRST_BYTE, HTTP_PHASE_HEADER);
+		_RecordBetween(stats, HTTP_LATENCY_BODY, HTTP_PHASE_HEADER, HTTP_PHASE_BODY);
+		_RecordBetween(stats, HTTP_LATENCY_TOTAL, HTTP_PHASE_REQUEST_START, HTTP_PHASE_BODY);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpStatsInit(HttpStats* stats, HttpStatsAggregator* aggregator) {
+	if (stats == NULL)
+		return -1;
+	memset(stats, 0, sizeof(HttpStats));
+	stats->Aggregator = aggregator;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpSetStats(HttpContext* ctx, HttpStats* stats) {
+	if (ctx == NULL)
+		return -1;
+	ctx->Stats = stats;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpStatsSnapshot(const HttpContext* ctx, HttpStats* snapshot) {
+	if (ctx == NULL || ctx->Stats == NULL || snapshot == NULL)
+		return -1;
+	memcpy(snapshot, ctx->Stats, sizeof(HttpStats));
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpStatsReset(HttpContext* ctx) {
+	if (ctx == NULL || ctx->Stats == NULL)
+		return -1;
+	return _HttpStatsInit(ctx->Stats, ctx->Stats->Aggregator);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpStatsPhaseTime(const HttpStats* stats, HttpPhase from, HttpPhase to, unsigned long* ms) {
+	if (stats == NULL || ms == NULL || from >= HTTP_PHASE_COUNT || to >= HTTP_PHASE_COUNT)
+		return -1;
+	if (!(stats->Marked & PHASE_BIT(from)) || !(stats->Marked & PHASE_BIT(to)))
+		return -1;
+	// Ticks may wrap.
+	*ms = stats->Timestamps[to] - stats->Timestamps[from];
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpStatsAggregatorInit(HttpStatsAggregator* aggregator) {
+	if (aggregator == NULL)
+		return -1;
+	memset(aggregator, 0, sizeof(HttpStatsAggregator));
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+unsigned long _HttpStatsPercentile(const HttpStatsAggregator* aggregator, HttpLatency latency, unsigned int percent) {
+	unsigned long wanted = 0;
+	unsigned long seen = 0;
+	unsigned int bucket = 0;
+
+	if (aggregator == NULL || latency >= HTTP_LATENCY_COUNT || aggregator->Count[latency] == 0)
+		return 0;
+	if (percent > 100)
+		percent = 100;
+	// Rank of sample wanted (rounded up, at least first one).
+	wanted = (unsigned long)(((HttpLength_t)aggregator->Count[latency] * percent + 99) / 100);
+	if (wanted == 0)
+		wanted = 1;
+	for (bucket = 0; bucket < HTTP_STATS_BUCKETS - 1; bucket++) {
+		seen += aggregator->Histograms[latency][bucket];
+		if (seen >= wanted)
+			break;
+	}
+	if (bucket == 0)
+		return 0;
+	// Last bucket has no upper bound, maximum is not exceeded anyway.
+	if (bucket == HTTP_STATS_BUCKETS - 1 || (1ul << bucket) - 1 > aggregator->Max[latency])
+		return aggregator->Max[latency];
+	return (1ul << bucket) - 1;
+}
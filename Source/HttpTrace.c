@@ -0,0 +1,154 @@
+#include "HttpLibPrivate.h"
+#include <stdio.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace clock: microseconds on Linux, millisecond ticks on terminal.
+#ifdef HTTPLIB_POSIX
+#define TRACE_TICK_RATE					1000000u
+#else
+#define TRACE_TICK_RATE					1000u
+#endif	// HTTPLIB_POSIX
+
+///////////////////////////////////////////////////////////////////////////////
+// Context id shown in trace.
+#define TRACE_CONTEXT_ID(ctx)			((unsigned short)(((size_t)(ctx) >> 4) ^ ((size_t)(ctx) >> 20)))
+
+///////////////////////////////////////////////////////////////////////////////
+// Ring buffer.
+static HttpTraceRecord* TraceRecords = NULL;
+static unsigned int TraceMask = 0;
+static volatile unsigned int TraceHead = 0;
+
+#ifdef HTTPLIB_TRACE_BINARY
+
+///////////////////////////////////////////////////////////////////////////////
+// Slot reservation is atomic on Linux, terminal application traces from one thread.
+#ifdef HTTPLIB_POSIX
+#define TRACE_RESERVE(head)				__sync_fetch_and_add((head), 1u)
+static unsigned int _TraceTicks(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned int)((unsigned long long)now.tv_sec * 1000000u + (unsigned long long)now.tv_nsec / 1000u);
+}
+#else
+#define TRACE_RESERVE(head)				((*(head))++)
+#define _TraceTicks()					((unsigned int)read_ticks())
+#endif	// HTTPLIB_POSIX
+
+///////////////////////////////////////////////////////////////////////////////
+// This function writes record into ring (oldest one is overwritten).
+void _HttpTraceWrite(const HttpContext* ctx, unsigned int event, unsigned int a, unsigned int b, unsigned int c) {
+	HttpTraceRecord* record = NULL;
+	unsigned int slot = 0;
+
+	if (TraceRecords == NULL)
+		return;
+	slot = TRACE_RESERVE(&TraceHead);
+	record = &TraceRecords[slot & TraceMask];
+	// Slot is invalid until written completely.
+	record->Sequence = 0;
+	record->Timestamp = _TraceTicks();
+	record->Event = (unsigned short)event;
+	record->Context = TRACE_CONTEXT_ID(ctx);
+	record->Arguments[0] = a;
+	record->Arguments[1] = b;
+	record->Arguments[2] = c;
+	*(volatile unsigned int*)&record->Sequence = slot + 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpTraceInit(HttpTraceRecord* records, unsigned int count) {
+	if (records != NULL && (count == 0 || (count & (count - 1)) != 0))
+		return -1;
+	TraceRecords = NULL;
+	if (records != NULL)
+		memset(records, 0, count * sizeof(HttpTraceRecord));
+	TraceHead = 0;
+	TraceMask = (records != NULL ? count - 1 : 0);
+	TraceRecords = records;
+	return 0;
+}
+
+#else
+
+#ifdef LOGSYS_FLAG
+///////////////////////////////////////////////////////////////////////////////
+// Event formats for text mode.
+#define HTTP_TRACE_FORMAT(id, format) format,
+static const char* const TraceFormats[HTTP_EVENT_COUNT] = {
+	HTTP_TRACE_EVENTS(HTTP_TRACE_FORMAT)
+};
+#undef HTTP_TRACE_FORMAT
+#endif	// LOGSYS_FLAG
+
+///////////////////////////////////////////////////////////////////////////////
+// This function logs formatted event.
+void _HttpTraceText(const HttpContext* ctx, unsigned int event, unsigned int a, unsigned int b, unsigned int c) {
+#ifdef LOGSYS_FLAG
+	char text[128];
+
+	if (event >= HTTP_EVENT_COUNT)
+		return;
+	sprintf(text, TraceFormats[event], a, b, c);
+	LOG_PRINTF(("[%04x] %s", TRACE_CONTEXT_ID(ctx), text));
+#else
+	(void)ctx;
+	(void)event;
+	(void)a;
+	(void)b;
+	(void)c;
+#endif	// LOGSYS_FLAG
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpTraceInit(HttpTraceRecord* records, unsigned int count) {
+	(void)records;
+	(void)count;
+	LOG_PRINTF(("\tLibrary built without HTTPLIB_TRACE_BINARY."));
+	return -1;
+}
+
+#endif	// HTTPLIB_TRACE_BINARY
+
+///////////////////////////////////////////////////////////////////////////////
+int _HttpTraceExport(void* buffer, size_t size) {
+	HttpTraceFileHeader header;
+	HttpTraceRecord* output = NULL;
+	unsigned int head = TraceHead;
+	unsigned int first = 0;
+	unsigned int count = 0;
+	unsigned int i = 0;
+	size_t needed = 0;
+
+	if (TraceRecords == NULL)
+		return -1;
+	// Oldest record still in ring.
+	first = (head > TraceMask + 1 ? head - (TraceMask + 1) : 0);
+	for (i = first; i != head; i++) {
+		if (TraceRecords[i & TraceMask].Sequence == i + 1)
+			count++;
+	}
+	needed = sizeof(header) + count * sizeof(HttpTraceRecord);
+	if (needed > 0x7FFFFFFFu)
+		return -1;
+	if (buffer == NULL)
+		return (int)needed;
+	if (size < needed)
+		return -1;
+	memcpy(header.Magic, HTTP_TRACE_MAGIC, sizeof(header.Magic));
+	header.Version = HTTP_TRACE_VERSION;
+	header.RecordSize = sizeof(HttpTraceRecord);
+	header.RecordCount = count;
+	header.TickRate = TRACE_TICK_RATE;
+	memcpy(buffer, &header, sizeof(header));
+	output = (HttpTraceRecord*)((char*)buffer + sizeof(header));
+	for (i = first; i != head && count > 0; i++) {
+		if (TraceRecords[i & TraceMask].Sequence != i + 1)
+			continue;
+		memcpy(output++, &TraceRecords[i & TraceMask], sizeof(HttpTraceRecord));
+		count--;
+	}
+	return (int)needed;
+}
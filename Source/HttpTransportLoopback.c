@@ -0,0 +1,147 @@
+#include "HttpLibPrivate.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Loopback state is kept as transport data of context.
+#define LOOPBACK(ctx) ((HttpLoopback*)(ctx)->TransportData)
+
+///////////////////////////////////////////////////////////////////////////////
+static int _LoopbackConnect(HttpContext* ctx, const char* url, unsigned short port, unsigned char ssl) {
+	(void)url;
+	(void)port;
+	(void)ssl;
+	if (LOOPBACK(ctx) == NULL)
+		return HTTP_TRANSPORT_ERROR;
+	LOOPBACK(ctx)->Connected = 1;
+	return HTTP_TRANSPORT_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _LoopbackDisconnect(HttpContext* ctx, unsigned char force) {
+	(void)force;
+	if (LOOPBACK(ctx) != NULL)
+		LOOPBACK(ctx)->Connected = 0;
+	return HTTP_TRANSPORT_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function captures sent data.
+static void _LoopbackCapture(HttpLoopback* loopback, const void* data, size_t size) {
+	size_t toCapture = 0;
+
+	// Capture as much as fits in sent buffer.
+	if (loopback->SentBuffer && loopback->SentSize < loopback->SentBufferSize) {
+		toCapture = loopback->SentBufferSize - loopback->SentSize;
+		toCapture = (toCapture > size ? size : toCapture);
+		memcpy(loopback->SentBuffer + loopback->SentSize, data, toCapture);
+	}
+	loopback->SentSize += size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _LoopbackSend(HttpContext* ctx, const void* data, size_t size) {
+	HttpLoopback* loopback = LOOPBACK(ctx);
+
+	if (loopback == NULL || !loopback->Connected)
+		return HTTP_TRANSPORT_CLOSED;
+	loopback->SendCalls++;
+	_LoopbackCapture(loopback, data, size);
+	return HTTP_TRANSPORT_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _LoopbackSendv(HttpContext* ctx, const HttpIoVec* vectors, size_t count) {
+	HttpLoopback* loopback = LOOPBACK(ctx);
+	size_t i = 0;
+
+	if (loopback == NULL || !loopback->Connected)
+		return HTTP_TRANSPORT_CLOSED;
+	// Single call, like writev.
+	loopback->SendCalls++;
+	for (i = 0; i < count; i++)
+		_LoopbackCapture(loopback, vectors[i].Data, vectors[i].Size);
+	return HTTP_TRANSPORT_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _LoopbackSendSome(HttpContext* ctx, const void* data, size_t size, size_t* sent) {
+	int result = _LoopbackSend(ctx, data, size);
+
+	*sent = (result == HTTP_TRANSPORT_OK ? size : 0);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _LoopbackRecv(HttpContext* ctx, void* buffer, size_t size, size_t* received) {
+	HttpLoopback* loopback = LOOPBACK(ctx);
+	size_t toCopy = 0;
+
+	*received = 0;
+	if (loopback == NULL || !loopback->Connected)
+		return HTTP_TRANSPORT_CLOSED;
+	loopback->RecvCalls++;
+	// End of script.
+	if (loopback->Position >= loopback->ScriptSize) {
+		if (!(loopback->Flags & HTTP_LOOPBACK_REPEAT) || loopback->RepeatOffset >= loopback->ScriptSize)
+			return HTTP_TRANSPORT_CLOSED;
+		loopback->Position = loopback->RepeatOffset;
+	}
+	// Start next segment.
+	if (loopback->Segments && loopback->SegmentLeft == 0) {
+		loopback->SegmentLeft = loopback->Segments[loopback->SegmentIndex];
+		loopback->SegmentIndex = (loopback->SegmentIndex + 1) % loopback->SegmentCount;
+	}
+	toCopy = loopback->ScriptSize - loopback->Position;
+	toCopy = (toCopy > size ? size : toCopy);
+	if (loopback->Segments) {
+		toCopy = (toCopy > loopback->SegmentLeft ? loopback->SegmentLeft : toCopy);
+		loopback->SegmentLeft -= toCopy;
+		// Zero-sized segment simulates receive timeout.
+		if (toCopy == 0 && size > 0)
+			return HTTP_TRANSPORT_TIMEOUT;
+	}
+	memcpy(buffer, loopback->Script + loopback->Position, toCopy);
+	loopback->Position += toCopy;
+	*received = toCopy;
+	return HTTP_TRANSPORT_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _LoopbackIsConnected(const HttpContext* ctx) {
+	return (LOOPBACK(ctx) != NULL && LOOPBACK(ctx)->Connected);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static const HttpTransport LoopbackTransport = {
+	_LoopbackConnect,
+	_LoopbackDisconnect,
+	_LoopbackSend,
+	_LoopbackRecv,
+	_LoopbackIsConnected,
+	_LoopbackSendv,
+	_LoopbackSendSome
+};
+
+///////////////////////////////////////////////////////////////////////////////
+const HttpTransport* _HttpGetLoopbackTransport(void) {
+	return &LoopbackTransport;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpLoopbackInit(HttpLoopback* loopback, const void* script, size_t scriptSize, const size_t* segments, size_t segmentCount) {
+	memset(loopback, 0, sizeof(HttpLoopback));
+	loopback->Script = (const char*)script;
+	loopback->ScriptSize = scriptSize;
+	// Segmentation pattern is used only if it is not empty.
+	if (segments && segmentCount > 0) {
+		loopback->Segments = segments;
+		loopback->SegmentCount = segmentCount;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void _HttpLoopbackRewind(HttpLoopback* loopback) {
+	loopback->Position = 0;
+	loopback->SegmentIndex = 0;
+	loopback->SegmentLeft = 0;
+	loopback->SentSize = 0;
+}
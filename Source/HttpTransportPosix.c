@@ -0,0 +1,307 @@
+#include "HttpLibPrivate.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Maximum number of segments passed to single sendmsg call.
+#define POSIX_MAX_IOV					16
+
+///////////////////////////////////////////////////////////////////////////////
+// This function waits for socket events. Timeout is given in miliseconds.
+// Returns: HTTP_TRANSPORT_OK when socket is ready.
+static int _PosixWait(int socketFd, short events, int timeout) {
+	struct pollfd pollFd;
+	int result = 0;
+
+	pollFd.fd = socketFd;
+	pollFd.events = events;
+	pollFd.revents = 0;
+	do {
+		result = poll(&pollFd, 1, (timeout > 0 ? timeout : -1));
+	} while (result < 0 && errno == EINTR);
+	if (result == 0)
+		return HTTP_TRANSPORT_TIMEOUT;
+	if (result < 0)
+		return HTTP_TRANSPORT_ERROR;
+	return HTTP_TRANSPORT_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function connects given socket using connect timeout.
+static int _PosixConnectSocket(int socketFd, const struct addrinfo* address, int timeout) {
+	int flags = 0;
+	int socketError = 0;
+	socklen_t socketErrorSize = sizeof(socketError);
+	int result = HTTP_TRANSPORT_OK;
+
+	// Connect in non-blocking mode, so we can apply timeout.
+	flags = fcntl(socketFd, F_GETFL, 0);
+	fcntl(socketFd, F_SETFL, flags | O_NONBLOCK);
+	if (connect(socketFd, address->ai_addr, address->ai_addrlen) != 0) {
+		if (errno != EINPROGRESS)
+			result = HTTP_TRANSPORT_ERROR;
+		else {
+			result = _PosixWait(socketFd, POLLOUT, timeout);
+			if (result == HTTP_TRANSPORT_OK) {
+				getsockopt(socketFd, SOL_SOCKET, SO_ERROR, &socketError, &socketErrorSize);
+				if (socketError != 0)
+					result = HTTP_TRANSPORT_ERROR;
+			}
+		}
+	}
+	// Back to blocking mode.
+	fcntl(socketFd, F_SETFL, flags);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function finishes non-blocking connect started by _PosixConnect.
+static int _PosixFinishConnect(HttpContext* ctx) {
+	struct pollfd pollFd;
+	int socketError = 0;
+	socklen_t socketErrorSize = sizeof(socketError);
+
+	pollFd.fd = ctx->Socket;
+	pollFd.events = POLLOUT;
+	pollFd.revents = 0;
+	if (poll(&pollFd, 1, 0) == 0)
+		return HTTP_TRANSPORT_WOULD_BLOCK;
+	getsockopt(ctx->Socket, SOL_SOCKET, SO_ERROR, &socketError, &socketErrorSize);
+	if (socketError != 0) {
+		close(ctx->Socket);
+		ctx->Socket = -1;
+		return HTTP_TRANSPORT_ERROR;
+	}
+	// Socket stays in blocking mode, non-blocking calls use MSG_DONTWAIT.
+	fcntl(ctx->Socket, F_SETFL, fcntl(ctx->Socket, F_GETFL, 0) & ~O_NONBLOCK);
+	return HTTP_TRANSPORT_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// This function starts non-blocking connect to first resolved address.
+static int _PosixStartConnect(HttpContext* ctx, const struct addrinfo* address) {
+	int socketFd = -1;
+	int noDelay = 1;
+
+	socketFd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+	if (socketFd < 0)
+		return HTTP_TRANSPORT_ERROR;
+	setsockopt(socketFd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+	fcntl(socketFd, F_SETFL, fcntl(socketFd, F_GETFL, 0) | O_NONBLOCK);
+	ctx->Socket = socketFd;
+	if (connect(socketFd, address->ai_addr, address->ai_addrlen) == 0)
+		return _PosixFinishConnect(ctx);
+	if (errno == EINPROGRESS)
+		return HTTP_TRANSPORT_WOULD_BLOCK;
+	close(socketFd);
+	ctx->Socket = -1;
+	return HTTP_TRANSPORT_ERROR;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _PosixConnect(HttpContext* ctx, const char* url, unsigned short port, unsigned char ssl) {
+	struct addrinfo hints;
+	struct addrinfo* addresses = NULL;
+	struct addrinfo* address = NULL;
+	char portText[8] = { 0 };
+	int socketFd = -1;
+	int noDelay = 1;
+	int result = HTTP_TRANSPORT_ERROR;
+
+	// There is no TLS stack in Linux build.
+	if (ssl)
+		return HTTP_TRANSPORT_UNSUPPORTED;
+	if (ctx->Flags & CONNECTING)
+		return _PosixFinishConnect(ctx);
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	sprintf(portText, "%u", (unsigned int)port);
+	if (getaddrinfo(url, portText, &hints, &addresses) != 0)
+		return HTTP_TRANSPORT_ERROR;
+	// Name resolution still blocks, use numeric address to avoid it.
+	if (ctx->NonBlocking) {
+		result = _PosixStartConnect(ctx, addresses);
+		freeaddrinfo(addresses);
+		return result;
+	}
+	// Try all resolved addresses.
+	for (address = addresses; address != NULL; address = address->ai_next) {
+		socketFd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if (socketFd < 0)
+			continue;
+		result = _PosixConnectSocket(socketFd, address, ctx->ConnectTimeout);
+		if (result == HTTP_TRANSPORT_OK)
+			break;
+		close(socketFd);
+		socketFd = -1;
+	}
+	freeaddrinfo(addresses);
+	if (socketFd < 0)
+		return result;
+	// Requests are written in few big writes, do not delay them.
+	setsockopt(socketFd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+	ctx->Socket = socketFd;
+	return HTTP_TRANSPORT_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _PosixDisconnect(HttpContext* ctx, unsigned char force) {
+	int result = 0;
+
+	(void)force;
+	// Socket descriptor is valid only while connected (zeroed context holds 0).
+	if ((ctx->Flags & (CONNECTED | CONNECTING)) && ctx->Socket >= 0)
+		result = close(ctx->Socket);
+	ctx->Socket = -1;
+	return (result == 0 ? HTTP_TRANSPORT_OK : HTTP_TRANSPORT_ERROR);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _PosixSend(HttpContext* ctx, const void* data, size_t size) {
+	const char* position = (const char*)data;
+	ssize_t sent = 0;
+
+	while (size > 0) {
+		sent = send(ctx->Socket, position, size, MSG_NOSIGNAL);
+		if (sent < 0) {
+			if (errno == EINTR)
+				continue;
+			return (errno == EPIPE || errno == ECONNRESET ? HTTP_TRANSPORT_CLOSED : HTTP_TRANSPORT_ERROR);
+		}
+		position += sent;
+		size -= (size_t)sent;
+	}
+	return HTTP_TRANSPORT_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _PosixSendSome(HttpContext* ctx, const void* data, size_t size, size_t* sent) {
+	ssize_t result = 0;
+
+	*sent = 0;
+	do {
+		result = send(ctx->Socket, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+	} while (result < 0 && errno == EINTR);
+	if (result < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			return HTTP_TRANSPORT_WOULD_BLOCK;
+		return (errno == EPIPE || errno == ECONNRESET ? HTTP_TRANSPORT_CLOSED : HTTP_TRANSPORT_ERROR);
+	}
+	*sent = (size_t)result;
+	return HTTP_TRANSPORT_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _PosixSendv(HttpContext* ctx, const HttpIoVec* vectors, size_t count) {
+	struct iovec iov[POSIX_MAX_IOV];
+	struct msghdr message;
+	size_t index = 0;
+	// Bytes of vectors[index] already sent.
+	size_t offset = 0;
+	size_t left = 0;
+	size_t i = 0;
+	ssize_t sent = 0;
+
+	while (1) {
+		// Skip segments sent completely (and empty ones).
+		while (index < count && offset == vectors[index].Size) {
+			index++;
+			offset = 0;
+		}
+		if (index == count)
+			return HTTP_TRANSPORT_OK;
+		memset(&message, 0, sizeof(message));
+		for (i = index; i < count && message.msg_iovlen < POSIX_MAX_IOV; i++) {
+			iov[message.msg_iovlen].iov_base = (char*)vectors[i].Data + (i == index ? offset : 0);
+			iov[message.msg_iovlen].iov_len = vectors[i].Size - (i == index ? offset : 0);
+			message.msg_iovlen++;
+		}
+		message.msg_iov = iov;
+		sent = sendmsg(ctx->Socket, &message, MSG_NOSIGNAL);
+		if (sent < 0) {
+			if (errno == EINTR)
+				continue;
+			return (errno == EPIPE || errno == ECONNRESET ? HTTP_TRANSPORT_CLOSED : HTTP_TRANSPORT_ERROR);
+		}
+		// Partial write, advance over sent bytes.
+		while (sent > 0) {
+			left = vectors[index].Size - offset;
+			if ((size_t)sent < left) {
+				offset += (size_t)sent;
+				break;
+			}
+			sent -= (ssize_t)left;
+			index++;
+			offset = 0;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _PosixRecv(HttpContext* ctx, void* buffer, size_t size, size_t* received) {
+	ssize_t result = 0;
+	int waitResult = 0;
+
+	*received = 0;
+	// RecvTimeout is given in seconds.
+	if (!ctx->NonBlocking) {
+		waitResult = _PosixWait(ctx->Socket, POLLIN, ctx->RecvTimeout * 1000);
+		if (waitResult != HTTP_TRANSPORT_OK)
+			return waitResult;
+	}
+	do {
+		result = recv(ctx->Socket, buffer, size, (ctx->NonBlocking ? MSG_DONTWAIT : 0));
+	} while (result < 0 && errno == EINTR);
+	if (result < 0)
+		return (errno == EAGAIN || errno == EWOULDBLOCK ? HTTP_TRANSPORT_WOULD_BLOCK : HTTP_TRANSPORT_ERROR);
+	if (result == 0)
+		return HTTP_TRANSPORT_CLOSED;
+	*received = (size_t)result;
+	return HTTP_TRANSPORT_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _PosixIsConnected(const HttpContext* ctx) {
+	struct pollfd pollFd;
+	char probe = 0;
+
+	if (!(ctx->Flags & CONNECTED) || ctx->Socket < 0)
+		return 0;
+	pollFd.fd = ctx->Socket;
+	pollFd.events = POLLIN;
+	pollFd.revents = 0;
+	if (poll(&pollFd, 1, 0) < 0)
+		return 0;
+	if (pollFd.revents & (POLLERR | POLLHUP | POLLNVAL))
+		return 0;
+	// Readable socket with no data pending means remote host closed connection.
+	if ((pollFd.revents & POLLIN) && recv(ctx->Socket, &probe, 1, MSG_PEEK | MSG_DONTWAIT) == 0)
+		return 0;
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static const HttpTransport PosixTransport = {
+	_PosixConnect,
+	_PosixDisconnect,
+	_PosixSend,
+	_PosixRecv,
+	_PosixIsConnected,
+	_PosixSendv,
+	_PosixSendSome
+};
+
+///////////////////////////////////////////////////////////////////////////////
+const HttpTransport* _HttpGetPosixTransport(void) {
+	return &PosixTransport;
+}
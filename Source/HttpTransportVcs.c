@@ -0,0 +1,97 @@
+#include "HttpLibPrivate.h"
+#include <VCSLib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Maximum number of bytes VCS_RecieveRawData can handle in single call.
+#define VCS_MAX_RECV_SIZE				0xFFFF
+
+///////////////////////////////////////////////////////////////////////////////
+static int _VcsConnect(HttpContext* ctx, const char* url, unsigned short port, unsigned char ssl) {
+	// Result buffer.
+	int result = 0;
+
+	// Intialize session with VCS.
+	result = VCS_InitializeSession(&ctx->VCSSessionHandle, ctx->Timeout);
+	// Check for error.
+	if (result != 0)
+		return result;
+	HTTP_STATS_MARK(ctx, HTTP_PHASE_SESSION);
+	// Connect to remote host.
+	return VCS_Connect(ctx->VCSSessionHandle, url, port, ssl, ctx->ConnectTimeout);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _VcsDisconnect(HttpContext* ctx, unsigned char force) {
+	// Result buffer.
+	int result = 0;
+
+	// Disconnect from remote host.
+	result = VCS_Disconnect(ctx->VCSSessionHandle, ctx->Timeout);
+	if (!force && result != 0)
+		return result;
+	// End session with VCS.
+	result = VCS_DropSession(&ctx->VCSSessionHandle, ctx->Timeout);
+	if (!force && result != 0)
+		return result;
+	// Return success.
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _VcsSend(HttpContext* ctx, const void* data, size_t size) {
+	return VCS_TransmitRawData(ctx->VCSSessionHandle, data, (int)size, ctx->Timeout);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _VcsRecv(HttpContext* ctx, void* buffer, size_t size, size_t* received) {
+	// Result buffer.
+	int result = 0;
+	// VCS operates on 16-bit sizes.
+	unsigned short dataReceived = 0;
+
+	result = VCS_RecieveRawData(
+		ctx->VCSSessionHandle,
+		(unsigned char*)buffer,
+		(unsigned short)(size > VCS_MAX_RECV_SIZE ? VCS_MAX_RECV_SIZE : size),
+		&dataReceived,
+		ctx->RecvTimeout
+	);
+	*received = dataReceived;
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static int _VcsIsConnected(const HttpContext* ctx) {
+	unsigned short socketStatus = 0;
+	int result = 0;
+
+	// Check if session handle is correct.
+	if (ctx->VCSSessionHandle < 15) {
+		result = VCS_GetSocketStatus(ctx->VCSSessionHandle, &socketStatus, ctx->Timeout);
+		// Check for error.
+		if (result != 0)
+			return 0;
+		// If there was no error, we return actual socket status.
+		return (int)socketStatus;
+	}
+	// Invalid handle.
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static const HttpTransport VcsTransport = {
+	_VcsConnect,
+	_VcsDisconnect,
+	_VcsSend,
+	_VcsRecv,
+	_VcsIsConnected,
+	// VCS has no vectored transmit, library coalesces segments.
+	NULL,
+	// VCS calls always wait.
+	NULL
+};
+
+///////////////////////////////////////////////////////////////////////////////
+const HttpTransport* _HttpGetVcsTransport(void) {
+	return &VcsTransport;
+}
@@ -0,0 +1,86 @@
+/*
+	Binary trace decoder.
+	Prints records of trace file written from _HttpTraceExport buffer:
+	time since first record (ms), context id, event name and formatted arguments.
+	Gaps in record numbers (ring overwritten meanwhile) are reported.
+	Usage: HttpTraceDecode <trace file>
+*/
+#include <HttpTrace.h>
+#include <stdio.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Event names and formats.
+#define TRACE_NAME(id, format) #id,
+static const char* const _names[HTTP_EVENT_COUNT] = {
+	HTTP_TRACE_EVENTS(TRACE_NAME)
+};
+#undef TRACE_NAME
+#define TRACE_FORMAT(id, format) format,
+static const char* const _formats[HTTP_EVENT_COUNT] = {
+	HTTP_TRACE_EVENTS(TRACE_FORMAT)
+};
+#undef TRACE_FORMAT
+
+///////////////////////////////////////////////////////////////////////////////
+// This function prints single record.
+static void _PrintRecord(const HttpTraceRecord* record, unsigned int start, unsigned int tickRate) {
+	// Ticks may wrap.
+	double ms = (double)(record->Timestamp - start) * 1000.0 / tickRate;
+
+	printf("%12.3f [%04x] ", ms, record->Context);
+	if (record->Event >= HTTP_EVENT_COUNT) {
+		printf("unknown event %u (%u %u %u)\n", record->Event, record->Arguments[0], record->Arguments[1], record->Arguments[2]);
+		return;
+	}
+	// Event names share prefix.
+	printf("%-22s ", _names[record->Event] + sizeof("HTTP_EVENT_") - 1);
+	printf(_formats[record->Event], record->Arguments[0], record->Arguments[1], record->Arguments[2]);
+	printf("\n");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv) {
+	HttpTraceFileHeader header;
+	HttpTraceRecord record;
+	unsigned int start = 0;
+	unsigned int expected = 0;
+	unsigned int i = 0;
+	FILE* file = NULL;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <trace file>\n", argv[0]);
+		return 2;
+	}
+	file = fopen(argv[1], "rb");
+	if (file == NULL) {
+		fprintf(stderr, "Cannot open %s.\n", argv[1]);
+		return 1;
+	}
+	if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.Magic, HTTP_TRACE_MAGIC, sizeof(header.Magic)) != 0) {
+		fprintf(stderr, "Not a trace file.\n");
+		fclose(file);
+		return 1;
+	}
+	if (header.Version != HTTP_TRACE_VERSION || header.RecordSize != sizeof(HttpTraceRecord) || header.TickRate == 0) {
+		fprintf(stderr, "Unsupported trace version %u (record size %u).\n", header.Version, header.RecordSize);
+		fclose(file);
+		return 1;
+	}
+	printf("%u records, %u ticks per second\n", header.RecordCount, header.TickRate);
+	for (i = 0; i < header.RecordCount; i++) {
+		if (fread(&record, sizeof(record), 1, file) != 1) {
+			fprintf(stderr, "Trace truncated after %u records.\n", i);
+			fclose(file);
+			return 1;
+		}
+		if (i == 0)
+			start = record.Timestamp;
+		else if (record.Sequence != expected)
+			printf("-- %u records lost\n", record.Sequence - expected);
+		expected = record.Sequence + 1;
+		_PrintRecord(&record, start, header.TickRate);
+	}
+	fclose(file);
+	return 0;
+}